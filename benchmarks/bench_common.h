@@ -0,0 +1,64 @@
+#pragma once
+#include "common/types.h"
+#include "market_data/synthetic_feed.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace pascal {
+    namespace bench {
+        //Cores for cross-thread benchmarks, PASCAL_BENCH_CORES="2,3" overrides the default of 0 and 1
+        inline std::vector<int> bench_cores() {
+            std::vector<int> cores = {0, 1};
+            if (const char* env = std::getenv("PASCAL_BENCH_CORES")) {
+                cores.clear();
+                std::string list(env);
+                size_t start = 0;
+                while (start < list.size()) {
+                    size_t end = list.find(',', start);
+                    if (end == std::string::npos) end = list.size();
+                    cores.push_back(std::stoi(list.substr(start, end-start)));
+                    start = end+1;
+                }
+                while (cores.size() < 2) cores.push_back(cores.empty() ? 0 : cores.back()+1);
+            }
+            return cores;
+        }
+        inline void pin_to_core(std::thread& thread, int core_id) {
+#ifdef __linux__
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(core_id, &cpuset);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuset);
+#endif
+        }
+        inline void pin_current_to_core(int core_id) {
+#ifdef __linux__
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(core_id, &cpuset);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#endif
+        }
+
+        //Book of depth levels per side around a fixed mid, one tick apart
+        inline pascal::common::MarketDataSnapshot make_snapshot(pascal::common::SymbolId id, int64_t mid, int depth) {
+            return pascal::market_data::SyntheticFeed(id, mid, depth).snapshot();
+        }
+
+        //Increment stream starting from make_snapshot(mid, depth), 2 entries per message, see SyntheticFeed
+        inline std::vector<pascal::common::MarketDataIncrement> make_increments(pascal::common::SymbolId id, int64_t mid, int depth, size_t count, uint32_t seed = 42) {
+            pascal::market_data::SyntheticFeed feed(id, mid, depth, pascal::market_data::DepthProfile::GEOMETRIC, seed);
+            std::vector<pascal::common::MarketDataIncrement> updates(count);
+            for (auto& update : updates) feed.next_increment(update, 2);
+            return updates;
+        }
+    };
+};
@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.h"
+#include "market_data/fix_order_book.h"
+#include "market_data/fix_ladder_order_book.h"
+#include <array>
+#include <memory>
+
+namespace pascal {
+    namespace bench {
+        namespace {
+            constexpr int64_t MID = 5000000; //50000.00 at a 0.01 tick
+            constexpr size_t STREAM_LENGTH = 1 << 16;
+
+            std::unique_ptr<pascal::market_data::OrderBook> make_book(pascal::market_data::BookType type) {
+                auto spec = pascal::common::InstrumentSpec::from_increments(0.01, 0.00001);
+                if (type == pascal::market_data::BookType::LADDER) return std::make_unique<pascal::market_data::FIXLadderOrderBook>("BENCHBOOK", spec);
+                return std::make_unique<pascal::market_data::FIXOrderBook>("BENCHBOOK", spec);
+            }
+
+            //Applies a valid increment stream, the book is rebuilt from the snapshot (untimed) when the stream runs out
+            void BM_UpdateFromIncrement(benchmark::State& state, pascal::market_data::BookType type) {
+                int depth = static_cast<int>(state.range(0));
+                auto book = make_book(type);
+                auto snapshot = make_snapshot(book->get_symbol_id(), MID, depth);
+                auto updates = make_increments(book->get_symbol_id(), MID, depth, STREAM_LENGTH);
+                auto reset = [&]() {
+                    auto copy = snapshot;
+                    book->initialize_from_snapshot(copy);
+                };
+                reset();
+                size_t next = 0;
+                for (auto _ : state) {
+                    if (next == updates.size()) {
+                        state.PauseTiming();
+                        reset();
+                        next = 0;
+                        state.ResumeTiming();
+                    }
+                    book->update_from_increment(updates[next++]);
+                }
+                benchmark::DoNotOptimize(book->get_best_bid());
+                state.SetItemsProcessed(state.iterations());
+                state.counters["depth"] = depth;
+            }
+            void BM_InitializeFromSnapshot(benchmark::State& state, pascal::market_data::BookType type) {
+                int depth = static_cast<int>(state.range(0));
+                auto book = make_book(type);
+                auto snapshot = make_snapshot(book->get_symbol_id(), MID, depth);
+                for (auto _ : state) {
+                    book->initialize_from_snapshot(snapshot);
+                }
+                state.SetItemsProcessed(state.iterations());
+            }
+            //Seqlocked reader side, uncontended
+            void BM_ReadTopOfBook(benchmark::State& state, pascal::market_data::BookType type) {
+                auto book = make_book(type);
+                auto snapshot = make_snapshot(book->get_symbol_id(), MID, 100);
+                book->initialize_from_snapshot(snapshot);
+                std::array<pascal::common::PriceLevel, 10> depth;
+                for (auto _ : state) {
+                    benchmark::DoNotOptimize(book->get_best_bid());
+                    benchmark::DoNotOptimize(book->get_best_ask());
+                    benchmark::DoNotOptimize(book->get_bids(depth));
+                }
+                state.SetItemsProcessed(state.iterations());
+            }
+        }
+
+        BENCHMARK_CAPTURE(BM_UpdateFromIncrement, vector, pascal::market_data::BookType::VECTOR)->Arg(20)->Arg(100)->Arg(1000);
+        BENCHMARK_CAPTURE(BM_UpdateFromIncrement, ladder, pascal::market_data::BookType::LADDER)->Arg(20)->Arg(100)->Arg(1000);
+        BENCHMARK_CAPTURE(BM_InitializeFromSnapshot, vector, pascal::market_data::BookType::VECTOR)->Arg(20)->Arg(1000);
+        BENCHMARK_CAPTURE(BM_InitializeFromSnapshot, ladder, pascal::market_data::BookType::LADDER)->Arg(20)->Arg(1000);
+        BENCHMARK_CAPTURE(BM_ReadTopOfBook, vector, pascal::market_data::BookType::VECTOR);
+        BENCHMARK_CAPTURE(BM_ReadTopOfBook, ladder, pascal::market_data::BookType::LADDER);
+    };
+};
+
+BENCHMARK_MAIN();
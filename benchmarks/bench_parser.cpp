@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+#include "net/fix_parser.h"
+#include "quickfix/fix44/MarketDataIncrementalRefresh.h"
+#include "quickfix/fix44/MarketDataSnapshotFullRefresh.h"
+#include <chrono>
+#include <string>
+
+namespace pascal {
+    namespace bench {
+        namespace {
+            //Keeps the decoded events alive without doing any work on them
+            struct NullSink {
+                void on_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
+                    benchmark::DoNotOptimize(snapshot.bids.data());
+                }
+                void on_increment(const pascal::common::MarketDataIncrement& update) {
+                    benchmark::DoNotOptimize(update.md_entries.data());
+                }
+            };
+            using BenchParser = pascal::market_data::BasicFIXMarketDataParser<NullSink>;
+
+            //Depth levels per side around 50000
+            FIX44::MarketDataSnapshotFullRefresh make_snapshot(int depth) {
+                FIX44::MarketDataSnapshotFullRefresh message;
+                message.setField(FIX::Symbol("BTCUSDT"));
+                for (int side = 0; side < 2; side++) {
+                    for (int i = 1; i <= depth; i++) {
+                        FIX44::MarketDataSnapshotFullRefresh::NoMDEntries group;
+                        group.setField(FIX::MDEntryType(side == 0 ? '0' : '1'));
+                        group.setField(FIX::MDEntryPx(side == 0 ? 50000.00 - i*0.01 : 50000.00 + i*0.01));
+                        group.setField(FIX::MDEntrySize(0.00125*i));
+                        message.addGroup(group);
+                    }
+                }
+                message.setField(FIX::NoMDEntries(2*depth));
+                return message;
+            }
+            FIX44::MarketDataIncrementalRefresh make_increment(int entries) {
+                FIX44::MarketDataIncrementalRefresh message;
+                for (int i = 0; i < entries; i++) {
+                    FIX44::MarketDataIncrementalRefresh::NoMDEntries group;
+                    group.setField(FIX::MDUpdateAction(i % 3 == 2 ? '2' : '1'));
+                    group.setField(FIX::MDEntryType(i % 2 ? '1' : '0'));
+                    group.setField(FIX::Symbol("BTCUSDT"));
+                    group.setField(FIX::MDEntryPx(i % 2 ? 50000.01 + i*0.01 : 49999.99 - i*0.01));
+                    group.setField(FIX::MDEntrySize(0.35 + i));
+                    message.addGroup(group);
+                }
+                message.setField(FIX::NoMDEntries(entries));
+                return message;
+            }
+
+            void BM_ParseMessage_Snapshot(benchmark::State& state) {
+                BenchParser parser;
+                auto message = make_snapshot(static_cast<int>(state.range(0)));
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                for (auto _ : state) {
+                    parser.parse_message(message, recv_time);
+                }
+                state.SetItemsProcessed(state.iterations());
+            }
+            void BM_ParseMessage_Increment(benchmark::State& state) {
+                BenchParser parser;
+                auto message = make_increment(static_cast<int>(state.range(0)));
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                for (auto _ : state) {
+                    parser.parse_message(message, recv_time);
+                }
+                state.SetItemsProcessed(state.iterations());
+            }
+            void BM_ParseRawMessage_Snapshot(benchmark::State& state) {
+                BenchParser parser;
+                std::string wire = make_snapshot(static_cast<int>(state.range(0))).toString();
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                for (auto _ : state) {
+                    parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+                }
+                state.SetItemsProcessed(state.iterations());
+                state.SetBytesProcessed(state.iterations()*static_cast<int64_t>(wire.size()));
+            }
+            void BM_ParseRawMessage_Increment(benchmark::State& state) {
+                BenchParser parser;
+                std::string wire = make_increment(static_cast<int>(state.range(0))).toString();
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                for (auto _ : state) {
+                    parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+                }
+                state.SetItemsProcessed(state.iterations());
+                state.SetBytesProcessed(state.iterations()*static_cast<int64_t>(wire.size()));
+            }
+        }
+
+        BENCHMARK(BM_ParseMessage_Snapshot)->Arg(5)->Arg(20)->Arg(100);
+        BENCHMARK(BM_ParseMessage_Increment)->Arg(1)->Arg(4)->Arg(16);
+        BENCHMARK(BM_ParseRawMessage_Snapshot)->Arg(5)->Arg(20)->Arg(100);
+        BENCHMARK(BM_ParseRawMessage_Increment)->Arg(1)->Arg(4)->Arg(16);
+    };
+};
+
+BENCHMARK_MAIN();
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.h"
+#include "common/lockfree_spsc_queue.h"
+#include "common/cpu.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace pascal {
+    namespace bench {
+        namespace {
+            using Queue = pascal::common::SPSCQueue<uint64_t, 1024>;
+
+            //Round trip of one item between two pinned threads, reported time is per round trip
+            void BM_PingPong(benchmark::State& state) {
+                auto cores = bench_cores();
+                auto ping = std::make_unique<Queue>();
+                auto pong = std::make_unique<Queue>();
+                std::atomic<bool> running{true};
+                std::thread echo([&]() {
+                    uint64_t value;
+                    while (running.load(std::memory_order_relaxed)) {
+                        if (ping->pop(value)) {
+                            while (!pong->push(value)) pascal::common::cpu_relax();
+                        }
+                    }
+                });
+                pin_to_core(echo, cores[1]);
+                pin_current_to_core(cores[0]);
+
+                uint64_t seq = 0, value = 0;
+                for (auto _ : state) {
+                    while (!ping->push(seq)) pascal::common::cpu_relax();
+                    while (!pong->pop(value)) pascal::common::cpu_relax();
+                    seq++;
+                }
+                running.store(false, std::memory_order_relaxed);
+                echo.join();
+                benchmark::DoNotOptimize(value);
+                state.SetItemsProcessed(state.iterations());
+            }
+
+            //Streaming items from a pinned producer to this thread, arg 0 is the batch size (1 = push/pop)
+            void BM_Throughput(benchmark::State& state) {
+                auto cores = bench_cores();
+                const size_t batch = static_cast<size_t>(state.range(0));
+                auto queue = std::make_unique<Queue>();
+                std::atomic<bool> running{true};
+                std::thread producer([&]() {
+                    uint64_t next = 0;
+                    uint64_t items[256];
+                    while (running.load(std::memory_order_relaxed)) {
+                        if (batch == 1) {
+                            if (queue->push(next)) next++;
+                            continue;
+                        }
+                        for (size_t i = 0; i < batch; i++) items[i] = next+i;
+                        next += queue->push_bulk(items, batch);
+                    }
+                });
+                pin_to_core(producer, cores[1]);
+                pin_current_to_core(cores[0]);
+
+                uint64_t items[256];
+                uint64_t received = 0;
+                for (auto _ : state) {
+                    //Each iteration moves batch items
+                    size_t got = 0;
+                    while (got < batch) {
+                        size_t n = batch == 1 ? (queue->pop(items[0]) ? 1 : 0) : queue->pop_bulk(items, batch-got);
+                        got += n;
+                    }
+                    received += got;
+                }
+                running.store(false, std::memory_order_relaxed);
+                producer.join();
+                benchmark::DoNotOptimize(received);
+                state.SetItemsProcessed(static_cast<int64_t>(received));
+            }
+        }
+
+        BENCHMARK(BM_PingPong)->UseRealTime();
+        BENCHMARK(BM_Throughput)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+    };
+};
+
+BENCHMARK_MAIN();
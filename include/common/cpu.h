@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace pascal {
+    namespace common {
+        constexpr size_t CACHE_LINE_SIZE = 64;
+
+        //Spin loop hint, lets the sibling hyperthread run and avoids the memory order flush on loop exit
+        inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield" ::: "memory");
+#endif
+        }
+
+        //Dense process wide index of the calling thread, lets per thread slots (reader pins, producer queues)
+        //be indexed without registration. A thread claims the lowest free index on its first call and hands
+        //it back when it exits, so indices stay below the number of live threads that asked however many
+        //threads come and go. The next owner of an index finds its slots as the last owner left them
+        inline size_t thread_index() {
+            struct Indices {
+                std::mutex mtx;
+                std::vector<size_t> released;
+                size_t next = 0;
+            };
+            //Never destroyed, threads may exit after static destruction
+            static Indices* indices = new Indices();
+            struct Claim {
+                size_t index;
+                Claim() {
+                    std::lock_guard<std::mutex> lock(indices->mtx);
+                    auto lowest = std::min_element(indices->released.begin(), indices->released.end());
+                    if (lowest == indices->released.end()) {
+                        index = indices->next++;
+                        return;
+                    }
+                    index = *lowest;
+                    indices->released.erase(lowest);
+                }
+                ~Claim() {
+                    std::lock_guard<std::mutex> lock(indices->mtx);
+                    indices->released.push_back(index);
+                }
+            };
+            thread_local Claim claim;
+            return claim.index;
+        }
+    };
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include "common/cpu.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace pascal {
+    namespace common {
+        //Deferred reclamation for structures read on the message path and replaced rarely, e.g. the book table
+        //of FIXOrderBookManager. A writer publishes a new copy, retires the old one and frees it once no reader
+        //can still hold it. Readers pin the current epoch in a slot of their own thread for the length of a read:
+        //one store to a cache line no other thread writes, no read-modify-write and never a wait.
+        //Reader slots are indexed by thread_index(), so a thread's slot goes to a later thread once it exits.
+        //Threads past MAX_READERS live at once share a counter that holds back every reclamation while any of them reads
+        class EpochDomain {
+        public:
+            static constexpr size_t MAX_READERS = 64;
+
+            //Pins the domain for the current thread, guards nest
+            class Guard {
+            public:
+                explicit Guard(EpochDomain& domain) : domain(domain), index(pascal::common::thread_index()) {
+                    if (index >= MAX_READERS) {
+                        domain.overflowReaders.fetch_add(1, std::memory_order_seq_cst);
+                        return;
+                    }
+                    Reader& reader = domain.readers[index];
+                    //The pin has to be visible before the reads it protects, writers scan after publishing
+                    if (reader.depth++ == 0) reader.epoch.store(domain.epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+                }
+                ~Guard() {
+                    if (index >= MAX_READERS) {
+                        domain.overflowReaders.fetch_sub(1, std::memory_order_release);
+                        return;
+                    }
+                    Reader& reader = domain.readers[index];
+                    if (--reader.depth == 0) reader.epoch.store(0, std::memory_order_release);
+                }
+
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+
+            private:
+                EpochDomain& domain;
+                size_t index;
+            };
+
+            EpochDomain() = default;
+            EpochDomain(const EpochDomain&) = delete;
+            EpochDomain& operator=(const EpochDomain&) = delete;
+
+            //Writer side, serialized by the caller. object must already be unreachable for new readers (its
+            //replacement published with a seq_cst store), it is freed by a later reclaim or with the domain
+            void retire(std::shared_ptr<const void> object) {
+                uint64_t retiredAt = epoch.fetch_add(1, std::memory_order_seq_cst);
+                retired.emplace_back(retiredAt, std::move(object));
+            }
+            //Frees what no reader can still hold, returns how many objects
+            size_t reclaim() {
+                if (retired.empty() || overflowReaders.load(std::memory_order_seq_cst)) return 0;
+                uint64_t oldest = UINT64_MAX;
+                for (const Reader& reader : readers) {
+                    uint64_t pinned = reader.epoch.load(std::memory_order_seq_cst);
+                    if (pinned && pinned < oldest) oldest = pinned;
+                }
+                //A reader pinned at e read the epoch before retirement e bumped it and may hold that object
+                size_t kept = 0;
+                for (auto& entry : retired) {
+                    if (entry.first >= oldest) retired[kept++] = std::move(entry);
+                }
+                size_t freed = retired.size() - kept;
+                retired.resize(kept);
+                return freed;
+            }
+            size_t get_retired() const {
+                return retired.size();
+            }
+
+        private:
+            struct alignas(CACHE_LINE_SIZE) Reader {
+                std::atomic<uint64_t> epoch{0}; //0 outside a read
+                uint32_t depth = 0;             //owning thread only
+            };
+            std::array<Reader, MAX_READERS> readers{};
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> epoch{1};
+            std::atomic<uint64_t> overflowReaders{0};
+            std::vector<std::pair<uint64_t, std::shared_ptr<const void>>> retired; //writer only, with the epoch retired at
+        };
+    };
+};
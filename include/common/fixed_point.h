@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace pascal {
+    namespace common {
+        using Ticks = int64_t; //price as an integer multiple of the symbol tick size
+        using Lots = int64_t;  //quantity as an integer multiple of the symbol lot size
+
+        //Wire decimals are normalised to a fixed 1e-8 grid (the finest increment crypto venues quote)
+        //before being divided down to ticks/lots. Doubles only appear in the to_price/to_quantity
+        //display helpers and in to_ticks/to_lots for callers that start from a double.
+        //The grid holds magnitudes up to MAX_WIRE_VALUE (about 9.2e10), larger wire values saturate to it,
+        //so sizes of very low priced coins near that range need a coarser lot_units to stay exact downstream
+        struct InstrumentSpec {
+            static constexpr int WIRE_DECIMALS = 8;
+            static constexpr int64_t WIRE_SCALE = 100000000;
+            static constexpr int64_t MAX_WIRE_VALUE = INT64_MAX;
+
+            int64_t tick_units = 1; //tick size in 1e-8 units
+            int64_t lot_units = 1;  //lot size in 1e-8 units
+
+            static InstrumentSpec from_increments(double tick_size, double lot_size) {
+                InstrumentSpec spec;
+                spec.tick_units = std::max<int64_t>(1, std::llround(tick_size * WIRE_SCALE));
+                spec.lot_units = std::max<int64_t>(1, std::llround(lot_size * WIRE_SCALE));
+                return spec;
+            }
+            bool is_identity() const {
+                return tick_units == 1 && lot_units == 1;
+            }
+
+            //Wire grid to book units
+            Ticks ticks_from_wire(int64_t wire) const {
+                return tick_units == 1 ? wire : wire / tick_units;
+            }
+            Lots lots_from_wire(int64_t wire) const {
+                return lot_units == 1 ? wire : wire / lot_units;
+            }
+
+            //API edge conversions
+            Ticks to_ticks(double price) const {
+                return std::llround(price * WIRE_SCALE / tick_units);
+            }
+            Lots to_lots(double quantity) const {
+                return std::llround(quantity * WIRE_SCALE / lot_units);
+            }
+            double to_price(Ticks ticks) const {
+                return static_cast<double>(ticks * tick_units) / WIRE_SCALE;
+            }
+            double to_quantity(Lots lots) const {
+                return static_cast<double>(lots * lot_units) / WIRE_SCALE;
+            }
+        };
+
+        //Parses a FIX decimal field ("-123.4500") onto the 1e-8 wire grid, digits past the 8th decimal are dropped.
+        //Values past the grid's range saturate to +-MAX_WIRE_VALUE
+        inline int64_t parse_wire_decimal(const char* begin, const char* end) {
+            static constexpr int64_t pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+            bool negative = begin < end && *begin == '-';
+            if (negative) begin++;
+            int64_t mantissa = 0;
+            int frac_digits = -1;
+            bool overflow = false;
+            for (; begin < end; begin++) {
+                char c = *begin;
+                if (c == '.') {
+                    frac_digits = 0;
+                    continue;
+                }
+                unsigned digit = static_cast<unsigned char>(c) - '0';
+                if (digit > 9) break;
+                if (frac_digits >= InstrumentSpec::WIRE_DECIMALS) continue;
+                overflow |= __builtin_mul_overflow(mantissa, 10, &mantissa);
+                overflow |= __builtin_add_overflow(mantissa, static_cast<int64_t>(digit), &mantissa);
+                if (frac_digits >= 0) frac_digits++;
+            }
+            int64_t wire;
+            overflow |= __builtin_mul_overflow(mantissa, pow10[InstrumentSpec::WIRE_DECIMALS - std::max(frac_digits, 0)], &wire);
+            if (overflow) wire = InstrumentSpec::MAX_WIRE_VALUE;
+            return negative ? -wire : wire;
+        }
+    };
+};
@@ -0,0 +1,209 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "common/tsc_clock.h"
+
+namespace pascal {
+    namespace common {
+        //Clock every latency stamp is taken from, nanoseconds
+        inline int64_t latency_clock_now() {
+            return TscClock::now_nanos();
+        }
+
+        //Copy of a histogram's counts, taken on the reading side. Values are nanoseconds.
+        class LatencySnapshot {
+        public:
+            LatencySnapshot() = default;
+            explicit LatencySnapshot(std::vector<uint64_t> counts) : counts(std::move(counts)) {}
+
+            uint64_t count() const;
+            //Value at or below which percent % of the samples fall (upper edge of its bucket), 0 when empty
+            uint64_t percentile(double percent) const;
+            uint64_t max() const;
+            uint64_t min() const;
+            double mean() const;
+
+            //Samples recorded after base was taken, base must be an earlier snapshot of the same histogram
+            LatencySnapshot& operator-=(const LatencySnapshot& base);
+            //Merges another histogram's samples, e.g. one stage across symbols
+            LatencySnapshot& operator+=(const LatencySnapshot& other);
+
+        private:
+            std::vector<uint64_t> counts;
+        };
+
+        //HDR style log-linear histogram of nanosecond latencies. Values below 128ns are exact, above that every
+        //power of two range is split into 64 buckets, so a reported value is within 1/64 of the recorded one.
+        //Values are clamped to MAX_VALUE (~68s). One thread records, any thread can take snapshots: counters are
+        //bumped with a plain load and store, no read-modify-write on the hot path.
+        class LatencyHistogram {
+        public:
+            static constexpr unsigned SUB_BUCKET_BITS = 7;
+            static constexpr unsigned MAX_VALUE_BITS = 36;
+            static constexpr uint64_t MAX_VALUE = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+            static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+            static constexpr size_t HALF_SUB_BUCKETS = SUB_BUCKETS/2;
+            static constexpr size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1)*HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+
+            LatencyHistogram() = default;
+            LatencyHistogram(const LatencyHistogram&) = delete;
+            LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+            //Recording thread only
+            void record(int64_t nanos) {
+                uint64_t value = nanos < 0 ? 0 : static_cast<uint64_t>(nanos);
+                std::atomic<uint64_t>& counter = counts[bucket_of(value)];
+                counter.store(counter.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+            }
+            //Only while nothing records
+            void reset() {
+                for (auto& counter : counts) counter.store(0, std::memory_order_relaxed);
+            }
+            LatencySnapshot snapshot() const {
+                std::vector<uint64_t> copy(BUCKET_COUNT);
+                for (size_t i = 0; i < BUCKET_COUNT; i++) copy[i] = counts[i].load(std::memory_order_relaxed);
+                return LatencySnapshot(std::move(copy));
+            }
+
+            static size_t bucket_of(uint64_t value) {
+                if (value > MAX_VALUE) value = MAX_VALUE;
+                unsigned msb = 63 - std::countl_zero(value | (SUB_BUCKETS-1));
+                unsigned shift = msb - (SUB_BUCKET_BITS-1);
+                return shift*HALF_SUB_BUCKETS + (value >> shift);
+            }
+            //Smallest and largest value counted in a bucket
+            static uint64_t lowest_in(size_t bucket) {
+                unsigned shift = bucket < SUB_BUCKETS ? 0 : static_cast<unsigned>(bucket/HALF_SUB_BUCKETS - 1);
+                return static_cast<uint64_t>(bucket - shift*HALF_SUB_BUCKETS) << shift;
+            }
+            static uint64_t highest_in(size_t bucket) {
+                unsigned shift = bucket < SUB_BUCKETS ? 0 : static_cast<unsigned>(bucket/HALF_SUB_BUCKETS - 1);
+                return lowest_in(bucket) + (uint64_t(1) << shift) - 1;
+            }
+
+        private:
+            std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts{};
+        };
+
+        inline uint64_t LatencySnapshot::count() const {
+            uint64_t total = 0;
+            for (uint64_t c : counts) total += c;
+            return total;
+        }
+        inline uint64_t LatencySnapshot::percentile(double percent) const {
+            uint64_t total = count();
+            if (total == 0) return 0;
+            if (percent >= 100.0) return max();
+            uint64_t rank = static_cast<uint64_t>(std::ceil(percent/100.0*static_cast<double>(total)));
+            if (rank == 0) rank = 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); i++) {
+                seen += counts[i];
+                if (seen >= rank) return LatencyHistogram::highest_in(i);
+            }
+            return max();
+        }
+        inline uint64_t LatencySnapshot::max() const {
+            for (size_t i = counts.size(); i-- > 0;) {
+                if (counts[i]) return LatencyHistogram::highest_in(i);
+            }
+            return 0;
+        }
+        inline uint64_t LatencySnapshot::min() const {
+            for (size_t i = 0; i < counts.size(); i++) {
+                if (counts[i]) return LatencyHistogram::lowest_in(i);
+            }
+            return 0;
+        }
+        inline double LatencySnapshot::mean() const {
+            uint64_t total = 0;
+            double sum = 0.0;
+            for (size_t i = 0; i < counts.size(); i++) {
+                if (!counts[i]) continue;
+                //Middle of the bucket
+                double mid = (static_cast<double>(LatencyHistogram::lowest_in(i)) + static_cast<double>(LatencyHistogram::highest_in(i)))/2.0;
+                sum += mid*static_cast<double>(counts[i]);
+                total += counts[i];
+            }
+            return total ? sum/static_cast<double>(total) : 0.0;
+        }
+        inline LatencySnapshot& LatencySnapshot::operator-=(const LatencySnapshot& base) {
+            for (size_t i = 0; i < counts.size() && i < base.counts.size(); i++) {
+                counts[i] = counts[i] >= base.counts[i] ? counts[i] - base.counts[i] : 0;
+            }
+            return *this;
+        }
+        inline LatencySnapshot& LatencySnapshot::operator+=(const LatencySnapshot& other) {
+            if (counts.size() < other.counts.size()) counts.resize(other.counts.size());
+            for (size_t i = 0; i < other.counts.size(); i++) counts[i] += other.counts[i];
+            return *this;
+        }
+
+        //Hops of a market data message, each measured from the end of the previous one
+        enum class LatencyStage {
+            RECEIVE,    //fromApp entry -> serialized into the symbol ring (session thread)
+            QUEUE,      //in the ring until a worker dequeues it
+            PARSE,      //dequeue -> event decoded
+            BOOK,       //decoded -> applied to the book, only when the sink has a BookUpdateStage
+            CALLBACK,   //book applied (or decoded) -> sink returned
+            END_TO_END  //fromApp entry -> sink returned
+        };
+        constexpr size_t LATENCY_STAGE_COUNT = 6;
+
+        inline const char* latency_stage_name(LatencyStage stage) {
+            switch (stage) {
+                case LatencyStage::RECEIVE : return "receive";
+                case LatencyStage::QUEUE : return "queue";
+                case LatencyStage::PARSE : return "parse";
+                case LatencyStage::BOOK : return "book";
+                case LatencyStage::CALLBACK : return "callback";
+                case LatencyStage::END_TO_END : return "end_to_end";
+            }
+            return "unknown";
+        }
+
+        //Stamps left by the parser and the book stage of the thread handling a message, read back by the
+        //worker once the sink returns. Zero means the point was not reached for the current message.
+        struct StageMarks {
+            int64_t parsed = 0;
+            int64_t book_applied = 0;
+        };
+        inline StageMarks& thread_stage_marks() {
+            thread_local StageMarks marks;
+            return marks;
+        }
+
+        //Per symbol histograms, one per stage. Every stage has a single recording thread (RECEIVE the session
+        //thread, the rest the symbol's worker). Interval queries are relative to a baseline kept on the
+        //reading side, so starting a new interval never touches the recording threads' counters.
+        class StageLatency {
+        public:
+            void record(LatencyStage stage, int64_t nanos) {
+                histograms[static_cast<size_t>(stage)].record(nanos);
+            }
+
+            //Reading side, callers serialize these
+            LatencySnapshot total(LatencyStage stage) const {
+                return histograms[static_cast<size_t>(stage)].snapshot();
+            }
+            LatencySnapshot interval(LatencyStage stage) const {
+                LatencySnapshot current = total(stage);
+                current -= baselines[static_cast<size_t>(stage)];
+                return current;
+            }
+            void reset_interval() {
+                for (size_t i = 0; i < LATENCY_STAGE_COUNT; i++) baselines[i] = histograms[i].snapshot();
+            }
+
+        private:
+            std::array<LatencyHistogram, LATENCY_STAGE_COUNT> histograms;
+            std::array<LatencySnapshot, LATENCY_STAGE_COUNT> baselines;
+        };
+    };
+};
@@ -1,18 +1,62 @@
 #pragma once
 #include <atomic>
-#include <array>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include "common/cpu.h"
 
 namespace pascal {
     namespace common {
+        //Single producer single consumer ring.
+        //Indices run freely and are masked into the slots, so Capacity must be a power of two and every slot is usable.
+        //Each side keeps a private copy of the other side's index and only reloads the shared atomic when the
+        //copy shows too little room (producer) or too few items (consumer), which keeps the index cache lines mostly unshared.
         template<typename T, std::size_t Capacity>
         class SPSCQueue {
+            static_assert(Capacity > 0 && (Capacity & (Capacity-1)) == 0, "SPSCQueue capacity must be a power of two");
+            static constexpr size_t MASK = Capacity-1;
+
         private:
-            alignas(64) std::atomic<size_t> readIdx_{0};
-            alignas(64) std::atomic<size_t> writeIdx_{0};
-            std::array<T, Capacity+1> data_;
-        
+            //Producer line
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> writeIdx_{0};
+            size_t cachedReadIdx_{0};
+            //Consumer line
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> readIdx_{0};
+            size_t cachedWriteIdx_{0};
+
+            //Raw slots, items only exist between push and pop
+            alignas(CACHE_LINE_SIZE) alignas(T) unsigned char storage_[Capacity*sizeof(T)];
+
+            T* slot(size_t idx) {
+                return std::launder(reinterpret_cast<T*>(storage_ + (idx & MASK)*sizeof(T)));
+            }
+            //Free slots seen by the producer, reloads the consumer index only when the cached one falls short
+            size_t free_slots(size_t write_idx, size_t wanted) {
+                size_t free = Capacity - (write_idx - cachedReadIdx_);
+                if (free < wanted) {
+                    cachedReadIdx_ = readIdx_.load(std::memory_order_acquire);
+                    free = Capacity - (write_idx - cachedReadIdx_);
+                }
+                return free;
+            }
+            //Items seen by the consumer, reloads the producer index only when the cached one falls short
+            size_t ready_items(size_t read_idx, size_t wanted) {
+                size_t ready = cachedWriteIdx_ - read_idx;
+                if (ready < wanted) {
+                    cachedWriteIdx_ = writeIdx_.load(std::memory_order_acquire);
+                    ready = cachedWriteIdx_ - read_idx;
+                }
+                return ready;
+            }
+
         public:
             SPSCQueue() = default;
+            ~SPSCQueue() {
+                size_t read_idx = readIdx_.load(std::memory_order_relaxed);
+                size_t write_idx = writeIdx_.load(std::memory_order_relaxed);
+                for (; read_idx != write_idx; read_idx++) slot(read_idx)->~T();
+            }
 
             //Non-copyable and non-movable for safety
             SPSCQueue(const SPSCQueue& q) = delete;
@@ -21,37 +65,79 @@ namespace pascal {
             template<typename... Args>
             bool push(Args&&... args) {
                 size_t write_idx = writeIdx_.load(std::memory_order_relaxed);
-                size_t nextIdx = (write_idx+1)%data_.size();
-                if (nextIdx == readIdx_.load(std::memory_order_acquire)) return false; //Queue full
+                if (free_slots(write_idx, 1) == 0) return false; //Queue full
 
                 //In place construction through perfect forwarding
-                new (&data_[write_idx]) T(std::forward<Args>(args)...);
+                new (slot(write_idx)) T(std::forward<Args>(args)...);
 
                 //Store new write index
-                writeIdx_.store(nextIdx, std::memory_order_release);
+                writeIdx_.store(write_idx+1, std::memory_order_release);
                 return true;
             }
+            //Constructs up to count items from *first, *(first+1)... and publishes them with a single store.
+            //Returns how many were pushed, pass a std::move_iterator to move the items in.
+            template<typename InputIt>
+            size_t push_bulk(InputIt first, size_t count) {
+                size_t write_idx = writeIdx_.load(std::memory_order_relaxed);
+                size_t n = std::min(count, free_slots(write_idx, count));
+                for (size_t i = 0; i < n; i++, ++first) {
+                    new (slot(write_idx+i)) T(*first);
+                }
+                if (n) writeIdx_.store(write_idx+n, std::memory_order_release);
+                return n;
+            }
+
             bool pop(T& item) {
                 size_t read_idx = readIdx_.load(std::memory_order_relaxed);
-                size_t nextIdx = (read_idx+1)%data_.size();
-                if (read_idx == writeIdx_.load(std::memory_order_acquire)) return false; //Queue is empty
+                if (ready_items(read_idx, 1) == 0) return false; //Queue is empty
 
-                //Move item from queue to lvalue arg
-                item = std::move(data_[read_idx]);
-
-                //Destroy queue element
-                data_[read_idx].~T();
+                //Move item from queue to lvalue arg and destroy the queue element
+                T* elem = slot(read_idx);
+                item = std::move(*elem);
+                elem->~T();
 
                 //Store new readIdx
-                readIdx_.store(nextIdx, std::memory_order_release);
+                readIdx_.store(read_idx+1, std::memory_order_release);
                 return true;
             }
+            //Moves up to max_items into out and frees their slots with a single store, returns how many were popped
+            size_t pop_bulk(T* out, size_t max_items) {
+                size_t read_idx = readIdx_.load(std::memory_order_relaxed);
+                size_t n = std::min(max_items, ready_items(read_idx, max_items));
+                for (size_t i = 0; i < n; i++) {
+                    T* elem = slot(read_idx+i);
+                    out[i] = std::move(*elem);
+                    elem->~T();
+                }
+                if (n) readIdx_.store(read_idx+n, std::memory_order_release);
+                return n;
+            }
+            //Calls fn(T&) in place on every item available when called (at most max_items), then frees their
+            //slots with a single store. Returns how many were consumed.
+            template<typename Fn>
+            size_t consume_all(Fn&& fn, size_t max_items = Capacity) {
+                size_t read_idx = readIdx_.load(std::memory_order_relaxed);
+                size_t n = std::min(max_items, ready_items(read_idx, max_items));
+                for (size_t i = 0; i < n; i++) {
+                    T* elem = slot(read_idx+i);
+                    fn(*elem);
+                    elem->~T();
+                }
+                if (n) readIdx_.store(read_idx+n, std::memory_order_release);
+                return n;
+            }
+
             bool empty() const {
                 return readIdx_.load(std::memory_order_acquire) == writeIdx_.load(std::memory_order_acquire);
             }
+            //Approximate when called concurrently with the other side
+            size_t size() const {
+                size_t read_idx = readIdx_.load(std::memory_order_acquire);
+                return writeIdx_.load(std::memory_order_acquire) - read_idx;
+            }
             constexpr size_t capacity() const {
                 return Capacity;
             }
         };
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "common/cpu.h"
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace pascal {
+    namespace common {
+        //Sequence lock for data with one writer at a time and any number of readers that never lock.
+        //The writer brackets each change with begin_write/end_write (or a WriteGuard), leaving the sequence odd
+        //while the data is being changed. Readers copy what they need in read_consistent, which retries the copy
+        //when the sequence was odd or moved underneath it. Writers on different threads serialize themselves.
+        //One 64 bit atomic and nothing else, so it can live in shared memory mapped by several processes
+        class SeqLock {
+        public:
+            void begin_write() {
+                sequence_.store(sequence_.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+            void end_write() {
+                sequence_.store(sequence_.load(std::memory_order_relaxed)+1, std::memory_order_release);
+            }
+
+            class WriteGuard {
+            public:
+                explicit WriteGuard(SeqLock& lock) : lock(lock) {
+                    lock.begin_write();
+                }
+                ~WriteGuard() {
+                    lock.end_write();
+                }
+
+                WriteGuard(const WriteGuard&) = delete;
+                WriteGuard& operator=(const WriteGuard&) = delete;
+
+            private:
+                SeqLock& lock;
+            };
+
+            //Runs fn until it completes without overlapping a write and returns its last result. fn must only
+            //copy plain data out, it may see a torn state that is then discarded
+            template<typename Fn>
+            auto read_consistent(Fn&& fn) const {
+                while (true) {
+                    uint64_t v1 = sequence_.load(std::memory_order_acquire);
+                    if (v1 & 1) {
+                        cpu_relax();
+                        continue;
+                    }
+                    if constexpr (std::is_void_v<std::invoke_result_t<Fn&>>) {
+                        fn();
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (sequence_.load(std::memory_order_relaxed) == v1) return;
+                    } else {
+                        auto result = fn();
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (sequence_.load(std::memory_order_relaxed) == v1) return result;
+                    }
+                }
+            }
+
+            //Twice the completed writes, odd while one is in progress
+            uint64_t sequence() const {
+                return sequence_.load(std::memory_order_acquire);
+            }
+            //False until the first write since construction or reset
+            bool written() const {
+                return sequence() != 0;
+            }
+            //Back to never written, only while no write is in progress
+            void reset() {
+                sequence_.store(0, std::memory_order_relaxed);
+            }
+
+        private:
+            std::atomic<uint64_t> sequence_{0};
+        };
+        static_assert(sizeof(SeqLock) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free, "SeqLock is shared across processes");
+    };
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace pascal {
+    namespace common {
+        //Vector of trivially copyable items with room for N of them inline. Growing past N moves the items
+        //to the heap, and clear() keeps whatever capacity was reached, so a reused instance stops allocating
+        //once it has seen its largest message.
+        template<typename T, std::size_t N>
+        class SmallVector {
+            static_assert(std::is_trivially_copyable_v<T>, "SmallVector only holds trivially copyable items");
+            static_assert(N > 0);
+
+        public:
+            using value_type = T;
+            using iterator = T*;
+            using const_iterator = const T*;
+
+            SmallVector() = default;
+            SmallVector(std::initializer_list<T> items) {
+                assign(items.begin(), items.end());
+            }
+            SmallVector(const SmallVector& other) {
+                assign(other.begin(), other.end());
+            }
+            SmallVector& operator=(const SmallVector& other) {
+                if (this != &other) assign(other.begin(), other.end());
+                return *this;
+            }
+            SmallVector(SmallVector&& other) noexcept {
+                take(other);
+            }
+            SmallVector& operator=(SmallVector&& other) noexcept {
+                if (this != &other) take(other);
+                return *this;
+            }
+            SmallVector& operator=(std::initializer_list<T> items) {
+                assign(items.begin(), items.end());
+                return *this;
+            }
+
+            template<typename It>
+            void assign(It first, It last) {
+                size_ = 0;
+                reserve(static_cast<size_t>(std::distance(first, last)));
+                for (; first != last; ++first) data_()[size_++] = *first;
+            }
+            void reserve(size_t capacity) {
+                if (capacity <= capacity_) return;
+                std::unique_ptr<T[]> grown(new T[capacity]);
+                std::memcpy(static_cast<void*>(grown.get()), data_(), size_*sizeof(T));
+                heap_ = std::move(grown);
+                capacity_ = capacity;
+            }
+            void push_back(const T& item) {
+                if (size_ == capacity_) reserve(capacity_*2);
+                data_()[size_++] = item;
+            }
+            template<typename... Args>
+            T& emplace_back(Args&&... args) {
+                if (size_ == capacity_) reserve(capacity_*2);
+                T* slot = data_() + size_++;
+                *slot = T{std::forward<Args>(args)...};
+                return *slot;
+            }
+            void pop_back() {
+                size_--;
+            }
+            void clear() {
+                size_ = 0;
+            }
+
+            T* data() { return data_(); }
+            const T* data() const { return data_(); }
+            size_t size() const { return size_; }
+            size_t capacity() const { return capacity_; }
+            bool empty() const { return size_ == 0; }
+            bool is_inline() const { return !heap_; }
+
+            T& operator[](size_t idx) { return data_()[idx]; }
+            const T& operator[](size_t idx) const { return data_()[idx]; }
+            T& front() { return data_()[0]; }
+            const T& front() const { return data_()[0]; }
+            T& back() { return data_()[size_-1]; }
+            const T& back() const { return data_()[size_-1]; }
+
+            iterator begin() { return data_(); }
+            iterator end() { return data_() + size_; }
+            const_iterator begin() const { return data_(); }
+            const_iterator end() const { return data_() + size_; }
+
+        private:
+            alignas(T) unsigned char inline_[N*sizeof(T)];
+            std::unique_ptr<T[]> heap_;
+            size_t size_ = 0;
+            size_t capacity_ = N;
+
+            T* data_() {
+                return heap_ ? heap_.get() : reinterpret_cast<T*>(inline_);
+            }
+            const T* data_() const {
+                return heap_ ? heap_.get() : reinterpret_cast<const T*>(inline_);
+            }
+            void take(SmallVector& other) {
+                if (other.heap_) {
+                    heap_ = std::move(other.heap_);
+                    capacity_ = other.capacity_;
+                    size_ = other.size_;
+                    other.capacity_ = N;
+                }
+                else {
+                    heap_.reset();
+                    capacity_ = N;
+                    size_ = other.size_;
+                    std::memcpy(inline_, other.inline_, size_*sizeof(T));
+                }
+                other.size_ = 0;
+            }
+        };
+    };
+};
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "common/cpu.h"
+
+namespace pascal {
+    namespace common {
+        //Single producer single consumer ring of variable length byte records, written and read in place.
+        //A record is a 16 byte header (payload size, a 32 bit and a 64 bit tag) followed by the payload, padded to 16 bytes.
+        //A record that would straddle the end of the buffer is preceded by a wrap marker and written at the start.
+        //Index handling follows SPSCQueue: free running positions, masked, with cached copies of the remote side.
+        template<std::size_t Capacity>
+        class SPSCByteRing {
+            static_assert(Capacity >= 64 && (Capacity & (Capacity-1)) == 0, "SPSCByteRing capacity must be a power of two");
+            static constexpr size_t MASK = Capacity-1;
+            static constexpr size_t RECORD_ALIGN = 16;
+            static constexpr uint32_t WRAP = 0xFFFFFFFF;
+
+            struct RecordHeader {
+                uint32_t size;
+                uint32_t aux;
+                int64_t tag;
+            };
+            static_assert(sizeof(RecordHeader) == RECORD_ALIGN);
+
+        public:
+            //Largest payload push accepts, keeps a wrapped record from needing more than the whole ring
+            static constexpr size_t MAX_RECORD_SIZE = Capacity/2 - sizeof(RecordHeader);
+
+        private:
+            //Producer line
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> writePos_{0};
+            size_t cachedReadPos_{0};
+            //Consumer line
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> readPos_{0};
+            size_t cachedWritePos_{0};
+
+            alignas(CACHE_LINE_SIZE) unsigned char buffer_[Capacity];
+
+            static constexpr size_t record_bytes(size_t size) {
+                return sizeof(RecordHeader) + ((size + RECORD_ALIGN-1) & ~(RECORD_ALIGN-1));
+            }
+            RecordHeader* header_at(size_t pos) {
+                return reinterpret_cast<RecordHeader*>(buffer_ + (pos & MASK));
+            }
+
+        public:
+            SPSCByteRing() = default;
+
+            //Non-copyable and non-movable for safety
+            SPSCByteRing(const SPSCByteRing&) = delete;
+            SPSCByteRing& operator=(const SPSCByteRing&) = delete;
+
+            //Copies size bytes into the ring as one record, false if it is full or the record is too large
+            bool push(const void* data, size_t size, int64_t tag, uint32_t aux = 0) {
+                if (size > MAX_RECORD_SIZE) return false;
+                size_t write_pos = writePos_.load(std::memory_order_relaxed);
+                size_t need = record_bytes(size);
+                size_t tail = Capacity - (write_pos & MASK);
+                size_t total = need <= tail ? need : tail+need;
+                if (Capacity - (write_pos - cachedReadPos_) < total) {
+                    cachedReadPos_ = readPos_.load(std::memory_order_acquire);
+                    if (Capacity - (write_pos - cachedReadPos_) < total) return false; //Ring full
+                }
+
+                if (need > tail) {
+                    header_at(write_pos)->size = WRAP;
+                    write_pos += tail;
+                }
+                RecordHeader* header = header_at(write_pos);
+                header->size = static_cast<uint32_t>(size);
+                header->aux = aux;
+                header->tag = tag;
+                std::memcpy(header+1, data, size);
+
+                writePos_.store(write_pos+need, std::memory_order_release);
+                return true;
+            }
+
+            //Calls fn(const char* data, size_t size, int64_t tag) in place on up to max_records records,
+            //then releases their bytes with a single store. Returns how many records were consumed.
+            //fn may take a fourth uint32_t argument to also receive the aux tag.
+            template<typename Fn>
+            size_t consume_all(Fn&& fn, size_t max_records = Capacity) {
+                size_t read_pos = readPos_.load(std::memory_order_relaxed);
+                if (read_pos == cachedWritePos_) {
+                    cachedWritePos_ = writePos_.load(std::memory_order_acquire);
+                    if (read_pos == cachedWritePos_) return 0;
+                }
+                size_t n = 0;
+                while (read_pos != cachedWritePos_ && n < max_records) {
+                    RecordHeader* header = header_at(read_pos);
+                    if (header->size == WRAP) {
+                        read_pos += Capacity - (read_pos & MASK);
+                        continue;
+                    }
+                    const char* payload = reinterpret_cast<const char*>(header+1);
+                    if constexpr (std::is_invocable_v<Fn, const char*, size_t, int64_t, uint32_t>) {
+                        fn(payload, static_cast<size_t>(header->size), header->tag, header->aux);
+                    }
+                    else {
+                        fn(payload, static_cast<size_t>(header->size), header->tag);
+                    }
+                    read_pos += record_bytes(header->size);
+                    n++;
+                }
+                readPos_.store(read_pos, std::memory_order_release);
+                return n;
+            }
+
+            bool empty() const {
+                return readPos_.load(std::memory_order_acquire) == writePos_.load(std::memory_order_acquire);
+            }
+            //Bytes in use including headers and padding, approximate when called concurrently with the other side
+            size_t bytes_used() const {
+                size_t read_pos = readPos_.load(std::memory_order_acquire);
+                return writePos_.load(std::memory_order_acquire) - read_pos;
+            }
+            constexpr size_t capacity() const {
+                return Capacity;
+            }
+        };
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace pascal {
+    namespace common {
+        using SymbolId = uint32_t;
+        constexpr SymbolId INVALID_SYMBOL_ID = std::numeric_limits<SymbolId>::max();
+
+        //Process wide table of dense symbol ids, handed out in registration order from 0.
+        //Symbols are registered at subscription time (mutex, rare) and looked up on the message path
+        //without locking: names are written before their hash slot is published with a release store,
+        //and a published id is never removed or reused, so ids can index flat per-symbol arrays.
+        class SymbolRegistry {
+        public:
+            static constexpr size_t MAX_SYMBOLS = 1024;
+
+            static SymbolRegistry& instance() {
+                static SymbolRegistry registry;
+                return registry;
+            }
+
+            SymbolRegistry() = default;
+            SymbolRegistry(const SymbolRegistry&) = delete;
+            SymbolRegistry& operator=(const SymbolRegistry&) = delete;
+
+            //Returns the id of symbol, assigning the next one if it is new. INVALID_SYMBOL_ID when the table is full
+            SymbolId register_symbol(std::string_view symbol) {
+                SymbolId id = find(symbol);
+                if (id != INVALID_SYMBOL_ID) return id;
+
+                std::lock_guard<std::mutex> lk(registerMtx);
+                id = find(symbol);
+                if (id != INVALID_SYMBOL_ID) return id;
+                size_t count = count_.load(std::memory_order_relaxed);
+                if (symbol.empty() || count == MAX_SYMBOLS) return INVALID_SYMBOL_ID;
+
+                names[count].assign(symbol);
+                size_t slot = hash(symbol) & SLOT_MASK;
+                while (slots[slot].load(std::memory_order_relaxed)) slot = (slot+1) & SLOT_MASK;
+                slots[slot].store(static_cast<uint32_t>(count+1), std::memory_order_release);
+                count_.store(count+1, std::memory_order_release);
+                return static_cast<SymbolId>(count);
+            }
+
+            //Lock free lookup, INVALID_SYMBOL_ID if symbol was never registered
+            SymbolId find(std::string_view symbol) const {
+                size_t slot = hash(symbol) & SLOT_MASK;
+                while (true) {
+                    uint32_t entry = slots[slot].load(std::memory_order_acquire);
+                    if (!entry) return INVALID_SYMBOL_ID;
+                    if (names[entry-1] == symbol) return entry-1;
+                    slot = (slot+1) & SLOT_MASK;
+                }
+            }
+
+            //id must have been returned by register_symbol
+            const std::string& name(SymbolId id) const {
+                return names[id];
+            }
+            size_t size() const {
+                return count_.load(std::memory_order_acquire);
+            }
+
+        private:
+            static constexpr size_t SLOTS = MAX_SYMBOLS*2; //load factor stays <= 0.5
+            static constexpr size_t SLOT_MASK = SLOTS-1;
+            static_assert((SLOTS & SLOT_MASK) == 0, "slot count must be a power of two");
+
+            std::array<std::string, MAX_SYMBOLS> names;
+            std::array<std::atomic<uint32_t>, SLOTS> slots{}; //id+1, 0 is empty
+            std::atomic<size_t> count_{0};
+            std::mutex registerMtx;
+
+            //FNV-1a, symbols are a handful of bytes
+            static size_t hash(std::string_view symbol) {
+                uint64_t h = 14695981039346656037ull;
+                for (unsigned char c : symbol) {
+                    h ^= c;
+                    h *= 1099511628211ull;
+                }
+                return static_cast<size_t>(h ^ (h >> 32));
+            }
+        };
+    };
+};
@@ -0,0 +1,239 @@
+#pragma once
+#include "common/seqlock.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define PASCAL_HAS_TSC 1
+#else
+#define PASCAL_HAS_TSC 0
+#endif
+
+namespace pascal {
+    namespace common {
+        //Timestamps in the high_resolution_clock domain, read from the CPU time stamp counter.
+        //A reading is rdtsc plus a multiply against calibration parameters published through a seqlock,
+        //instead of a clock_gettime call. The parameters are recalibrated against high_resolution_clock
+        //every RECALIBRATION_INTERVAL by whichever thread reads the clock first after it elapses: small drift
+        //is corrected by adjusting the rate over the next interval, so readings stay continuous; a large
+        //step of the reference clock re-anchors. Without an invariant TSC (or when the measured rate is
+        //implausible) every reading falls back to high_resolution_clock::now().
+        //The first use sleeps for CALIBRATION_WINDOW, so latency sensitive owners call is_tsc() at startup.
+        class TscClock {
+        public:
+            using reference_clock = std::chrono::high_resolution_clock;
+            using time_point = reference_clock::time_point;
+
+            static constexpr std::chrono::milliseconds CALIBRATION_WINDOW{20};
+            static constexpr std::chrono::milliseconds RECALIBRATION_INTERVAL{1000};
+            static constexpr int64_t MAX_SLEW_NANOS = 1000000; //larger errors re-anchor instead of slewing
+
+            static time_point now() {
+                return time_point(std::chrono::duration_cast<reference_clock::duration>(std::chrono::nanoseconds(now_nanos())));
+            }
+            //Nanoseconds since the reference clock's epoch
+            static int64_t now_nanos() {
+                State& s = state();
+                if (s.mode.load(std::memory_order_acquire) != Mode::TSC) {
+                    if (s.mode.load(std::memory_order_acquire) == Mode::UNINITIALIZED) initialize();
+                    if (s.mode.load(std::memory_order_acquire) != Mode::TSC) return reference_nanos();
+                }
+                uint64_t tsc = read_tsc();
+                Params p = load_params();
+                if (tsc >= p.next_check_tsc) {
+                    recalibrate();
+                    p = load_params();
+                }
+                return to_nanos(p, tsc);
+            }
+
+            //True when readings come from the TSC rather than the fallback
+            static bool is_tsc() {
+                if (state().mode.load(std::memory_order_acquire) == Mode::UNINITIALIZED) initialize();
+                return state().mode.load(std::memory_order_acquire) == Mode::TSC;
+            }
+            static bool invariant_tsc_supported() {
+#if PASCAL_HAS_TSC
+                unsigned eax, ebx, ecx, edx;
+                if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007) return false;
+                if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+                return (edx >> 8) & 1;
+#else
+                return false;
+#endif
+            }
+            //Estimated counter rate, 0 in fallback mode
+            static double ticks_per_nano() {
+                if (!is_tsc()) return 0.0;
+                return 4294967296.0/static_cast<double>(load_params().mult);
+            }
+
+            //Takes a fresh sample now instead of waiting for the interval, no-op in fallback mode or when the
+            //last sample is less than CALIBRATION_WINDOW old
+            static void recalibrate() {
+                State& s = state();
+                if (s.mode.load(std::memory_order_acquire) != Mode::TSC) return;
+                if (s.calibrating.test_and_set(std::memory_order_acquire)) return; //another thread is on it
+                Sample sample = take_sample();
+                Params p = load_params();
+                int64_t elapsed = sample.nanos - s.lastSample.nanos;
+                uint64_t ticks = sample.tsc - s.lastSample.tsc;
+                if (elapsed >= std::chrono::duration_cast<std::chrono::nanoseconds>(CALIBRATION_WINDOW).count() && ticks > 0) {
+                    uint64_t mult = rate_mult(ticks, elapsed);
+                    Params next = p;
+                    int64_t estimate = to_nanos(p, sample.tsc);
+                    int64_t error = sample.nanos - estimate;
+                    if (!plausible(mult)) {
+                        s.mode.store(Mode::FALLBACK, std::memory_order_release);
+                    }
+                    else if (error > MAX_SLEW_NANOS || error < -MAX_SLEW_NANOS) {
+                        next = {sample.tsc, sample.nanos, mult, 0};
+                    }
+                    else {
+                        //Keep the reading continuous and absorb the error over the next interval
+                        int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(RECALIBRATION_INTERVAL).count();
+                        next = {sample.tsc, estimate, static_cast<uint64_t>(static_cast<int128>(mult)*(interval+error)/interval), 0};
+                    }
+                    next.next_check_tsc = sample.tsc + interval_ticks(next.mult);
+                    store_params(next);
+                    s.lastSample = sample;
+                }
+                s.calibrating.clear(std::memory_order_release);
+            }
+
+            //Switches every later reading to high_resolution_clock, e.g. for hosts whose TSC is known to be unreliable
+            static void force_fallback() {
+                initialize();
+                state().mode.store(Mode::FALLBACK, std::memory_order_release);
+            }
+
+        private:
+            __extension__ typedef __int128 int128;
+            __extension__ typedef unsigned __int128 uint128;
+
+            enum class Mode : int { UNINITIALIZED, TSC, FALLBACK };
+
+            //nanos = base_nanos + ((tsc - base_tsc)*mult >> 32)
+            struct Params {
+                uint64_t base_tsc;
+                int64_t base_nanos;
+                uint64_t mult;
+                uint64_t next_check_tsc;
+            };
+            struct Sample {
+                uint64_t tsc = 0;
+                int64_t nanos = 0;
+            };
+            struct State {
+                std::atomic<Mode> mode{Mode::UNINITIALIZED};
+                std::once_flag initialized;
+                SeqLock seqlock;
+                std::atomic<uint64_t> baseTsc{0};
+                std::atomic<int64_t> baseNanos{0};
+                std::atomic<uint64_t> mult{0};
+                std::atomic<uint64_t> nextCheckTsc{UINT64_MAX};
+                std::atomic_flag calibrating = ATOMIC_FLAG_INIT;
+                Sample lastSample; //only touched while holding calibrating
+            };
+            static State& state() {
+                static State s;
+                return s;
+            }
+
+            static uint64_t read_tsc() {
+#if PASCAL_HAS_TSC
+                return __rdtsc();
+#else
+                return 0;
+#endif
+            }
+            static int64_t reference_nanos() {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(reference_clock::now().time_since_epoch()).count();
+            }
+            static int64_t to_nanos(const Params& p, uint64_t tsc) {
+                int64_t delta = static_cast<int64_t>(tsc - p.base_tsc);
+                return p.base_nanos + static_cast<int64_t>((static_cast<int128>(delta)*p.mult) >> 32);
+            }
+            static uint64_t rate_mult(uint64_t ticks, int64_t nanos) {
+                return static_cast<uint64_t>((static_cast<uint128>(nanos) << 32)/ticks);
+            }
+            //Between 100MHz and 20GHz
+            static bool plausible(uint64_t mult) {
+                double nanosPerTick = static_cast<double>(mult)/4294967296.0;
+                return nanosPerTick > 0.05 && nanosPerTick < 10.0;
+            }
+            static uint64_t interval_ticks(uint64_t mult) {
+                int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(RECALIBRATION_INTERVAL).count();
+                return static_cast<uint64_t>((static_cast<uint128>(interval) << 32)/mult);
+            }
+
+            //Reference reading bracketed by two serialized counter reads, tightest of a few tries
+            static Sample take_sample() {
+                Sample best;
+                uint64_t bestWidth = UINT64_MAX;
+                for (int i = 0; i < 5; i++) {
+#if PASCAL_HAS_TSC
+                    unsigned aux;
+                    uint64_t before = __rdtscp(&aux);
+                    int64_t nanos = reference_nanos();
+                    uint64_t after = __rdtscp(&aux);
+#else
+                    uint64_t before = 0, after = 0;
+                    int64_t nanos = reference_nanos();
+#endif
+                    if (after - before < bestWidth) {
+                        bestWidth = after - before;
+                        best = {before + (after-before)/2, nanos};
+                    }
+                }
+                return best;
+            }
+
+            static Params load_params() {
+                State& s = state();
+                return s.seqlock.read_consistent([&s]() {
+                    return Params{s.baseTsc.load(std::memory_order_relaxed), s.baseNanos.load(std::memory_order_relaxed),
+                                  s.mult.load(std::memory_order_relaxed), s.nextCheckTsc.load(std::memory_order_relaxed)};
+                });
+            }
+            static void store_params(const Params& p) {
+                State& s = state();
+                SeqLock::WriteGuard write(s.seqlock);
+                s.baseTsc.store(p.base_tsc, std::memory_order_relaxed);
+                s.baseNanos.store(p.base_nanos, std::memory_order_relaxed);
+                s.mult.store(p.mult, std::memory_order_relaxed);
+                s.nextCheckTsc.store(p.next_check_tsc, std::memory_order_relaxed);
+            }
+
+            //Measures the counter rate over CALIBRATION_WINDOW, once per process
+            static void initialize() {
+                State& s = state();
+                std::call_once(s.initialized, []() {
+                    State& s = state();
+                    if (!PASCAL_HAS_TSC || !invariant_tsc_supported()) {
+                        s.mode.store(Mode::FALLBACK, std::memory_order_release);
+                        return;
+                    }
+                    Sample first = take_sample();
+                    std::this_thread::sleep_for(CALIBRATION_WINDOW);
+                    Sample second = take_sample();
+                    int64_t elapsed = second.nanos - first.nanos;
+                    uint64_t ticks = second.tsc - first.tsc;
+                    uint64_t mult = elapsed > 0 && ticks > 0 ? rate_mult(ticks, elapsed) : 0;
+                    if (!plausible(mult)) {
+                        s.mode.store(Mode::FALLBACK, std::memory_order_release);
+                        return;
+                    }
+                    store_params({second.tsc, second.nanos, mult, second.tsc + interval_ticks(mult)});
+                    s.lastSample = second;
+                    s.mode.store(Mode::TSC, std::memory_order_release);
+                });
+            }
+        };
+    };
+};
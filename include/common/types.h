@@ -2,9 +2,17 @@
 #include <vector>
 #include <string>
 #include <chrono>
+#include "common/fixed_point.h"
+#include "common/symbol_registry.h"
+#include "common/small_vector.h"
 
 namespace pascal {
     namespace common {
+        //Venue a market data session belongs to, set per engine (Venue setting). Books are keyed by (venue, symbol)
+        using VenueId = uint8_t;
+        constexpr VenueId DEFAULT_VENUE = 0;
+        constexpr size_t MAX_VENUES = 4;
+
         enum Side {
             BID = '0',
             OFFER,
@@ -17,9 +25,16 @@ namespace pascal {
             DELETE
         };
 
+        //AggressorSide (2446) of a trade
+        enum AggressorSide {
+            UNKNOWN_AGGRESSOR = 0,
+            BUYER = '1',
+            SELLER = '2'
+        };
+
         struct PriceLevel {
-            double Price;
-            double Quantity;
+            Ticks Price;
+            Lots Quantity;
         };
         struct MarketDataEntry {
             Side side;
@@ -27,18 +42,39 @@ namespace pascal {
             UpdateAction update_action;
         };
 
+        //Trade (MDEntryType=2) entry of an incremental refresh
+        struct Trade {
+            SymbolId symbol_id = INVALID_SYMBOL_ID; //SymbolRegistry id
+            VenueId venue = DEFAULT_VENUE;
+            PriceLevel priceLevel{0, 0};
+            AggressorSide aggressor = UNKNOWN_AGGRESSOR;
+            uint64_t trade_id = 0; //TradeID (1003), 0 when the feed has none
+            std::chrono::high_resolution_clock::time_point recv_time{};
+        };
+
+        //Entries decoded inline before an increment spills to the heap
+        constexpr size_t INLINE_MD_ENTRIES = 32;
+        constexpr size_t INLINE_TRADES = 8;
+
         struct MarketDataIncrement {
-            std::string symbol;
-            std::vector<MarketDataEntry> md_entries;
+            SymbolId symbol_id = INVALID_SYMBOL_ID; //SymbolRegistry id
+            VenueId venue = DEFAULT_VENUE;
+            SmallVector<MarketDataEntry, INLINE_MD_ENTRIES> md_entries; //book entries
+            SmallVector<Trade, INLINE_TRADES> trades;
             std::chrono::high_resolution_clock::time_point recv_time;
-            uint32_t marketDepth;
+            uint32_t marketDepth = 0;
+            //Book update ids covered by the message (FirstBookUpdateID 25043, LastBookUpdateID 25044), 0 when the feed has none
+            uint64_t first_update_id = 0;
+            uint64_t last_update_id = 0;
         };
 
         struct MarketDataSnapshot {
-            std::string symbol;
+            SymbolId symbol_id = INVALID_SYMBOL_ID; //SymbolRegistry id
+            VenueId venue = DEFAULT_VENUE;
             std::vector<PriceLevel> bids;
             std::vector<PriceLevel> asks;
             std::chrono::high_resolution_clock::time_point recv_time;
+            uint64_t last_update_id = 0; //LastBookUpdateID (25044) the snapshot is current as of, 0 when the feed has none
         };
 
         enum MarketDataSubscriptionType {
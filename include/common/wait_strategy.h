@@ -0,0 +1,168 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include "common/cpu.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+namespace pascal {
+    namespace common {
+        //What a consumer thread does when its queue is empty, ordered from lowest latency/most CPU to least
+        enum class WaitStrategyType {
+            BUSY_SPIN,  //poll again immediately
+            PAUSE_SPIN, //poll again after a pause instruction
+            SPIN_YIELD, //pause spin for spin_count polls, then yield the core between polls
+            SPIN_PARK   //pause spin for spin_count polls, then sleep on a futex until the producer notifies
+        };
+
+        struct WaitStrategyConfig {
+            WaitStrategyType type = WaitStrategyType::SPIN_PARK;
+            uint32_t spin_count = 10000;                        //empty polls spun before yielding/parking
+            std::chrono::microseconds park_timeout{1000};       //upper bound on a single park
+        };
+
+        struct WaitStats {
+            uint64_t spins = 0;    //empty polls answered by spinning
+            uint64_t yields = 0;   //empty polls answered by yielding
+            uint64_t parks = 0;    //times the consumer slept on the futex
+            uint64_t wakeups = 0;  //idle periods that ended with work
+            uint64_t notifies = 0; //futex wakes issued by producers
+        };
+
+        //Config names, as used in the QuickFIX settings file (WaitStrategy=SPIN_PARK)
+        inline bool parse_wait_strategy(std::string_view name, WaitStrategyType& type) {
+            if (name == "BUSY_SPIN") type = WaitStrategyType::BUSY_SPIN;
+            else if (name == "PAUSE_SPIN") type = WaitStrategyType::PAUSE_SPIN;
+            else if (name == "SPIN_YIELD") type = WaitStrategyType::SPIN_YIELD;
+            else if (name == "SPIN_PARK") type = WaitStrategyType::SPIN_PARK;
+            else return false;
+            return true;
+        }
+
+        //Idle policy shared by one consumer and its producer(s).
+        //The consumer calls idle() after every empty poll and on_work() after every poll that found work,
+        //the producer calls notify() after publishing. notify() only costs a fence and a load unless the
+        //consumer is actually parked. Counters are single writer and can be read from any thread.
+        class WaitStrategy {
+        public:
+            explicit WaitStrategy(const WaitStrategyConfig& config = {}) : config(config) {}
+
+            WaitStrategy(const WaitStrategy&) = delete;
+            WaitStrategy& operator=(const WaitStrategy&) = delete;
+
+            //Only while neither side is running
+            void configure(const WaitStrategyConfig& newConfig) {
+                config = newConfig;
+            }
+            const WaitStrategyConfig& get_config() const {
+                return config;
+            }
+
+            //Consumer side. ready() rechecks for work (or shutdown) right before the thread parks
+            template<typename Ready>
+            void idle(Ready&& ready) {
+                idleRounds++;
+                switch (config.type) {
+                    case WaitStrategyType::BUSY_SPIN :
+                        bump(spins);
+                        return;
+                    case WaitStrategyType::PAUSE_SPIN :
+                        bump(spins);
+                        cpu_relax();
+                        return;
+                    default :
+                        break;
+                }
+                if (idleRounds <= config.spin_count) {
+                    bump(spins);
+                    cpu_relax();
+                }
+                else if (config.type == WaitStrategyType::SPIN_YIELD) {
+                    bump(yields);
+                    std::this_thread::yield();
+                }
+                else {
+                    park(ready);
+                }
+            }
+            void on_work() {
+                if (!idleRounds) return;
+                bump(wakeups);
+                idleRounds = 0;
+            }
+
+            //Producer side, call after the item is published
+            void notify() {
+                if (config.type != WaitStrategyType::SPIN_PARK) return;
+                //Pairs with the fence in park(): either the consumer sees the new item or we see it parked
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!parked.load(std::memory_order_relaxed)) return;
+                parked.store(0, std::memory_order_relaxed);
+                futex_wake();
+                notifies.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            WaitStats get_stats() const {
+                WaitStats stats;
+                stats.spins = spins.load(std::memory_order_relaxed);
+                stats.yields = yields.load(std::memory_order_relaxed);
+                stats.parks = parks.load(std::memory_order_relaxed);
+                stats.wakeups = wakeups.load(std::memory_order_relaxed);
+                stats.notifies = notifies.load(std::memory_order_relaxed);
+                return stats;
+            }
+
+        private:
+            WaitStrategyConfig config;
+
+            //Consumer line
+            alignas(CACHE_LINE_SIZE) uint64_t idleRounds = 0;
+            std::atomic<uint64_t> spins{0};
+            std::atomic<uint64_t> yields{0};
+            std::atomic<uint64_t> parks{0};
+            std::atomic<uint64_t> wakeups{0};
+            //Shared line, written by the consumer before parking and by whoever wakes it
+            alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> parked{0};
+            std::atomic<uint64_t> notifies{0};
+
+            static void bump(std::atomic<uint64_t>& counter) {
+                counter.store(counter.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+            }
+
+            template<typename Ready>
+            void park(Ready& ready) {
+                parked.store(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!ready()) {
+                    bump(parks);
+                    futex_wait();
+                }
+                parked.store(0, std::memory_order_relaxed);
+            }
+
+            void futex_wait() {
+#ifdef __linux__
+                timespec timeout;
+                timeout.tv_sec = config.park_timeout.count() / 1000000;
+                timeout.tv_nsec = (config.park_timeout.count() % 1000000) * 1000;
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&parked), FUTEX_WAIT_PRIVATE, 1, &timeout, nullptr, 0);
+#else
+                std::this_thread::sleep_for(config.park_timeout);
+#endif
+            }
+            void futex_wake() {
+#ifdef __linux__
+                syscall(SYS_futex, reinterpret_cast<uint32_t*>(&parked), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+            }
+        };
+    };
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include "common/types.h"
+#include "common/cpu.h"
+#include "common/seqlock.h"
+#include "common/symbol_registry.h"
+#include "market_data/order_book.h"
+#include <atomic>
+#include <array>
+#include <memory>
+
+namespace pascal {
+    namespace market_data {
+        //Top of book microstructure values of one symbol. Prices stay in ticks and sizes in lots, scale them with
+        //the book's InstrumentSpec at the API edge
+        struct BookAnalytics {
+            uint64_t book_version = 0; //book version the values were computed from
+            bool valid = false;        //both sides quoted and the book synchronized
+
+            pascal::common::PriceLevel best_bid{0, 0};
+            pascal::common::PriceLevel best_ask{0, 0};
+            pascal::common::Ticks spread = 0;
+            double mid = 0.0;
+            double microprice = 0.0; //mid weighted towards the side with less size at the touch
+
+            //Over the top DEPTH levels of each side
+            pascal::common::Lots bid_depth = 0;
+            pascal::common::Lots ask_depth = 0;
+            double imbalance = 0.0;       //(bid_depth - ask_depth) / (bid_depth + ask_depth), in [-1, 1]
+            double bid_depth_price = 0.0; //quantity weighted price of the bid levels
+            double ask_depth_price = 0.0;
+        };
+
+        //Per symbol analytics published by the symbol processing threads, indexed by SymbolId.
+        //Each slot is its own seqlock: the single writer of a symbol brackets the store and readers copy the
+        //struct out and retry if it moved underneath them, a load is a few cache line reads and never copies levels
+        class BookAnalyticsTable {
+        public:
+            static constexpr size_t DEPTH = 10;
+
+            BookAnalyticsTable() : slots(std::make_unique<Slot[]>(pascal::common::SymbolRegistry::MAX_SYMBOLS)) {}
+
+            BookAnalyticsTable(const BookAnalyticsTable&) = delete;
+            BookAnalyticsTable& operator=(const BookAnalyticsTable&) = delete;
+
+            //Writer side, only from the symbol's processing thread (FIXOrderBookManager::set_analytics wires it up).
+            //refresh recomputes the symbol's values from book, on_increment skips that when every entry of update
+            //lies behind the levels the values were taken from
+            void refresh(pascal::common::SymbolId id, const OrderBook& book);
+            void on_increment(const pascal::common::MarketDataIncrement& update, const OrderBook& book);
+
+            //Reader side, false until the symbol has been published once
+            bool load(pascal::common::SymbolId id, BookAnalytics& out) const {
+                if (id >= pascal::common::SymbolRegistry::MAX_SYMBOLS) return false;
+                const Slot& slot = slots[id];
+                if (!slot.seqlock.written()) return false;
+                out = slot.seqlock.read_consistent([&slot]() {
+                    return slot.values;
+                });
+                return true;
+            }
+
+            //Statistics
+            uint64_t get_recomputes() const;
+            uint64_t get_skipped_updates() const; //increments that could not move the published values
+
+        private:
+            struct alignas(pascal::common::CACHE_LINE_SIZE) Slot {
+                pascal::common::SeqLock seqlock;
+                BookAnalytics values;
+                //Writer only, the outermost prices the values were computed over. Both sides DEPTH levels deep
+                //or the boundary is unset and every update recomputes
+                pascal::common::Ticks bid_boundary = 0;
+                pascal::common::Ticks ask_boundary = 0;
+                bool bounded = false;
+                bool synchronized = false;
+            };
+            std::unique_ptr<Slot[]> slots;
+
+            std::atomic<uint64_t> recomputes{0};
+            std::atomic<uint64_t> skipped_updates{0};
+
+            void recompute(Slot& slot, const OrderBook& book);
+        };
+    };
+};
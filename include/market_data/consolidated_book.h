@@ -0,0 +1,159 @@
+#pragma once
+#include "common/types.h"
+#include "common/cpu.h"
+#include "common/seqlock.h"
+#include "common/symbol_registry.h"
+#include "market_data/order_book.h"
+#include "market_data/fix_order_book.h"
+#include "market_data/pipeline.h"
+#include <atomic>
+#include <array>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace pascal {
+    namespace market_data {
+        //One price of the consolidated book, quantity is the sum of venue_quantity
+        struct ConsolidatedLevel {
+            pascal::common::Ticks price;
+            pascal::common::Lots quantity;
+            std::array<pascal::common::Lots, pascal::common::MAX_VENUES> venue_quantity;
+        };
+
+        //Best bid and offer over every venue, quantities summed over the venues quoting the price
+        struct CrossVenueBBO {
+            pascal::common::PriceLevel bid{0, 0};
+            pascal::common::PriceLevel ask{0, 0};
+            uint32_t bid_venues = 0; //bit v set when venue v quotes the best bid
+            uint32_t ask_venues = 0;
+            uint64_t sequence = 0;   //counts the changes of the symbol's BBO
+
+            //One venue bids at or above what another offers
+            bool crossed() const {
+                return bid.Quantity > 0 && ask.Quantity > 0 && bid.Price >= ask.Price;
+            }
+        };
+
+        //Levels of one symbol merged over the venue books, kept up to date entry by entry rather than rebuilt.
+        //Only synchronized venue books contribute: a venue is folded in whole when its book (re)synchronizes and
+        //taken out when it goes stale. The venues' processing threads serialize on a writer spin lock, which only
+        //collides when two venues update the same symbol at once, and readers never lock (seqlock as OrderBook)
+        class ConsolidatedBook {
+        public:
+            //Levels kept per side, reserved up front so readers never see the storage move. Levels behind them
+            //are held by the writer with their venue quantities and move up as better ones go
+            static constexpr size_t MAX_LEVELS = 4096;
+
+            ConsolidatedBook(const std::string& symbol, const pascal::common::InstrumentSpec& spec);
+
+            ConsolidatedBook(const ConsolidatedBook&) = delete;
+            ConsolidatedBook& operator=(const ConsolidatedBook&) = delete;
+
+            //Writer side, called by the venue's processing thread after venueBook has taken the event. Return true
+            //and fill bbo when the cross-venue BBO changed
+            bool apply_increment(pascal::common::VenueId venue, const pascal::common::MarketDataIncrement& update, const OrderBook& venueBook, CrossVenueBBO& bbo);
+            //Replaces the venue's levels with venueBook's, or takes them out while venueBook is unsynchronized
+            bool apply_book(pascal::common::VenueId venue, const OrderBook& venueBook, CrossVenueBBO& bbo);
+
+            //Query interface, best first
+            CrossVenueBBO get_bbo() const;
+            size_t get_bids(std::span<ConsolidatedLevel> out) const;
+            size_t get_asks(std::span<ConsolidatedLevel> out) const;
+            uint32_t get_venues() const; //bit v set while venue v contributes
+
+            const std::string& get_symbol() const;
+            const pascal::common::InstrumentSpec& get_instrument_spec() const;
+            uint64_t get_version() const;
+
+        private:
+            pascal::common::SeqLock seqlock;
+            std::atomic_flag writer = ATOMIC_FLAG_INIT;
+            std::string symbol;
+            pascal::common::InstrumentSpec spec;
+
+            std::vector<ConsolidatedLevel> bids; //ascending, best at the back
+            std::vector<ConsolidatedLevel> asks; //descending, best at the back
+            CrossVenueBBO bbo;
+            uint32_t venues = 0; //only under the writer lock
+            std::vector<pascal::common::PriceLevel> scratch; //writer only, venue levels while folding a book in
+            //Writer only, levels past MAX_LEVELS ordered like the kept ones. Worse than every kept level, so the
+            //best of them sits at the back and is the next one to move up
+            std::vector<ConsolidatedLevel> deepBids;
+            std::vector<ConsolidatedLevel> deepAsks;
+
+            //Writer lock and seqlock around one change, end_update returns true when the BBO moved
+            void begin_update();
+            bool end_update(CrossVenueBBO& out);
+            //Under the writer lock
+            void fold_book(pascal::common::VenueId venue, const OrderBook& venueBook, bool synchronized);
+            void set_level(pascal::common::VenueId venue, pascal::common::Side side, pascal::common::Ticks price, pascal::common::Lots quantity);
+            static void refill(std::vector<ConsolidatedLevel>& levels, std::vector<ConsolidatedLevel>& deep);
+            void clear_venue(pascal::common::VenueId venue);
+        };
+
+        //Book manager for several venues: one FIXOrderBookManager per venue keyed by the events' venue, so the
+        //books are keyed by (venue, symbol), and a ConsolidatedBook per symbol across them. Engines of several
+        //venues feed it directly or through a ConsolidatedBookUpdateStage. Symbols are added before messages flow
+        class ConsolidatedBookManager {
+        public:
+            //Called on the processing thread of the venue that moved the BBO
+            using BboHandler = std::function<void(pascal::common::SymbolId, const CrossVenueBBO&)>;
+
+            ConsolidatedBookManager();
+
+            ConsolidatedBookManager(const ConsolidatedBookManager&) = delete;
+            ConsolidatedBookManager& operator=(const ConsolidatedBookManager&) = delete;
+
+            //Returns the symbol's registry id, INVALID_SYMBOL_ID when the registry is full, the venue is out of
+            //range or spec differs from the symbol's spec on another venue (consolidated levels share one tick grid)
+            pascal::common::SymbolId add_symbol(pascal::common::VenueId venue, const std::string& symbol, const pascal::common::InstrumentSpec& spec = {}, BookType type = BookType::VECTOR);
+
+            //Book processors, events of venues or symbols without a book are dropped
+            void process_snapshot(pascal::common::MarketDataSnapshot& snapshot);
+            void process_increment(const pascal::common::MarketDataIncrement& update);
+
+            //Set before messages flow
+            void set_bbo_handler(BboHandler handler);
+
+            //Manager of one venue's books, for its resync handler, analytics or publisher
+            FIXOrderBookManager& get_venue(pascal::common::VenueId venue);
+
+            //Query interface
+            std::shared_ptr<OrderBook> get_book(pascal::common::VenueId venue, pascal::common::SymbolId id);
+            std::shared_ptr<OrderBook> get_book_by_symbol(pascal::common::VenueId venue, const std::string& symbol);
+            const ConsolidatedBook* get_consolidated(pascal::common::SymbolId id) const;
+            const ConsolidatedBook* get_consolidated_by_symbol(const std::string& symbol) const;
+
+            //Statistics
+            uint64_t get_bbo_changes() const;
+
+        private:
+            struct SymbolBooks {
+                ConsolidatedBook consolidated;
+                std::array<std::shared_ptr<OrderBook>, pascal::common::MAX_VENUES> venues; //keeps the books the hot path points at
+
+                SymbolBooks(const std::string& symbol, const pascal::common::InstrumentSpec& spec) : consolidated(symbol, spec) {}
+            };
+
+            std::array<std::unique_ptr<FIXOrderBookManager>, pascal::common::MAX_VENUES> venueManagers;
+            //Indexed by SymbolId, sized up front so the processing threads can index it without locking
+            std::vector<std::unique_ptr<SymbolBooks>> symbols = std::vector<std::unique_ptr<SymbolBooks>>(pascal::common::SymbolRegistry::MAX_SYMBOLS);
+            BboHandler bboHandler;
+
+            std::atomic<uint64_t> bbo_changes{0};
+
+            //Null for events that have no book
+            inline SymbolBooks* symbol_books(pascal::common::VenueId venue, pascal::common::SymbolId id) const {
+                if (venue >= pascal::common::MAX_VENUES || id >= symbols.size()) return nullptr;
+                SymbolBooks* books = symbols[id].get();
+                return books && books->venues[venue] ? books : nullptr;
+            }
+            void publish_bbo(pascal::common::SymbolId id, const CrossVenueBBO& bbo);
+        };
+
+        using ConsolidatedBookUpdateStage = BasicBookUpdateStage<ConsolidatedBookManager>;
+    };
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include "common/types.h"
+#include "market_data/order_book.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace pascal {
+    namespace market_data {
+        //Book engine backed by a tick indexed array ladder covering a window of prices around the touch.
+        //Level insert/change/delete inside the window is an array store plus a bitmap update, and the
+        //best price is tracked directly. Levels outside the window (deep in the book) are kept in small
+        //sorted vectors and the window is recentred on the mid when the touch drifts towards its edges.
+        class FIXLadderOrderBook : public OrderBook {
+        public:
+            static constexpr size_t DEFAULT_WINDOW_TICKS = 1 << 14;
+            static constexpr size_t MAX_FAR_LEVELS = 10000;
+
+            //window_ticks is rounded up to a multiple of 4096 (one summary word)
+            FIXLadderOrderBook(const std::string& symbol, const pascal::common::InstrumentSpec& spec = {}, size_t window_ticks = DEFAULT_WINDOW_TICKS);
+
+            //Book reconstruction interface
+            void initialize_from_snapshot(pascal::common::MarketDataSnapshot& snapshot) override;
+            void update_from_increment(const pascal::common::MarketDataIncrement& update) override;
+
+            //Statistics
+            uint64_t get_total_recenters() const;
+
+        protected:
+            pascal::common::PriceLevel best_bid_level() const override;
+            pascal::common::PriceLevel best_ask_level() const override;
+            size_t copy_bids(pascal::common::PriceLevel* out, size_t depth) const override;
+            size_t copy_asks(pascal::common::PriceLevel* out, size_t depth) const override;
+            pascal::common::Lots bid_quantity_at(pascal::common::Ticks price) const override;
+            pascal::common::Lots ask_quantity_at(pascal::common::Ticks price) const override;
+            size_t bid_levels() const override;
+            size_t ask_levels() const override;
+
+        private:
+            //One side of the window. Occupied ticks are tracked in a two level bitmap so the next
+            //best level is found with at most a couple of bit scans.
+            struct Ladder {
+                std::vector<pascal::common::Lots> qty;
+                std::vector<uint64_t> bits;     //one bit per tick
+                std::vector<uint64_t> summary;  //one bit per non empty word of bits
+                size_t levels = 0;
+
+                void resize(size_t ticks);
+                void reset();
+                void set(ptrdiff_t idx, pascal::common::Lots quantity);
+                void clear(ptrdiff_t idx);
+                ptrdiff_t highest_at_or_below(ptrdiff_t idx) const; //-1 if none
+                ptrdiff_t lowest_at_or_above(ptrdiff_t idx) const;  //-1 if none
+            };
+
+            ptrdiff_t window;
+            pascal::common::Ticks base_{0}; //price of index 0
+            bool anchored_{false};
+
+            Ladder bidLadder;
+            Ladder askLadder;
+            ptrdiff_t bestBid_{-1};
+            ptrdiff_t bestAsk_{-1};
+
+            std::vector<pascal::common::PriceLevel> farBids; //outside the window, best (highest) first
+            std::vector<pascal::common::PriceLevel> farAsks; //outside the window, best (lowest) first
+
+            std::vector<pascal::common::PriceLevel> scratchBids; //reused while recentring
+            std::vector<pascal::common::PriceLevel> scratchAsks;
+            uint64_t total_recenters{0};
+
+            void apply_level(pascal::common::Side side, pascal::common::Ticks price, pascal::common::UpdateAction action, pascal::common::Lots quantity);
+            void apply_far_level(pascal::common::Side side, pascal::common::Ticks price, pascal::common::UpdateAction action, pascal::common::Lots quantity);
+            void recenter(pascal::common::Ticks center);
+            void maybe_recenter();
+            void clear_book();
+
+            static pascal::common::Lots next_quantity(pascal::common::UpdateAction action, pascal::common::Lots current, pascal::common::Lots quantity) {
+                switch (action) {
+                    case pascal::common::UpdateAction::NEW :
+                        return current + quantity;
+                    case pascal::common::UpdateAction::DELETE :
+                        return current - quantity;
+                    default :
+                        return quantity;
+                }
+            }
+        };
+    };
+};
@@ -1,104 +1,113 @@
 #pragma once
 #include "common/types.h"
-#include <shared_mutex>
+#include "common/cpu.h"
+#include "common/epoch_domain.h"
+#include "market_data/order_book.h"
+#include "market_data/book_analytics.h"
+#include "market_data/shm_book.h"
+#include <mutex>
 #include <atomic>
 #include <vector>
-#include <unordered_map>
+#include <deque>
 #include <memory>
 #include <algorithm>
+#include <functional>
+#include <array>
+#include <bit>
+#include <iterator>
 
 
 #define MAX_ORDERS 10000
 
 namespace pascal {
     namespace market_data {
-        class FIXOrderBook {
+        class FIXOrderBook : public OrderBook {
         public:
 
-            FIXOrderBook(const std::string& symbol) : symbol(symbol) {
+            FIXOrderBook(const std::string& symbol, const pascal::common::InstrumentSpec& spec = {}) : OrderBook(symbol, spec) {
                 //prevent resizing
                 bids.reserve(MAX_ORDERS);
                 asks.reserve(MAX_ORDERS);
+                mergeTail.reserve(MAX_ORDERS);
+                mergeEntries.reserve(MAX_MERGE_ENTRIES);
             }
             
             //Book reconstruction interface
-            void initialize_from_snapshot(pascal::common::MarketDataSnapshot& snapshot);
-            void update_from_increment(const pascal::common::MarketDataIncrement& update);
+            void initialize_from_snapshot(pascal::common::MarketDataSnapshot& snapshot) override;
+            void update_from_increment(const pascal::common::MarketDataIncrement& update) override;
 
-            //Query interface
-            pascal::common::PriceLevel get_best_bid() const;
-            pascal::common::PriceLevel get_best_ask() const;
-            std::vector<pascal::common::PriceLevel> get_bids(size_t depth = 10) const;
-            std::vector<pascal::common::PriceLevel> get_asks(size_t depth = 10) const;
-            double get_bid_quantity_at_price(double price);
-            double get_ask_quantity_at_price(double price);
-
-            //Book state
-            bool is_synchronized() const;
-            std::chrono::high_resolution_clock::time_point get_last_update_time() const;
-
-            //Statistics
-            size_t get_total_bid_levels() const;
-            size_t get_total_ask_levels() const;
-            uint64_t get_total_updates_processed() const;
+        protected:
+            pascal::common::PriceLevel best_bid_level() const override;
+            pascal::common::PriceLevel best_ask_level() const override;
+            size_t copy_bids(pascal::common::PriceLevel* out, size_t depth) const override;
+            size_t copy_asks(pascal::common::PriceLevel* out, size_t depth) const override;
+            pascal::common::Lots bid_quantity_at(pascal::common::Ticks price) const override;
+            pascal::common::Lots ask_quantity_at(pascal::common::Ticks price) const override;
+            size_t bid_levels() const override;
+            size_t ask_levels() const override;
 
         private:
             using BidMap = std::vector<pascal::common::PriceLevel>; //ascending bids
             using AskMap = std::vector<pascal::common::PriceLevel>; //descending asks
 
-            std::atomic<uint64_t> version_{0};
-            std::string symbol;
             BidMap bids;
             AskMap asks;
 
-            std::atomic<bool> is_synchronized_{false};
-            std::atomic<uint64_t> total_updates_processed{0};
-            std::chrono::high_resolution_clock::time_point last_update_time;
+            //One side's entries of a multi-entry increment, seq keeps message order between entries at one price
+            struct MergeEntry {
+                pascal::common::Ticks price;
+                pascal::common::Lots quantity;
+                pascal::common::UpdateAction action;
+                uint32_t seq;
+            };
+            static constexpr size_t MAX_MERGE_ENTRIES = 256; //reserved up front, wider messages grow it once
+            std::vector<MergeEntry> mergeEntries;
+            std::vector<pascal::common::PriceLevel> mergeTail; //levels from the first touched price on, reused per message
 
+            //Sorts the side's entries into storage order and merges them into levels in one pass. before(a, b) is
+            //true when price a is stored ahead of price b
+            template<typename Before>
+            void merge_side(pascal::common::Side side, const pascal::common::MarketDataIncrement& update, std::vector<pascal::common::PriceLevel>& levels, Before before);
+
+            //Appends [first, last) behind levels, both in storage order. A side never grows past MAX_ORDERS since
+            //readers walk its reserved storage without locking, the worst levels (front) are dropped to make room
+            template<typename It>
+            static void append_levels(std::vector<pascal::common::PriceLevel>& levels, It first, It last) {
+                size_t incoming = std::distance(first, last);
+                if (incoming > MAX_ORDERS) {
+                    first += incoming - MAX_ORDERS;
+                    incoming = MAX_ORDERS;
+                }
+                if (levels.size() + incoming > MAX_ORDERS) levels.erase(levels.begin(), levels.begin() + (levels.size() + incoming - MAX_ORDERS));
+                levels.insert(levels.end(), first, last);
+            }
+
+            //Top of book stream, the entry acts on the best level. A side without levels (no snapshot yet) takes
+            //the entry as its first level
             inline void apply_price_level(pascal::common::Side side, const pascal::common::PriceLevel& priceLevel) {
-                if (side == pascal::common::Side::BID) {
-                    auto bestIt = bids.end()-1;
-                    if (bestIt->Price == priceLevel.Price) {
-                        bestIt->Quantity += priceLevel.Quantity;
-                    }
-                    else {
-                        bids.emplace_back(priceLevel);
-                    }
+                auto& levels = side == pascal::common::Side::BID ? bids : asks;
+                if (!levels.empty() && levels.back().Price == priceLevel.Price) {
+                    levels.back().Quantity += priceLevel.Quantity;
                 }
-                else {
-                    auto bestIt = asks.end()-1;
-                    if (bestIt->Price == priceLevel.Price) {
-                        bestIt->Quantity += priceLevel.Quantity;
-                    }
-                    else {
-                        asks.emplace_back(priceLevel);
-                    }
+                else if (priceLevel.Quantity > 0) {
+                    append_levels(levels, &priceLevel, &priceLevel + 1);
                 }
             }
             inline void delete_price_level(pascal::common::Side side, const pascal::common::PriceLevel& priceLevel) {
-                if (side == pascal::common::Side::BID) {
-                    auto bestIt = bids.end()-1;
-                    bestIt->Quantity -= priceLevel.Quantity;
-                    if (!bestIt->Quantity) {
-                        bids.pop_back();
-                    }
-                }
-                else {
-                    auto bestIt = asks.end()-1;
-                    bestIt->Quantity -= priceLevel.Quantity;
-                    if (!bestIt->Quantity) {
-                        asks.pop_back();
-                    }
+                auto& levels = side == pascal::common::Side::BID ? bids : asks;
+                if (levels.empty()) return;
+                levels.back().Quantity -= priceLevel.Quantity;
+                if (levels.back().Quantity <= 0) {
+                    levels.pop_back();
                 }
             }
             inline void change_best_quote(pascal::common::Side side, const pascal::common::PriceLevel& priceLevel) {
-                if (side == pascal::common::Side::BID) {
-                    auto bestIt = bids.end()-1;
-                    *bestIt = priceLevel;
+                auto& levels = side == pascal::common::Side::BID ? bids : asks;
+                if (!levels.empty()) {
+                    levels.back() = priceLevel;
                 }
-                else {
-                    auto bestIt = asks.rbegin();
-                    *bestIt = priceLevel;
+                else if (priceLevel.Quantity > 0) {
+                    append_levels(levels, &priceLevel, &priceLevel + 1);
                 }
             }
             inline void change_quote(pascal::common::Side side, const pascal::common::PriceLevel& priceLevel) {
@@ -106,7 +115,7 @@ namespace pascal {
                     auto it = std::find_if(bids.begin(), bids.end(), [priceLevel](auto& a) {
                         return a.Price == priceLevel.Price;
                     });
-                    if (priceLevel.Quantity == 0) {
+                    if (priceLevel.Quantity <= 0) {
                         bids.erase(it);
                     }
                     else {
@@ -117,7 +126,7 @@ namespace pascal {
                     auto it = std::find_if(asks.begin(), asks.end(), [priceLevel](auto& a) {
                         return a.Price == priceLevel.Price;
                     });
-                    if (priceLevel.Quantity == 0) {
+                    if (priceLevel.Quantity <= 0) {
                         asks.erase(it);
                     }
                     else {
@@ -130,30 +139,138 @@ namespace pascal {
 
         class FIXOrderBookManager {
         public:
+            //Called on the symbol's processing thread when a sequence gap leaves its book stale, e.g.
+            //FIXMarketDataEngine::request_snapshot
+            using ResyncHandler = std::function<void(pascal::common::SymbolId)>;
+
+            //Increments buffered per stale book while its snapshot is on the way, the oldest are dropped past this
+            static constexpr size_t MAX_PENDING_UPDATES = 4096;
+
             FIXOrderBookManager() {}
 
-            //Book manager
-            void add_symbol(const std::string& symbol);
+            //Book manager, returns the symbol's registry id (INVALID_SYMBOL_ID when the registry is full)
+            pascal::common::SymbolId add_symbol(const std::string& symbol, const pascal::common::InstrumentSpec& spec = {}, BookType type = BookType::VECTOR);
             void remove_symbol(const std::string& symbol);
 
-            //Book processors
+            //Book processors, messages for symbols without a book are dropped.
+            //Increments carrying book update ids are sequenced: ones already covered by the book are skipped and a gap
+            //marks the book unsynchronized, buffers what follows and asks the resync handler for a snapshot. The
+            //snapshot is applied and the buffered increments replayed on top of it. Increments without ids are
+            //applied as they come.
             void process_snapshot(pascal::common::MarketDataSnapshot& snapshot);
             void process_increment(const pascal::common::MarketDataIncrement& update);
 
-            //Query interface
-            std::shared_ptr<FIXOrderBook> get_book_by_symbol(const std::string& symbol);
+            //Set before messages flow
+            void set_resync_handler(ResyncHandler handler);
+
+            //Conflation, off by default and set before messages flow. Every book update marks its symbol dirty
+            //without waiting on anyone; consumers pull the symbols updated since their last pull and read the
+            //book's newest state, skipping the intermediate ones
+            void set_conflation(bool enabled);
+            //Calls fn(SymbolId, const OrderBook&) once per book updated since the last drain, returns how many
+            template<typename Fn>
+            size_t drain_conflated(Fn&& fn) {
+                size_t delivered = 0;
+                for (size_t word = 0; word < dirtySymbols.size(); word++) {
+                    uint64_t bits = dirtySymbols[word].bits.exchange(0, std::memory_order_acquire);
+                    while (bits) {
+                        pascal::common::SymbolId id = static_cast<pascal::common::SymbolId>(word*64 + std::countr_zero(bits));
+                        bits &= bits-1;
+                        pascal::common::EpochDomain::Guard guard(epochs);
+                        if (const OrderBook* book = book_for(id)) {
+                            fn(id, *book);
+                            delivered++;
+                        }
+                    }
+                }
+                conflation_deliveries.fetch_add(delivered, std::memory_order_relaxed);
+                return delivered;
+            }
+            //Clears the symbol's dirty flag, true when its book was updated since the last pull
+            bool take_conflated(pascal::common::SymbolId id);
+
+            //Keeps table's per symbol analytics current with every book change, null detaches. Set before messages flow
+            void set_analytics(BookAnalyticsTable* table);
+            //Mirrors every book change into a shared memory region for other processes, null detaches. Set before messages flow
+            void set_publisher(ShmBookPublisher* shm);
+
+            //Query interface, lock free. The books are shared with the manager and outlive a remove_symbol for as
+            //long as a caller holds them
+            std::shared_ptr<OrderBook> get_book_by_symbol(const std::string& symbol);
+            std::shared_ptr<OrderBook> get_book(pascal::common::SymbolId id);
             std::vector<std::string> get_symbols() const;
 
             //Statistics
             size_t get_total_books() const;
             uint64_t get_total_updates_processed() const;
+            uint64_t get_total_sequence_gaps() const;
+            uint64_t get_conflated_updates() const;  //updates folded into one a consumer had not pulled yet, summed over symbols
+            uint64_t get_conflated_updates(pascal::common::SymbolId id) const;
+            uint64_t get_conflation_deliveries() const;
 
         private:
-            std::unordered_map<std::string, std::shared_ptr<FIXOrderBook>> books;
-            mutable std::shared_mutex book_mtx;
+            //Update id bookkeeping of one book, only touched by the symbol's processing thread
+            struct BookSequence {
+                uint64_t last_update_id = 0; //last id applied to the book, 0 until the feed sends ids
+                uint64_t last_first_id = 0;  //first id of the last applied message, fragments of a message repeat both
+                bool resync_requested = false;
+                uint64_t overflowed = 0;     //buffered updates dropped since the last snapshot
+                std::deque<pascal::common::MarketDataIncrement> pending;
+            };
+
+            struct BookEntry {
+                std::shared_ptr<OrderBook> book;
+                std::shared_ptr<BookSequence> sequence;
+            };
+            //Immutable once published, indexed by SymbolId. add_symbol and remove_symbol publish a changed copy and
+            //retire the old one to epochs, so a lookup is a guard and two pointer loads and touches no reference count
+            struct BookTable {
+                std::array<BookEntry, pascal::common::SymbolRegistry::MAX_SYMBOLS> entries;
+                size_t totalBooks = 0;
+            };
+            std::shared_ptr<const BookTable> currentTable = std::make_shared<const BookTable>(); //writers only, under table_mtx
+            std::atomic<const BookTable*> table{currentTable.get()};
+            mutable pascal::common::EpochDomain epochs;
+            std::mutex table_mtx;
+            ResyncHandler resyncHandler;
 
             std::atomic<uint64_t> total_updates_processed{0};
+            std::atomic<uint64_t> total_sequence_gaps{0};
+
+            //One bit per SymbolId, set by the processing threads and cleared by the consumers' pulls. Each word
+            //sits on its own cache line so workers marking different words do not contend
+            struct alignas(pascal::common::CACHE_LINE_SIZE) DirtyWord {
+                std::atomic<uint64_t> bits{0};
+            };
+            bool conflation = false;
+            std::array<DirtyWord, pascal::common::SymbolRegistry::MAX_SYMBOLS/64> dirtySymbols{};
+            std::unique_ptr<std::atomic<uint64_t>[]> conflatedUpdates = std::make_unique<std::atomic<uint64_t>[]>(pascal::common::SymbolRegistry::MAX_SYMBOLS);
+            std::atomic<uint64_t> conflation_deliveries{0};
 
+            BookAnalyticsTable* analytics = nullptr;
+            ShmBookPublisher* publisher = nullptr;
+
+            //Under a Guard of epochs, the entry stays valid until the guard is released
+            inline const BookEntry* entry_for(pascal::common::SymbolId id) const {
+                if (id >= pascal::common::SymbolRegistry::MAX_SYMBOLS) return nullptr;
+                const BookEntry& entry = table.load(std::memory_order_seq_cst)->entries[id];
+                return entry.book ? &entry : nullptr;
+            }
+            inline OrderBook* book_for(pascal::common::SymbolId id) const {
+                const BookEntry* entry = entry_for(id);
+                return entry ? entry->book.get() : nullptr;
+            }
+            void publish_table(std::shared_ptr<const BookTable> next);
+            //Applies update if it continues the book, false on a gap
+            bool apply_in_sequence(OrderBook& book, BookSequence& sequence, const pascal::common::MarketDataIncrement& update);
+            void buffer_update(BookSequence& sequence, const pascal::common::MarketDataIncrement& update);
+            void request_resync(pascal::common::SymbolId id, BookSequence& sequence);
+            inline void mark_dirty(pascal::common::SymbolId id) {
+                if (!conflation) return;
+                uint64_t bit = uint64_t(1) << (id % 64);
+                if (dirtySymbols[id / 64].bits.fetch_or(bit, std::memory_order_release) & bit)
+                    conflatedUpdates[id].fetch_add(1, std::memory_order_relaxed);
+            }
         };
     };
-};
\ No newline at end of file
+};
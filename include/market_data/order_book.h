@@ -0,0 +1,96 @@
+#pragma once
+#include "common/types.h"
+#include "common/cpu.h"
+#include "common/seqlock.h"
+#include "common/tsc_clock.h"
+#include <atomic>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <span>
+#include <array>
+
+namespace pascal {
+    namespace market_data {
+        //Book engines selectable per symbol in FIXOrderBookManager::add_symbol
+        enum class BookType {
+            VECTOR, //sorted vectors, best level at the back (FIXOrderBook)
+            LADDER  //tick indexed array around the touch (FIXLadderOrderBook)
+        };
+
+        //Common interface and state of the book engines.
+        //The single writer (the symbol processing thread) holds a write of seqlock across every mutation.
+        //Readers never lock: they copy what they need and retry if the copy overlapped a change.
+        class OrderBook {
+        public:
+            OrderBook(const std::string& symbol, const pascal::common::InstrumentSpec& spec) : symbol(symbol), symbolId(pascal::common::SymbolRegistry::instance().register_symbol(symbol)), spec(spec) {}
+            virtual ~OrderBook() = default;
+
+            OrderBook(const OrderBook&) = delete;
+            OrderBook& operator=(const OrderBook&) = delete;
+
+            //Book reconstruction interface
+            virtual void initialize_from_snapshot(pascal::common::MarketDataSnapshot& snapshot) = 0;
+            virtual void update_from_increment(const pascal::common::MarketDataIncrement& update) = 0;
+
+            //Query interface
+            pascal::common::PriceLevel get_best_bid() const;
+            pascal::common::PriceLevel get_best_ask() const;
+            void get_top_of_book(pascal::common::PriceLevel& bid, pascal::common::PriceLevel& ask) const;
+            pascal::common::Lots get_bid_quantity_at_price(pascal::common::Ticks price) const;
+            pascal::common::Lots get_ask_quantity_at_price(pascal::common::Ticks price) const;
+
+            //Allocation free depth reads, copy the top out.size() levels best first and return how many were written
+            size_t get_bids(std::span<pascal::common::PriceLevel> out) const;
+            size_t get_asks(std::span<pascal::common::PriceLevel> out) const;
+            template<size_t N>
+            size_t get_bids(std::array<pascal::common::PriceLevel, N>& out) const {
+                return get_bids(std::span<pascal::common::PriceLevel>(out));
+            }
+            template<size_t N>
+            size_t get_asks(std::array<pascal::common::PriceLevel, N>& out) const {
+                return get_asks(std::span<pascal::common::PriceLevel>(out));
+            }
+
+            //Convenience copies, these allocate
+            std::vector<pascal::common::PriceLevel> get_bids(size_t depth = 10) const;
+            std::vector<pascal::common::PriceLevel> get_asks(size_t depth = 10) const;
+
+            //Tick/lot scaling, use for display conversions at the API edge
+            const pascal::common::InstrumentSpec& get_instrument_spec() const;
+            const std::string& get_symbol() const;
+            pascal::common::SymbolId get_symbol_id() const;
+
+            //Book state. A book is synchronized from its first snapshot until mark_unsynchronized, e.g. on a sequence gap
+            bool is_synchronized() const;
+            void mark_unsynchronized();
+            std::chrono::high_resolution_clock::time_point get_last_update_time() const;
+            uint64_t get_version() const;
+
+            //Statistics
+            size_t get_total_bid_levels() const;
+            size_t get_total_ask_levels() const;
+            uint64_t get_total_updates_processed() const;
+
+        protected:
+            pascal::common::SeqLock seqlock;
+            std::string symbol;
+            pascal::common::SymbolId symbolId;
+            pascal::common::InstrumentSpec spec;
+
+            std::atomic<bool> is_synchronized_{false};
+            std::atomic<uint64_t> total_updates_processed{0};
+            std::chrono::high_resolution_clock::time_point last_update_time;
+
+            //Unsynchronised accessors implemented by each engine, only called by the writer or inside seqlock.read_consistent
+            virtual pascal::common::PriceLevel best_bid_level() const = 0;
+            virtual pascal::common::PriceLevel best_ask_level() const = 0;
+            virtual size_t copy_bids(pascal::common::PriceLevel* out, size_t depth) const = 0;
+            virtual size_t copy_asks(pascal::common::PriceLevel* out, size_t depth) const = 0;
+            virtual pascal::common::Lots bid_quantity_at(pascal::common::Ticks price) const = 0;
+            virtual pascal::common::Lots ask_quantity_at(pascal::common::Ticks price) const = 0;
+            virtual size_t bid_levels() const = 0;
+            virtual size_t ask_levels() const = 0;
+        };
+    };
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include "common/types.h"
+#include "common/latency_histogram.h"
+#include "market_data/fix_order_book.h"
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace pascal {
+    namespace market_data {
+        //Sink that runs a fixed list of stages in order, e.g. book update, analytics, strategy.
+        //Stages are held by value and only need the handlers they care about (on_snapshot, on_increment,
+        //on_trade); the fan-out is a fold over the tuple so every call is direct and can inline.
+        template<typename... Stages>
+        class Pipeline {
+        public:
+            Pipeline() = default;
+            explicit Pipeline(Stages... stages) : stages(std::move(stages)...) {}
+
+            template<size_t I>
+            auto& get() {
+                return std::get<I>(stages);
+            }
+            template<typename Stage>
+            Stage& get() {
+                return std::get<Stage>(stages);
+            }
+
+            void on_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
+                std::apply([&snapshot](auto&... stage) {
+                    (dispatch_snapshot(stage, snapshot), ...);
+                }, stages);
+            }
+            void on_increment(const pascal::common::MarketDataIncrement& update) {
+                std::apply([&update](auto&... stage) {
+                    (dispatch_increment(stage, update), ...);
+                }, stages);
+            }
+            void on_trade(const pascal::common::Trade& trade) {
+                std::apply([&trade](auto&... stage) {
+                    (dispatch_trade(stage, trade), ...);
+                }, stages);
+            }
+
+        private:
+            std::tuple<Stages...> stages;
+
+            template<typename Stage>
+            static void dispatch_snapshot(Stage& stage, pascal::common::MarketDataSnapshot& snapshot) {
+                if constexpr (requires { stage.on_snapshot(snapshot); }) stage.on_snapshot(snapshot);
+            }
+            template<typename Stage>
+            static void dispatch_increment(Stage& stage, const pascal::common::MarketDataIncrement& update) {
+                if constexpr (requires { stage.on_increment(update); }) stage.on_increment(update);
+            }
+            template<typename Stage>
+            static void dispatch_trade(Stage& stage, const pascal::common::Trade& trade) {
+                if constexpr (requires { stage.on_trade(trade); }) stage.on_trade(trade);
+            }
+        };
+
+        //Pipeline stage applying events to the books of a manager, stamps the BOOK latency point when done
+        template<typename Manager>
+        class BasicBookUpdateStage {
+        public:
+            explicit BasicBookUpdateStage(Manager& manager) : manager(&manager) {}
+
+            void on_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
+                manager->process_snapshot(snapshot);
+                pascal::common::thread_stage_marks().book_applied = pascal::common::latency_clock_now();
+            }
+            void on_increment(const pascal::common::MarketDataIncrement& update) {
+                manager->process_increment(update);
+                pascal::common::thread_stage_marks().book_applied = pascal::common::latency_clock_now();
+            }
+
+        private:
+            Manager* manager;
+        };
+        using BookUpdateStage = BasicBookUpdateStage<FIXOrderBookManager>;
+    };
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include "common/types.h"
+#include "common/cpu.h"
+#include "common/seqlock.h"
+#include "common/symbol_registry.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pascal {
+    namespace market_data {
+        class OrderBook;
+
+        //Layout of a shared memory book region (shm_open name, e.g. "/pascal_books"): a 64 byte header followed
+        //by slot_count cache line aligned slots. The publisher owns one slot per SymbolId, readers in other
+        //processes find theirs by symbol name. Every slot is a seqlock, sequence is odd while the publisher
+        //rewrites it and 0 until the symbol's first publication
+        struct ShmBookHeader {
+            static constexpr char MAGIC[8] = {'P', 'S', 'C', 'L', 'S', 'H', 'M', 'B'};
+            static constexpr uint32_t VERSION = 1;
+
+            char magic[8];
+            uint32_t version;
+            uint32_t header_size;
+            uint32_t slot_size;
+            uint32_t slot_count;
+            uint32_t depth;
+            uint32_t reserved0;
+            int64_t created_nanos;
+            char reserved[24];
+        };
+        static_assert(sizeof(ShmBookHeader) == 64);
+
+        //Levels mirrored per side, best first
+        constexpr size_t SHM_BOOK_DEPTH = 20;
+        constexpr size_t SHM_SYMBOL_LENGTH = 24;
+
+        //Plain copy of a book's top levels, what a reader loads out of a slot
+        struct ShmBookData {
+            char symbol[SHM_SYMBOL_LENGTH]; //NUL padded, names longer than that are cut
+            pascal::common::InstrumentSpec spec; //to scale the levels to prices and quantities
+            uint64_t book_version;
+            int64_t publish_nanos;          //TscClock::now_nanos at publication
+            uint32_t synchronized;
+            uint32_t bid_count;
+            uint32_t ask_count;
+            uint32_t reserved;
+            pascal::common::PriceLevel bids[SHM_BOOK_DEPTH];
+            pascal::common::PriceLevel asks[SHM_BOOK_DEPTH];
+        };
+
+        struct alignas(pascal::common::CACHE_LINE_SIZE) ShmBookSlot {
+            pascal::common::SeqLock sequence;
+            ShmBookData data;
+        };
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "slots are shared across processes");
+
+        //Writer side, mirrors books into the region after every change (FIXOrderBookManager::set_publisher wires it
+        //up). Creates the region, or takes over an existing one of the same slot count and clears it, so readers
+        //stay attached across a publisher restart and only resolve their slots again. Throws std::runtime_error
+        //when the region cannot be created or mapped
+        class ShmBookPublisher {
+        public:
+            explicit ShmBookPublisher(const std::string& name, size_t slot_count = pascal::common::SymbolRegistry::MAX_SYMBOLS);
+            ~ShmBookPublisher();
+
+            ShmBookPublisher(const ShmBookPublisher&) = delete;
+            ShmBookPublisher& operator=(const ShmBookPublisher&) = delete;
+
+            //Only from the processing thread of the book's symbol
+            void publish(const OrderBook& book);
+
+            uint64_t get_publications() const;
+            const std::string& get_name() const;
+
+            //Removes the name, mapped regions stay valid until unmapped
+            static void unlink(const std::string& name);
+
+        private:
+            std::string name;
+            char* base = nullptr;
+            size_t mapped = 0;
+            size_t slotCount = 0;
+            std::atomic<uint64_t> publications{0};
+        };
+
+        //Reader side for strategy processes, maps the region read only. Loads are lock-free and cost a copy of the
+        //slot, retried only when it raced a publication. Throws std::runtime_error for missing or foreign regions
+        class ShmBookReader {
+        public:
+            static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+            explicit ShmBookReader(const std::string& name);
+            ~ShmBookReader();
+
+            ShmBookReader(const ShmBookReader&) = delete;
+            ShmBookReader& operator=(const ShmBookReader&) = delete;
+
+            //Slot of a published symbol, NOT_FOUND until its book has been published once. Resolve once, load often
+            size_t find(const std::string& symbol) const;
+            size_t get_slot_count() const;
+            //False once a restarted publisher has taken the region over, resolved slots must be found again
+            bool is_current() const;
+
+            //False for slots never published
+            bool load(size_t slot, ShmBookData& out) const {
+                return read_consistent(slot, [&out](const ShmBookData& data) {
+                    out = data;
+                });
+            }
+            bool load_bbo(size_t slot, pascal::common::PriceLevel& bid, pascal::common::PriceLevel& ask) const {
+                return read_consistent(slot, [&bid, &ask](const ShmBookData& data) {
+                    bid = data.bid_count ? data.bids[0] : pascal::common::PriceLevel{0, 0};
+                    ask = data.ask_count ? data.asks[0] : pascal::common::PriceLevel{0, 0};
+                });
+            }
+
+        private:
+            const char* base = nullptr;
+            size_t mapped = 0;
+            size_t slotCount = 0;
+            int64_t createdNanos = 0; //of the publisher the slots were resolved against
+
+            const ShmBookSlot& slot_at(size_t slot) const {
+                return reinterpret_cast<const ShmBookSlot*>(base + sizeof(ShmBookHeader))[slot];
+            }
+            template<typename Fn>
+            bool read_consistent(size_t slot, Fn&& fn) const {
+                if (slot >= slotCount) return false;
+                const ShmBookSlot& s = slot_at(slot);
+                if (!s.sequence.written()) return false;
+                s.sequence.read_consistent([&fn, &s]() {
+                    fn(s.data);
+                });
+                return true;
+            }
+        };
+    };
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include "common/types.h"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+
+namespace pascal {
+    namespace market_data {
+        //How far from the touch synthetic updates land
+        enum class DepthProfile {
+            GEOMETRIC, //most updates hit the first few levels, like an exchange feed
+            UNIFORM    //every level of the configured depth is equally likely
+        };
+
+        //Book of one synthetic instrument that emits snapshots and increments consistent with its own state:
+        //deletes and changes only target levels that exist and a side never empties. Prices are ticks around a
+        //fixed mid, bids below it and asks above, so the book never crosses. Used by the feed simulator and
+        //the benchmarks.
+        class SyntheticFeed {
+        public:
+            SyntheticFeed(pascal::common::SymbolId id, int64_t mid, int depth, DepthProfile profile = DepthProfile::GEOMETRIC, uint32_t seed = 42)
+                : id(id), mid(mid), depth(std::max(depth, 1)), profile(profile), rng(seed), geometric(0.25), uniform(0, this->depth-1) {
+                for (int i = 1; i <= this->depth; i++) {
+                    bids[mid - i] = 100 + i;
+                    asks[mid + i] = 100 + i;
+                }
+            }
+
+            //Current state, best levels first
+            pascal::common::MarketDataSnapshot snapshot() const {
+                pascal::common::MarketDataSnapshot snapshot;
+                snapshot.symbol_id = id;
+                for (auto it = bids.rbegin(); it != bids.rend(); ++it) snapshot.bids.push_back({it->first, it->second});
+                for (const auto& [price, quantity] : asks) snapshot.asks.push_back({price, quantity});
+                return snapshot;
+            }
+
+            //Fills update with entries changes and applies them to the feed's own book
+            void next_increment(pascal::common::MarketDataIncrement& update, size_t entries) {
+                update.symbol_id = id;
+                update.md_entries.clear();
+                for (size_t e = 0; e < entries; e++) update.md_entries.push_back(next_entry());
+                update.marketDepth = static_cast<uint32_t>(update.md_entries.size());
+            }
+            pascal::common::MarketDataIncrement next_increment(size_t entries) {
+                pascal::common::MarketDataIncrement update;
+                next_increment(update, entries);
+                return update;
+            }
+
+            pascal::common::SymbolId get_symbol_id() const {
+                return id;
+            }
+
+        private:
+            pascal::common::SymbolId id;
+            int64_t mid;
+            int depth;
+            DepthProfile profile;
+            std::mt19937 rng;
+            std::geometric_distribution<int> geometric;
+            std::uniform_int_distribution<int> uniform;
+            std::uniform_int_distribution<int> action{0, 9};
+            std::uniform_int_distribution<int64_t> quantity{1, 1000};
+            std::map<int64_t, int64_t> bids;
+            std::map<int64_t, int64_t> asks;
+
+            int distance() {
+                if (profile == DepthProfile::UNIFORM) return uniform(rng);
+                return std::min(geometric(rng), 4*depth);
+            }
+            pascal::common::MarketDataEntry next_entry() {
+                bool bid = rng() & 1;
+                auto& levels = bid ? bids : asks;
+                int64_t price = bid ? mid - 1 - distance() : mid + 1 + distance();
+                pascal::common::MarketDataEntry md;
+                md.side = bid ? pascal::common::Side::BID : pascal::common::Side::OFFER;
+                auto it = levels.find(price);
+                int roll = action(rng);
+                if (it == levels.end() || roll < 2) {
+                    int64_t qty = quantity(rng);
+                    md.update_action = pascal::common::UpdateAction::NEW;
+                    md.priceLevel = {price, qty};
+                    levels[price] += qty;
+                }
+                else if (roll < 5 && levels.size() > 1) {
+                    md.update_action = pascal::common::UpdateAction::DELETE;
+                    md.priceLevel = {price, it->second};
+                    levels.erase(it);
+                }
+                else {
+                    int64_t qty = quantity(rng);
+                    md.update_action = pascal::common::UpdateAction::CHANGE;
+                    md.priceLevel = {price, qty};
+                    it->second = qty;
+                }
+                return md;
+            }
+        };
+    };
+};
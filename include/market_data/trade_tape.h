@@ -0,0 +1,136 @@
+#pragma once
+#include "common/types.h"
+#include "common/cpu.h"
+#include "common/seqlock.h"
+#include "common/symbol_registry.h"
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <vector>
+#include <string>
+
+namespace pascal {
+    namespace market_data {
+        //Ring of one symbol's most recent trades, numbered from 1. One writer (the symbol processing thread) and
+        //any number of readers scanning it without locks: every slot carries the number of the trade it holds,
+        //zeroed while the writer replaces it, so a reader notices a slot overwritten underneath its copy
+        class TradeTape {
+        public:
+            static constexpr size_t CAPACITY = 4096;
+            static_assert((CAPACITY & (CAPACITY-1)) == 0, "CAPACITY must be a power of two");
+
+            TradeTape() : slots(std::make_unique<Slot[]>(CAPACITY)) {}
+
+            //Writer side, returns the trade's number
+            uint64_t push(const pascal::common::Trade& trade);
+
+            //Number of the newest trade, 0 while the tape is empty
+            uint64_t get_last_sequence() const;
+
+            //Copies the trades numbered after `after`, oldest first and at most out.size() of them. last is set
+            //to the number of the last trade read or skipped; trades lapped by the writer before they could be
+            //read are skipped, pass last back in to follow the tape
+            size_t read_since(uint64_t after, std::span<pascal::common::Trade> out, uint64_t& last) const;
+            //Copies the newest out.size() trades, oldest first
+            size_t read_latest(std::span<pascal::common::Trade> out) const;
+
+        private:
+            static constexpr uint64_t MASK = CAPACITY-1;
+
+            struct Slot {
+                std::atomic<uint64_t> sequence{0};
+                pascal::common::Trade trade;
+            };
+            std::unique_ptr<Slot[]> slots;
+            alignas(pascal::common::CACHE_LINE_SIZE) std::atomic<uint64_t> head{0};
+        };
+
+        //Trade windows kept per symbol, in nanoseconds
+        constexpr std::array<int64_t, 3> TRADE_WINDOWS = {1'000'000'000, 10'000'000'000, 60'000'000'000};
+
+        struct TradeWindowStats {
+            uint64_t trades = 0;
+            pascal::common::Lots volume = 0;
+            pascal::common::Lots buy_volume = 0;  //bought by the aggressor
+            pascal::common::Lots sell_volume = 0;
+            double vwap = 0.0;      //in ticks
+            double imbalance = 0.0; //(buy_volume - sell_volume) / (buy_volume + sell_volume), in [-1, 1]
+        };
+        //Rolling statistics of one symbol as of the time they were loaded, windows[i] covers TRADE_WINDOWS[i]
+        struct TradeStats {
+            uint64_t last_sequence = 0; //tape number of the last trade counted
+            pascal::common::Trade last_trade;
+            std::array<TradeWindowStats, TRADE_WINDOWS.size()> windows;
+        };
+
+        //Pipeline stage recording every trade into its symbol's tape and rolling statistics. The statistics are
+        //running sums over time buckets (a twentieth of the window wide) that the writer rolls forward on every
+        //trade under a per symbol seqlock. Readers load them without locks and leave out the buckets that
+        //expired since the last trade, so the windows of a symbol that stopped trading drain on time.
+        //Symbols are added before messages flow, trades of other symbols are dropped
+        class TradeRecorder {
+        public:
+            static constexpr size_t WINDOW_BUCKETS = 20;
+
+            TradeRecorder() = default;
+
+            TradeRecorder(const TradeRecorder&) = delete;
+            TradeRecorder& operator=(const TradeRecorder&) = delete;
+
+            pascal::common::SymbolId add_symbol(const std::string& symbol);
+
+            //Writer side, only from the symbol's processing thread
+            void on_trade(const pascal::common::Trade& trade);
+
+            //Reader side
+            const TradeTape* get_tape(pascal::common::SymbolId id) const;
+            //False until the symbol has traded. The windows end at now, by default the current TscClock time
+            //(the clock the parsers stamp recv_time with)
+            bool load_stats(pascal::common::SymbolId id, TradeStats& out) const;
+            bool load_stats(pascal::common::SymbolId id, TradeStats& out, std::chrono::high_resolution_clock::time_point now) const;
+
+            //Statistics
+            uint64_t get_total_trades() const;
+            uint64_t get_dropped_trades() const; //of symbols that were not added
+
+        private:
+            struct Bucket {
+                uint64_t trades = 0;
+                pascal::common::Lots volume = 0;
+                pascal::common::Lots buy_volume = 0;
+                pascal::common::Lots sell_volume = 0;
+                double notional = 0.0;
+
+                void add(const Bucket& other);
+                void remove(const Bucket& other);
+            };
+            //buckets[index % WINDOW_BUCKETS] holds the trades of bucket index, head is the newest bucket
+            struct Window {
+                std::array<Bucket, WINDOW_BUCKETS> buckets{};
+                Bucket sum;
+                int64_t head = 0;
+            };
+            //Everything after the seqlock is written under it
+            struct SymbolTrades {
+                TradeTape tape;
+
+                alignas(pascal::common::CACHE_LINE_SIZE) pascal::common::SeqLock seqlock;
+                uint64_t last_sequence = 0;
+                pascal::common::Trade last_trade;
+                std::array<Window, TRADE_WINDOWS.size()> windows;
+            };
+
+            static int64_t bucket_index(int64_t nanos, size_t window) {
+                return nanos / static_cast<int64_t>(TRADE_WINDOWS[window]/WINDOW_BUCKETS);
+            }
+
+            //Indexed by SymbolId, sized up front so the processing threads can index it without locking
+            std::vector<std::unique_ptr<SymbolTrades>> symbols = std::vector<std::unique_ptr<SymbolTrades>>(pascal::common::SymbolRegistry::MAX_SYMBOLS);
+
+            std::atomic<uint64_t> total_trades{0};
+            std::atomic<uint64_t> dropped_trades{0};
+        };
+    };
+};
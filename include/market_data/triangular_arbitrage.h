@@ -0,0 +1,163 @@
+#pragma once
+#include "common/types.h"
+#include "common/cpu.h"
+#include "common/seqlock.h"
+#include "common/symbol_registry.h"
+#include "common/lockfree_spsc_queue.h"
+#include "market_data/order_book.h"
+#include "market_data/fix_order_book.h"
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pascal {
+    namespace market_data {
+        //What a leg does with the symbol: BUY spends the quote currency at the ask, SELL receives it at the bid
+        enum class LegSide {
+            BUY,
+            SELL
+        };
+
+        struct CycleLeg {
+            std::string symbol;
+            LegSide side;
+            double fee = 0.0; //taker fee rate of the leg, 0.001 for 10 bps
+        };
+        constexpr size_t CYCLE_LEGS = 3;
+        using CycleId = uint32_t;
+        constexpr CycleId INVALID_CYCLE_ID = std::numeric_limits<CycleId>::max();
+
+        //A cycle priced above one after fees, in units of the currency the first leg spends
+        struct ArbitrageOpportunity {
+            CycleId cycle = INVALID_CYCLE_ID;
+            pascal::common::SymbolId trigger = pascal::common::INVALID_SYMBOL_ID; //leg whose BBO change found it
+            double edge = 0.0;           //return of one unit through the cycle after fees, minus one
+            double start_quantity = 0.0; //largest amount the top of book of every leg absorbs
+            double expected_profit = 0.0;
+            std::array<double, CYCLE_LEGS> prices{}; //touch price taken on each leg
+            std::chrono::high_resolution_clock::time_point recv_time{}; //of the triggering message
+            int64_t detect_nanos = 0;    //TscClock::now_nanos when found
+        };
+
+        //Signal engine over the books of a FIXOrderBookManager, watching cycles of three symbols such as
+        //BTCUSDT/ETHBTC/ETHUSDT. After a book update it checks whether the symbol's best bid or offer moved and
+        //only then re-prices the cycles that symbol is a leg of, found through a per symbol index. Each symbol's
+        //touch is kept in its own seqlocked line, so pricing a cycle reads three lines and no book.
+        //Opportunities go to a lock-free queue per producing thread (indexed by thread_index()) that one consumer
+        //drains. The index of a thread that exits goes to the next new thread, which takes over its queue and
+        //counters. Cycles are added before messages flow
+        class TriangularArbitrageDetector {
+        public:
+            static constexpr size_t QUEUE_CAPACITY = 1024;
+            static constexpr size_t MAX_PRODUCERS = 64; //live threads with an index at or past it have no queue
+
+            explicit TriangularArbitrageDetector(FIXOrderBookManager& manager) : manager(&manager), quotes(std::make_unique<Quote[]>(pascal::common::SymbolRegistry::MAX_SYMBOLS)) {}
+            ~TriangularArbitrageDetector();
+
+            TriangularArbitrageDetector(const TriangularArbitrageDetector&) = delete;
+            TriangularArbitrageDetector& operator=(const TriangularArbitrageDetector&) = delete;
+
+            //INVALID_CYCLE_ID when a leg's symbol has no book in the manager. Opportunities need an edge above min_edge
+            CycleId add_cycle(const std::array<CycleLeg, CYCLE_LEGS>& legs, double min_edge = 0.0);
+            const std::array<CycleLeg, CYCLE_LEGS>& get_cycle(CycleId id) const;
+            size_t get_cycle_count() const;
+
+            //From the symbol's processing thread after its book changed (TriangularArbitrageStage calls it).
+            //Returns how many cycles were priced, 0 when the touch did not move. A thread whose index is at or
+            //past MAX_PRODUCERS has no queue, the opportunities it finds are counted as dropped
+            size_t on_book_changed(pascal::common::SymbolId id, std::chrono::high_resolution_clock::time_point recv_time = {});
+
+            //Consumer side, calls fn(const ArbitrageOpportunity&) for everything queued, returns how many
+            template<typename Fn>
+            size_t drain(Fn&& fn) {
+                size_t drained = 0;
+                for (auto& slot : producers) {
+                    Producer* producer = slot.load(std::memory_order_acquire);
+                    if (producer) drained += producer->queue.consume_all(fn);
+                }
+                return drained;
+            }
+
+            //Statistics, summed over the producing threads
+            uint64_t get_bbo_changes() const;
+            uint64_t get_evaluations() const;
+            uint64_t get_opportunities() const;
+            uint64_t get_dropped_opportunities() const; //queue full, or found by a thread without a producer slot
+
+        private:
+            struct Leg {
+                pascal::common::SymbolId symbol;
+                LegSide side;
+                double fee_factor; //1 - fee
+            };
+            struct Cycle {
+                std::array<Leg, CYCLE_LEGS> legs;
+                double min_edge;
+            };
+            //Touch of one symbol in real prices and quantities, written by its processing thread
+            struct alignas(pascal::common::CACHE_LINE_SIZE) Quote {
+                pascal::common::SeqLock seqlock;
+                double bid = 0.0; //0 when the side is empty or the book unsynchronized
+                double bid_size = 0.0;
+                double ask = 0.0;
+                double ask_size = 0.0;
+                //Writer only, the touch the values were taken from
+                pascal::common::PriceLevel bid_level{0, 0};
+                pascal::common::PriceLevel ask_level{0, 0};
+                bool synchronized = false;
+            };
+            struct QuoteValues {
+                double bid, bid_size, ask, ask_size;
+            };
+            struct Producer {
+                pascal::common::SPSCQueue<ArbitrageOpportunity, QUEUE_CAPACITY> queue;
+                alignas(pascal::common::CACHE_LINE_SIZE) std::atomic<uint64_t> bbo_changes{0};
+                std::atomic<uint64_t> evaluations{0};
+                std::atomic<uint64_t> opportunities{0};
+                std::atomic<uint64_t> dropped{0};
+            };
+            //Statistics of the threads past MAX_PRODUCERS, shared by them so added to atomically
+            struct alignas(pascal::common::CACHE_LINE_SIZE) Overflow {
+                std::atomic<uint64_t> bbo_changes{0};
+                std::atomic<uint64_t> evaluations{0};
+                std::atomic<uint64_t> unqueued{0}; //opportunities found, all of them dropped
+            };
+
+            FIXOrderBookManager* manager;
+            std::vector<Cycle> cycles;
+            std::vector<std::array<CycleLeg, CYCLE_LEGS>> cycleLegs; //as configured, for get_cycle
+            std::vector<std::shared_ptr<OrderBook>> books = std::vector<std::shared_ptr<OrderBook>>(pascal::common::SymbolRegistry::MAX_SYMBOLS); //of watched symbols
+            std::vector<std::vector<CycleId>> cyclesBySymbol = std::vector<std::vector<CycleId>>(pascal::common::SymbolRegistry::MAX_SYMBOLS);
+            std::unique_ptr<Quote[]> quotes; //indexed by SymbolId
+            std::array<std::atomic<Producer*>, MAX_PRODUCERS> producers{};
+            Overflow overflow;
+
+            bool refresh_quote(pascal::common::SymbolId id);
+            QuoteValues load_quote(pascal::common::SymbolId id) const;
+            bool evaluate(CycleId id, pascal::common::SymbolId trigger, std::chrono::high_resolution_clock::time_point recv_time, ArbitrageOpportunity& opportunity) const;
+            Producer* thread_producer(); //null when the calling thread's index is past MAX_PRODUCERS
+        };
+
+        //Pipeline stage placed after the BookUpdateStage of the detector's manager. Each processing thread queues
+        //opportunities through the producer slot of its thread_index(), so at most MAX_PRODUCERS of them can be
+        //live at once. Opportunities found on a thread past the limit are counted as dropped, never thrown
+        class TriangularArbitrageStage {
+        public:
+            explicit TriangularArbitrageStage(TriangularArbitrageDetector& detector) : detector(&detector) {}
+
+            void on_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
+                detector->on_book_changed(snapshot.symbol_id, snapshot.recv_time);
+            }
+            void on_increment(const pascal::common::MarketDataIncrement& update) {
+                detector->on_book_changed(update.symbol_id, update.recv_time);
+            }
+
+        private:
+            TriangularArbitrageDetector* detector;
+        };
+    };
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include "common/types.h"
+#include "common/wait_strategy.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pascal {
+    namespace net {
+        //Reads a [DEFAULT] setting into value, false when it isn't set. The engine answers from its QuickFIX
+        //settings, so nothing here needs a session
+        using SettingLookup = std::function<bool(const std::string& key, std::string& value)>;
+
+        //WorkerCores=2,3,5, one worker pinned on each listed core. Empty entries are skipped, an empty list means
+        //unconfigured. Throws std::invalid_argument on an entry that is not a core number
+        std::vector<int> parse_worker_cores(const std::string& list);
+        //Cores of an unconfigured engine: core 0 is left to the OS and QuickFIX, one core per symbol after it and
+        //never past the available ones
+        std::vector<int> default_worker_cores(size_t symbolCount, unsigned available);
+
+        //WaitStrategy, WaitSpinCount and WaitParkTimeoutUs, each overridable per symbol as <Key>.<SYMBOL>. Unset
+        //keys keep the WaitStrategyConfig defaults. Throws std::invalid_argument on a value that doesn't parse
+        pascal::common::WaitStrategyConfig load_wait_config(const SettingLookup& lookup, const std::string& symbol);
+        //Idle policy of a worker serving symbols with both configs, the more latency sensitive choice of each field
+        pascal::common::WaitStrategyConfig merge_wait_configs(const pascal::common::WaitStrategyConfig& a, const pascal::common::WaitStrategyConfig& b);
+
+        struct WorkerPlan {
+            int core_id;
+            std::vector<pascal::common::SymbolId> symbols;
+            pascal::common::WaitStrategyConfig wait;
+        };
+        //Deals the symbols round-robin over one worker per core, and no more workers than symbols. waitConfigs is
+        //indexed by SymbolId. Throws std::invalid_argument without cores when there are symbols to deal
+        std::vector<WorkerPlan> plan_workers(const std::vector<int>& cores, const std::vector<pascal::common::SymbolId>& symbols,
+            const std::vector<pascal::common::WaitStrategyConfig>& waitConfigs);
+    };
+};
@@ -6,11 +6,20 @@
 #include <functional>
 #include <thread>
 #include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <vector>
 
 #include "net/fix_parser.h"
 #include "net/ed25519_signer.h"
-#include "common/lockfree_spsc_queue.h"
+#include "net/message_journal.h"
+#include "net/engine_config.h"
+#include "common/spsc_byte_ring.h"
+#include "common/wait_strategy.h"
+#include "common/latency_histogram.h"
+#include "common/tsc_clock.h"
 #include "common/types.h"
+#include "common/symbol_registry.h"
 #include "quickfix/Application.h"
 #include "quickfix/Mutex.h"
 #include "quickfix/Utility.h"
@@ -30,42 +39,53 @@
 namespace pascal {
     namespace net {
 
-        class FIXMarketDataEngine : public FIX::Application {
+        //Session, subscriptions, per symbol rings and processing workers, shared by every sink type. The worker
+        //loop is run by the BasicFIXMarketDataEngine that owns the parser, see drain_symbols.
+        class FIXMarketDataEngineBase : public FIX::Application {
         public:
 
-            struct QueuedFIXMessage {
-                FIX::Message message;
-                std::chrono::high_resolution_clock::time_point recv_time;
-                
-                QueuedFIXMessage() = default;
-                QueuedFIXMessage(const FIX::Message& message, const std::chrono::high_resolution_clock::time_point& recv_time) : message(message), recv_time(recv_time) {}
-                QueuedFIXMessage(QueuedFIXMessage&& msg) = default;
-                QueuedFIXMessage& operator=(QueuedFIXMessage&& msg) = default;
-            };
-            
-            using MessageQueue = pascal::common::SPSCQueue<QueuedFIXMessage, 16384>;
+            //Per symbol ring of serialized messages, records are tagged with the receive time in clock ticks
+            using MessageQueue = pascal::common::SPSCByteRing<1 << 20>;
+            static constexpr size_t MAX_DRAIN_BATCH = 256; //bounds how long a drain holds ring space
 
             std::unique_ptr<pascal::crypto::Ed25519Signer> signer_; //Key signer for Logon
             std::string api_key;
             
 
-            FIXMarketDataEngine(const std::string& fixConfig, const std::string& private_key_pem, const std::string& api_key, const std::vector<std::string>& tradedSymbols) : api_key(api_key), tradedSymbols(tradedSymbols) 
+            FIXMarketDataEngineBase(const std::string& fixConfig, const std::string& private_key_pem, const std::string& api_key, const std::vector<std::string>& tradedSymbols) : api_key(api_key), tradedSymbols(tradedSymbols) 
             {
                 settings_ = std::make_unique<FIX::SessionSettings>(fixConfig);
                 store_factory_ = std::make_unique<FIX::FileStoreFactory>(*settings_);
                 log_factory_ = std::make_unique<FIX::FileLogFactory>(*settings_);
                 initiator_ = std::make_unique<FIX::SocketInitiator>(*this, *store_factory_, *settings_, *log_factory_);
-                parser = std::make_unique<pascal::market_data::FIXMarketDataParser>();
+                //Calibrate the receive clock here, not in the session thread's first fromApp
+                pascal::common::TscClock::is_tsc();
+
+                //Ids are assigned once here, the message path only indexes flat arrays with them
+                symbolQueues.resize(pascal::common::SymbolRegistry::MAX_SYMBOLS);
+                symbolLatency.resize(pascal::common::SymbolRegistry::MAX_SYMBOLS);
+                symbolWaitConfigs.resize(pascal::common::SymbolRegistry::MAX_SYMBOLS);
+                symbolWorkers.resize(pascal::common::SymbolRegistry::MAX_SYMBOLS, nullptr);
+                resyncPending = std::make_unique<std::atomic<bool>[]>(pascal::common::SymbolRegistry::MAX_SYMBOLS);
+                for (const auto& symbol : tradedSymbols) {
+                    pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().register_symbol(symbol);
+                    if (id == pascal::common::INVALID_SYMBOL_ID || symbolQueues[id]) continue;
+                    symbolQueues[id] = std::make_unique<MessageQueue>();
+                    symbolLatency[id] = std::make_unique<pascal::common::StageLatency>();
+                    symbolWaitConfigs[id] = load_wait_config(setting_lookup(), symbol);
+                    tradedSymbolIds.push_back(id);
+                }
+                workerCores = load_worker_cores();
+                if (settings_->get().has("CaptureJournal")) set_capture_journal(settings_->get().getString("CaptureJournal"));
+                if (settings_->get().has("Venue")) set_venue(static_cast<pascal::common::VenueId>(settings_->get().getInt("Venue")));
 
                 signer_ = std::make_unique<pascal::crypto::Ed25519Signer>();
                 if (!signer_->loadPrivateKeyFromFile(private_key_pem)) {
                     std::runtime_error("Private Key cannot be loaded from file");
                 } 
             };
-            ~FIXMarketDataEngine() {
-                if (is_running.load(std::memory_order_acquire)) {
-                    stop();
-                }
+            ~FIXMarketDataEngineBase() {
+                shutdown();
             }
 
             //Application overloads
@@ -81,18 +101,123 @@ namespace pascal {
             //Engine logic
             void sub_to_symbol(pascal::common::MarketDataRequest& req);
             void unsub_to_symbol(const std::string& symbol);
-            
-            template<typename T>
-            void register_parser_callback(T&& clbk) {
-                parser->register_callback(std::forward<T>(clbk));
-            }
+            //Re-subscribes the symbol so the venue sends a fresh snapshot, false when it isn't subscribed or a request
+            //is already outstanding. Safe from any thread, wire FIXOrderBookManager::set_resync_handler to it
+            bool request_snapshot(const std::string& symbol);
+            bool request_snapshot(pascal::common::SymbolId id);
+
+            //Idle policy of the symbol processing threads, overrides the settings file. Only while the engine is stopped
+            void set_wait_strategy(const pascal::common::WaitStrategyConfig& config);
+            void set_wait_strategy(const std::string& symbol, const pascal::common::WaitStrategyConfig& config);
+            pascal::common::WaitStats get_wait_stats(const std::string& symbol) const; //of the worker owning symbol
+
+            //One pinned worker per core, symbols are dealt round-robin across them. Only while the engine is stopped
+            void set_worker_cores(const std::vector<int>& cores);
+            size_t get_worker_count() const;
 
             //Application lifecycle
             bool start();
             bool stop();
             bool is_logged() const;
+            uint64_t get_dropped_messages() const; //market data lost to a full symbol ring
+
+            //Per symbol latency of one stage of the message path, over the current interval
+            pascal::common::LatencySnapshot get_latency(const std::string& symbol, pascal::common::LatencyStage stage) const;
+            void reset_latency_interval(); //starts a new interval for every symbol
+
+            //Appends every received market data message to a journal for offline replay, overrides the
+            //CaptureJournal setting. An empty path stops capturing. Only while the engine is stopped
+            void set_capture_journal(const std::string& path);
+
+            //Venue stamped on this session's events, overrides the Venue setting. Engines of several venues can feed
+            //one ConsolidatedBookManager. Only while the engine is stopped
+            void set_venue(pascal::common::VenueId id);
+            pascal::common::VenueId get_venue() const;
+            //Tick/lot scaling of the symbol's events, forwarded to the parser. Books created with an InstrumentSpec
+            //need the same spec here, otherwise they receive prices and sizes on the 1e-8 wire grid. Only while the
+            //engine is stopped
+            void set_instrument_spec(const std::string& symbol, const pascal::common::InstrumentSpec& spec);
+
+
+        protected:
+            //Processing worker, polls the queues of the symbols it owns round-robin
+            struct Worker {
+                int core_id;
+                std::vector<pascal::common::SymbolId> symbols;
+                pascal::common::WaitStrategy wait;
+                std::thread thread;
+
+                Worker(int core_id, const pascal::common::WaitStrategyConfig& config) : core_id(core_id), wait(config) {}
+            };
+
+            //Parser of the derived engine, for the settings the base applies to it. Set by the derived constructor
+            pascal::market_data::FIXMarketDataParserBase* parserBase = nullptr;
+
+            //Stops a running engine, the owner of the parser calls it before the parser is destroyed
+            void shutdown() {
+                if (is_running.load(std::memory_order_acquire)) {
+                    stop();
+                }
+            }
+            //Body of a worker thread, runs until the engine stops
+            virtual void process_market_data(Worker& worker) = 0;
+
+            //Worker loop, decodes every message of the worker's symbols with parse_raw(data, len, recv_time) and
+            //records the stages after RECEIVE on the thread that owns the symbol
+            template<typename ParseRaw>
+            void drain_symbols(Worker& worker, ParseRaw&& parse_raw) {
+                std::vector<MessageQueue*> queues;
+                std::vector<pascal::common::StageLatency*> latencies;
+                for (pascal::common::SymbolId id : worker.symbols) {
+                    queues.push_back(symbolQueues[id].get());
+                    latencies.push_back(symbolLatency[id].get());
+                }
+
+                auto parse = [&parse_raw](pascal::common::StageLatency& latency, const char* data, size_t len, int64_t recv_ticks, uint32_t receive_nanos) {
+                    std::chrono::high_resolution_clock::time_point recv_time{std::chrono::high_resolution_clock::duration(recv_ticks)};
+                    pascal::common::StageMarks& marks = pascal::common::thread_stage_marks();
+                    marks = {};
+                    int64_t dequeued = pascal::common::latency_clock_now();
+                    parse_raw(data, len, recv_time);
+                    if (!marks.parsed) return; //not market data or malformed
+                    int64_t done = pascal::common::latency_clock_now();
+
+                    int64_t received = std::chrono::duration_cast<std::chrono::nanoseconds>(recv_time.time_since_epoch()).count();
+                    latency.record(pascal::common::LatencyStage::QUEUE, dequeued - (received + receive_nanos));
+                    latency.record(pascal::common::LatencyStage::PARSE, marks.parsed - dequeued);
+                    if (marks.book_applied) {
+                        latency.record(pascal::common::LatencyStage::BOOK, marks.book_applied - marks.parsed);
+                        latency.record(pascal::common::LatencyStage::CALLBACK, done - marks.book_applied);
+                    }
+                    else {
+                        latency.record(pascal::common::LatencyStage::CALLBACK, done - marks.parsed);
+                    }
+                    latency.record(pascal::common::LatencyStage::END_TO_END, done - received);
+                };
+                auto ready = [this, &queues]() {
+                    if (!is_running.load(std::memory_order_acquire)) return true;
+                    return std::any_of(queues.begin(), queues.end(), [](const MessageQueue* queue) {
+                        return !queue->empty();
+                    });
+                };
+                while (is_running.load(std::memory_order_acquire)) {
+                    //One bounded drain per owned queue per round so a busy symbol can't starve the others
+                    size_t processed = 0;
+                    for (size_t i = 0; i < queues.size(); i++) {
+                        pascal::common::StageLatency& latency = *latencies[i];
+                        processed += queues[i]->consume_all([&parse, &latency](const char* data, size_t len, int64_t recv_ticks, uint32_t receive_nanos) {
+                            parse(latency, data, len, recv_ticks, receive_nanos);
+                        }, MAX_DRAIN_BATCH);
+                    }
+                    if (processed == 0) {
+                        worker.wait.idle(ready);
+                    }
+                    else {
+                        worker.wait.on_work();
+                    }
+                }
+            }
 
-        
         private:
             //Market data subscription types
             void sign_logon_message(FIX::Message& message);
@@ -105,19 +230,28 @@ namespace pascal {
             std::unique_ptr<FIX::FileLogFactory> log_factory_;
 
             //Thread level data queue
-            std::unordered_map<std::string, MessageQueue> symbolQueues;
-            std::unordered_map<std::string, std::thread> symbolsThreads;
+            std::vector<std::unique_ptr<MessageQueue>> symbolQueues; //indexed by SymbolId
+            std::vector<pascal::common::WaitStrategyConfig> symbolWaitConfigs; //indexed by SymbolId
+            std::vector<std::unique_ptr<pascal::common::StageLatency>> symbolLatency; //indexed by SymbolId
+            mutable FIX::Mutex latency_mtx; //serializes interval queries and resets
+
+            std::vector<std::unique_ptr<Worker>> workers;
+            std::vector<Worker*> symbolWorkers; //indexed by SymbolId, owner of the symbol's queue
+            std::vector<int> workerCores;
             std::vector<std::string> tradedSymbols;
+            std::vector<pascal::common::SymbolId> tradedSymbolIds;
             FIX::SessionID sessionID;
             std::atomic<bool> is_logged_on{false};
             std::atomic<bool> is_running{false};
 
-            std::unordered_map<std::string, std::string> active_subscriptions;  //{Symbol Name: MDReqID}
-            FIX::Mutex subscription_mtx;
+            std::unordered_map<std::string, pascal::common::MarketDataRequest> active_subscriptions;  //{Symbol Name: request, ReqID is the live MDReqID}
+            std::unique_ptr<std::atomic<bool>[]> resyncPending; //indexed by SymbolId, snapshot requested and not yet received
+            FIX::Mutex subscription_mtx; //guards active_subscriptions and sessionID, held across every send
 
-            std::unique_ptr<pascal::market_data::FIXMarketDataParser> parser;
-            
+            pascal::common::VenueId venue = pascal::common::DEFAULT_VENUE;
             std::atomic<int> next_req_id{1};
+            std::atomic<uint64_t> dropped_messages{0};
+            std::unique_ptr<MessageJournalWriter> captureJournal; //written by the session thread only
 
             std::string send_market_data_request(const pascal::common::MarketDataRequest& req);
             std::string generate_request_id(); //generate MDReqID
@@ -125,8 +259,50 @@ namespace pascal {
             //Thread lifecycle management
             void start_symbol_processing();
             void stop_symbol_processing();
-            void process_market_data(const std::string& symbol);
             void bind_thread_to_core(std::thread& thread, int core_id);
+            std::vector<int> load_worker_cores() const;
+            SettingLookup setting_lookup() const; //over the [DEFAULT] section of the settings file
         };
+
+        //Engine bound at compile time to the sink of its parser, e.g. a Pipeline of BookUpdateStage and signal stages,
+        //so each worker runs decode -> book update -> signal as direct calls. Sink constructor arguments follow the
+        //engine's own
+        template<typename Sink>
+        class BasicFIXMarketDataEngine : public FIXMarketDataEngineBase {
+        public:
+            template<typename... Args>
+            BasicFIXMarketDataEngine(const std::string& fixConfig, const std::string& private_key_pem, const std::string& api_key, const std::vector<std::string>& tradedSymbols, Args&&... args)
+                : FIXMarketDataEngineBase(fixConfig, private_key_pem, api_key, tradedSymbols), parser(std::forward<Args>(args)...) {
+                parser.set_venue(get_venue());
+                parserBase = &parser;
+            }
+            //Workers call into the parser, stop them before it goes
+            ~BasicFIXMarketDataEngine() {
+                shutdown();
+            }
+
+            Sink& get_sink() {
+                return parser.get_sink();
+            }
+
+            //Runtime callback sinks only
+            template<typename T>
+            void register_parser_callback(T&& clbk) {
+                parser.register_callback(std::forward<T>(clbk));
+            }
+
+        protected:
+            void process_market_data(Worker& worker) override {
+                drain_symbols(worker, [this](const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time) {
+                    parser.parse_raw_message(data, len, recv_time);
+                });
+            }
+
+        private:
+            pascal::market_data::BasicFIXMarketDataParser<Sink> parser;
+        };
+
+        //Handlers wired at run time through std::function, for tests and tools
+        using FIXMarketDataEngine = BasicFIXMarketDataEngine<pascal::market_data::CallbackSink>;
     };
 };
\ No newline at end of file
@@ -1,21 +1,131 @@
 #pragma once
 #include "common/types.h"
+#include "net/fix_raw_decoder.h"
+#include "common/cpu.h"
 #include <vector>
 #include <functional>
+#include <memory>
 #include <atomic>
+#include <string>
+#include <utility>
 
 #include "quickfix/Message.h"
+#include "quickfix/Values.h"
 
 namespace pascal {
     namespace market_data {
-        class FIXMarketDataParser {
+        //Decoding half of the parser, shared by every sink type. Events are decoded into per thread instances
+        //that keep their storage, so after warm-up a message costs no allocation.
+        class FIXMarketDataParserBase {
         public:
+            //Tick/lot scaling for a symbol, symbols without a spec stay on the 1e-8 wire grid
+            void set_instrument_spec(const std::string& symbol, const pascal::common::InstrumentSpec& spec);
+            //Venue stamped on every decoded event, DEFAULT_VENUE until set. Set before messages flow
+            void set_venue(pascal::common::VenueId id);
+
+            //Performance tracking, summed over the decoding threads. Per stage percentiles live in the engine.
+            uint64_t get_messages_processed() const;
+            double get_average_processing_time() const; //receive -> decoded, microseconds
+
+        protected:
+            FIXMarketDataParserBase() = default;
+            ~FIXMarketDataParserBase() = default;
+
+            //Return the calling thread's event, or null when the raw message is malformed or its symbol was never
+            //registered (messages of symbols nobody subscribed to are dropped)
+            pascal::common::MarketDataSnapshot* decode_snapshot(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time);
+            pascal::common::MarketDataIncrement* decode_increment(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time);
+            pascal::common::MarketDataSnapshot* decode_raw_snapshot(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time);
+            pascal::common::MarketDataIncrement* decode_raw_increment(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time);
+
+        private:
+            pascal::common::VenueId venue = pascal::common::DEFAULT_VENUE;
+            std::vector<pascal::common::InstrumentSpec> instrumentSpecs = std::vector<pascal::common::InstrumentSpec>(pascal::common::SymbolRegistry::MAX_SYMBOLS); //indexed by SymbolId
+            
+            bool parse_snapshot(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time, pascal::common::MarketDataSnapshot& snapshot);
+            bool parse_increment(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time, pascal::common::MarketDataIncrement& update);
+            const pascal::common::InstrumentSpec& instrument_spec(pascal::common::SymbolId id) const;
+            static pascal::common::MarketDataSnapshot& thread_snapshot();
+            static pascal::common::MarketDataIncrement& thread_increment();
+            static void rescale(const pascal::common::InstrumentSpec& spec, pascal::common::PriceLevel& level);
+            void record_processing_time(std::chrono::high_resolution_clock::time_point recv_time);
+
+            //Counters sharded by thread_index() so workers never write the same line. The thread holding an
+            //index is its shard's only writer, threads with an index at or past MAX_STAT_SHARDS share the extra
+            //last shard and add to it atomically
+            static constexpr size_t MAX_STAT_SHARDS = 64;
+            struct alignas(pascal::common::CACHE_LINE_SIZE) StatShard {
+                std::atomic<uint64_t> messages_processed{0};
+                std::atomic<uint64_t> nanos_processing{0};
+            };
+            std::unique_ptr<StatShard[]> statShards = std::make_unique<StatShard[]>(MAX_STAT_SHARDS+1);
+        };
+
+        //Parser bound at compile time to the sink that consumes its events. A sink provides
+        //on_snapshot(MarketDataSnapshot&) and on_increment(const MarketDataIncrement&), and optionally
+        //on_trade(const Trade&), which are called directly, so decode -> book update -> signal inlines into one
+        //function per message type. An increment reaches on_increment only when it carries book entries, its
+        //trades follow one by one. The snapshot is mutable so a book stage can sort it in place. Events are only
+        //valid during the call.
+        template<typename Sink>
+        class BasicFIXMarketDataParser : public FIXMarketDataParserBase {
+        public:
+            template<typename... Args>
+            explicit BasicFIXMarketDataParser(Args&&... args) : sink(std::forward<Args>(args)...) {}
+
+            Sink& get_sink() {
+                return sink;
+            }
+
+            //Runtime callback sinks only
+            template<typename T>
+            void register_callback(T&& clbk) {
+                sink.register_callback(std::forward<T>(clbk));
+            }
+
+            //Main entry point for FIX engine
+            void parse_message(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time) {
+                FIX::MsgType type;
+                message.getHeader().getField(type);
+                if (type == FIX::MsgType_MarketDataSnapshotFullRefresh) {
+                    if (auto* snapshot = decode_snapshot(message, recv_time)) sink.on_snapshot(*snapshot);
+                }
+                else if (type == FIX::MsgType_MarketDataIncrementalRefresh) {
+                    if (auto* update = decode_increment(message, recv_time)) dispatch_increment(*update);
+                }
+            }
+            //Zero-copy entry point, decodes straight from the serialized tag=value buffer
+            void parse_raw_message(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time) {
+                switch (FIXRawDecoder::message_kind(data, len)) {
+                    case FIXRawDecoder::MessageKind::SNAPSHOT :
+                        if (auto* snapshot = decode_raw_snapshot(data, len, recv_time)) sink.on_snapshot(*snapshot);
+                        break;
+                    case FIXRawDecoder::MessageKind::INCREMENT :
+                        if (auto* update = decode_raw_increment(data, len, recv_time)) dispatch_increment(*update);
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+        private:
+            Sink sink;
+
+            void dispatch_increment(const pascal::common::MarketDataIncrement& update) {
+                if (!update.md_entries.empty()) sink.on_increment(update);
+                if constexpr (requires (const pascal::common::Trade& trade) { sink.on_trade(trade); }) {
+                    for (const auto& trade : update.trades) sink.on_trade(trade);
+                }
+            }
+        };
+
+        //Runtime dispatch through std::function, for tests and callers that wire handlers at run time
+        class CallbackSink {
+        public:
+            //Callbacks get a view of a reused event, valid until the callback returns. Copy what has to outlive it.
             using SnapshotCallback = std::function<void(const pascal::common::MarketDataSnapshot& )>;
             using IncrementalCallback = std::function<void(const pascal::common::MarketDataIncrement& )>;
-            using TradeCallback = std::function<void(const pascal::common::MarketDataEntry& )>;
-
-            FIXMarketDataParser() = default;
-            ~FIXMarketDataParser() = default;
+            using TradeCallback = std::function<void(const pascal::common::Trade& )>;
 
             //Register callbacks
             void register_callback(const SnapshotCallback& clbk) {
@@ -28,24 +138,22 @@ namespace pascal {
                 tradeClbk = clbk;
             }
 
-            //Main entry point for FIX engine
-            void parse_message(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time);
-
-            //Performance tracking
-            uint64_t get_messages_processed() const;
-            double get_average_processing_time() const;
+            void on_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
+                if (snapshotClbk) snapshotClbk(snapshot);
+            }
+            void on_increment(const pascal::common::MarketDataIncrement& update) {
+                if (incrementalClbk) incrementalClbk(update);
+            }
+            void on_trade(const pascal::common::Trade& trade) {
+                if (tradeClbk) tradeClbk(trade);
+            }
 
         private:
             SnapshotCallback snapshotClbk;
             IncrementalCallback incrementalClbk;
             TradeCallback tradeClbk;
-            
-            pascal::common::MarketDataSnapshot parse_snapshot(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time);
-            pascal::common::MarketDataIncrement parse_increment(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time);
-            pascal::common::MarketDataEntry parse_raw_trade(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time);
-
-            std::atomic<uint64_t> messaged_processed{0};
-            std::atomic<uint64_t> time_spent_processing{0};
         };
+
+        using FIXMarketDataParser = BasicFIXMarketDataParser<CallbackSink>;
     };
-};
\ No newline at end of file
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include "common/types.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <chrono>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace pascal {
+    namespace market_data {
+        namespace raw {
+            constexpr char SOH = '\x01';
+
+            //FIX tags used by the market data decoder
+            enum Tag : uint32_t {
+                MSG_TYPE = 35,
+                SYMBOL = 55,
+                NO_MD_ENTRIES = 268,
+                MD_ENTRY_TYPE = 269,
+                MD_ENTRY_PX = 270,
+                MD_ENTRY_SIZE = 271,
+                MD_UPDATE_ACTION = 279,
+                TRADE_ID = 1003,
+                AGGRESSOR_SIDE = 2446,
+                FIRST_BOOK_UPDATE_ID = 25043,
+                LAST_BOOK_UPDATE_ID = 25044
+            };
+
+            //Walks a raw FIX buffer and yields SOH positions. SOH bits are computed for 64 bytes at a time
+            //with SIMD compares, so consecutive short fields only pay for a bit scan.
+            class SohScanner {
+            public:
+                SohScanner(const char* begin, const char* end) : block_(begin), end_(end) {
+                    load_block();
+                }
+
+                //Returns the position of the next SOH at or after the previous one, or end when exhausted
+                const char* next() {
+                    while (!mask_) {
+                        block_ += 64;
+                        if (block_ >= end_) return end_;
+                        load_block();
+                    }
+                    const char* pos = block_ + __builtin_ctzll(mask_);
+                    mask_ &= mask_ - 1;
+                    return pos;
+                }
+
+            private:
+                const char* block_;
+                const char* end_;
+                uint64_t mask_{0};
+
+                void load_block() {
+                    size_t remaining = static_cast<size_t>(end_ - block_);
+                    if (remaining >= 64) {
+#if defined(__AVX2__)
+                        const __m256i soh = _mm256_set1_epi8(SOH);
+                        uint64_t lo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block_)), soh)));
+                        uint64_t hi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block_+32)), soh)));
+                        mask_ = lo | (hi << 32);
+#elif defined(__SSE2__)
+                        const __m128i soh = _mm_set1_epi8(SOH);
+                        uint64_t m0 = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block_)), soh)));
+                        uint64_t m1 = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block_+16)), soh)));
+                        uint64_t m2 = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block_+32)), soh)));
+                        uint64_t m3 = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block_+48)), soh)));
+                        mask_ = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+#else
+                        mask_ = scalar_mask(64);
+#endif
+                    }
+                    else {
+                        //Tail block, never read past the end of the buffer
+                        mask_ = scalar_mask(remaining);
+                    }
+                }
+                uint64_t scalar_mask(size_t n) const {
+                    uint64_t mask = 0;
+                    for (size_t i = 0; i < n; i++) {
+                        mask |= static_cast<uint64_t>(block_[i] == SOH) << i;
+                    }
+                    return mask;
+                }
+            };
+
+            //Parses an unsigned integer, stops at the first non digit
+            inline uint64_t parse_uint(const char* begin, const char* end) {
+                uint64_t value = 0;
+                for (; begin < end; begin++) {
+                    unsigned digit = static_cast<unsigned char>(*begin) - '0';
+                    if (digit > 9) break;
+                    value = value*10 + digit;
+                }
+                return value;
+            }
+        };
+
+        //Decodes MarketDataSnapshotFullRefresh (35=W) and MarketDataIncrementalRefresh (35=X) messages
+        //directly from the serialized tag=value buffer in a single pass, without building a FIX::Message.
+        //Prices and quantities are left on the 1e-8 wire grid, see InstrumentSpec for the tick/lot scaling.
+        class FIXRawDecoder {
+        public:
+            enum class MessageKind {
+                UNKNOWN,
+                SNAPSHOT,
+                INCREMENT
+            };
+
+            //Reads the MsgType (35) field from the standard header
+            static MessageKind message_kind(const char* data, size_t len);
+
+            //Decode into a possibly reused event, its previous contents are cleared but its storage is kept.
+            //False for a malformed message or a symbol that is not in the SymbolRegistry
+            static bool decode_snapshot(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time, pascal::common::MarketDataSnapshot& snapshot);
+            static bool decode_increment(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time, pascal::common::MarketDataIncrement& update);
+        };
+    };
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "net/message_journal.h"
+#include "common/latency_histogram.h"
+#include "common/tsc_clock.h"
+#include "common/cpu.h"
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace pascal {
+    namespace net {
+        struct ReplayOptions {
+            bool paced = false;  //release messages at their captured spacing, otherwise back to back
+            double speed = 1.0;  //pacing multiplier, 2.0 replays twice as fast as captured
+        };
+
+        struct ReplayReport {
+            uint64_t messages = 0;
+            uint64_t bytes = 0;
+            std::chrono::nanoseconds elapsed{0};
+            //Due time -> parser and sink returned, so in paced mode it includes any backlog
+            pascal::common::LatencySnapshot latency;
+
+            double messages_per_second() const {
+                return elapsed.count() ? static_cast<double>(messages)*1e9/static_cast<double>(elapsed.count()) : 0.0;
+            }
+            double megabytes_per_second() const {
+                return elapsed.count() ? static_cast<double>(bytes)*1e3/static_cast<double>(elapsed.count()) : 0.0;
+            }
+        };
+
+        //Symbols (tag 55) appearing in a journal, in order of first appearance, for creating books before a replay
+        inline std::vector<std::string> journal_symbols(const MessageJournalReader& journal) {
+            std::vector<std::string> symbols;
+            std::unordered_set<std::string> seen;
+            journal.for_each([&symbols, &seen](const MessageJournalReader::Record& record) {
+                std::string_view message(record.data, record.size);
+                size_t pos = message.find("\x01" "55=");
+                if (pos == std::string_view::npos) return;
+                pos += 4;
+                size_t end = message.find('\x01', pos);
+                std::string symbol(message.substr(pos, end == std::string_view::npos ? std::string_view::npos : end-pos));
+                if (seen.insert(symbol).second) symbols.push_back(symbol);
+            });
+            return symbols;
+        }
+
+        //Feeds every journal record through parser.parse_raw_message on the calling thread. Events carry the
+        //replay release time as recv_time, the captured receive times only drive the pacing.
+        template<typename Parser>
+        ReplayReport replay_journal(const MessageJournalReader& journal, Parser& parser, const ReplayOptions& options = {}) {
+            ReplayReport report;
+            pascal::common::LatencyHistogram latency;
+            const double speed = options.speed > 0.0 ? options.speed : 1.0;
+            int64_t firstCaptured = 0;
+            const int64_t start = pascal::common::TscClock::now_nanos();
+
+            journal.for_each([&](const MessageJournalReader::Record& record) {
+                int64_t due;
+                if (options.paced) {
+                    if (report.messages == 0) firstCaptured = record.recv_nanos;
+                    due = start + static_cast<int64_t>(static_cast<double>(record.recv_nanos - firstCaptured)/speed);
+                    int64_t now = pascal::common::TscClock::now_nanos();
+                    //Sleep through long gaps, spin the last stretch
+                    if (due - now > 2000000) std::this_thread::sleep_for(std::chrono::nanoseconds(due - now - 1000000));
+                    while (pascal::common::TscClock::now_nanos() < due) pascal::common::cpu_relax();
+                }
+                else {
+                    due = pascal::common::TscClock::now_nanos();
+                }
+                pascal::common::TscClock::time_point recv_time{std::chrono::duration_cast<pascal::common::TscClock::time_point::duration>(std::chrono::nanoseconds(due))};
+                parser.parse_raw_message(record.data, record.size, recv_time);
+                latency.record(pascal::common::TscClock::now_nanos() - due);
+                report.messages++;
+                report.bytes += record.size;
+            });
+
+            report.elapsed = std::chrono::nanoseconds(pascal::common::TscClock::now_nanos() - start);
+            report.latency = latency.snapshot();
+            return report;
+        }
+    };
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pascal {
+    namespace net {
+        //On disk layout of a capture journal: a 64 byte header followed by records, each a 16 byte record header
+        //(payload size, receive time in ns) and the raw tag=value message, padded to 8 bytes.
+        //The header's end offset is advanced after every record, so a reader never sees a partial one.
+        struct JournalHeader {
+            static constexpr char MAGIC[8] = {'P', 'S', 'C', 'L', 'J', 'R', 'N', 'L'};
+            static constexpr uint32_t VERSION = 1;
+
+            char magic[8];
+            uint32_t version;
+            uint32_t header_size;
+            uint64_t end_offset;   //first byte past the last complete record
+            uint64_t record_count;
+            int64_t created_nanos;
+            char reserved[24];
+        };
+        static_assert(sizeof(JournalHeader) == 64);
+
+        struct JournalRecordHeader {
+            uint32_t size;
+            uint32_t reserved;
+            int64_t recv_nanos;
+        };
+        static_assert(sizeof(JournalRecordHeader) == 16);
+
+        //Append-only, memory mapped journal of received messages. The file is grown and remapped in steps of
+        //growth bytes (pre-faulted on Linux), so an append is a memcpy into the mapping except once per step.
+        //Single writer. Throws std::runtime_error when the file cannot be created or mapped.
+        class MessageJournalWriter {
+        public:
+            static constexpr size_t DEFAULT_GROWTH = size_t(64) << 20;
+
+            explicit MessageJournalWriter(const std::string& path, size_t growth = DEFAULT_GROWTH);
+            ~MessageJournalWriter();
+
+            MessageJournalWriter(const MessageJournalWriter&) = delete;
+            MessageJournalWriter& operator=(const MessageJournalWriter&) = delete;
+
+            //False when the file could not be grown, the record is then lost
+            bool append(const char* data, size_t len, int64_t recv_nanos);
+            //Schedules write back of the mapped pages, returns immediately
+            void flush();
+            //Truncates the file to the recorded length and unmaps it, called by the destructor
+            void close();
+
+            uint64_t get_record_count() const;
+            uint64_t get_bytes_written() const;
+            const std::string& get_path() const;
+
+        private:
+            std::string path;
+            size_t growth;
+            int fd = -1;
+            char* base = nullptr;
+            size_t mapped = 0;
+            size_t used = 0;
+
+            JournalHeader* header() const;
+            bool remap(size_t size);
+        };
+
+        //Read-only view of a journal, maps the whole file. Throws std::runtime_error for missing or foreign files.
+        class MessageJournalReader {
+        public:
+            struct Record {
+                const char* data;
+                size_t size;
+                int64_t recv_nanos;
+            };
+
+            explicit MessageJournalReader(const std::string& path);
+            ~MessageJournalReader();
+
+            MessageJournalReader(const MessageJournalReader&) = delete;
+            MessageJournalReader& operator=(const MessageJournalReader&) = delete;
+
+            //Calls fn(const Record&) on every complete record in file order, returns how many were visited
+            template<typename Fn>
+            size_t for_each(Fn&& fn) const {
+                size_t offset = sizeof(JournalHeader);
+                size_t count = 0;
+                while (offset + sizeof(JournalRecordHeader) <= end) {
+                    const JournalRecordHeader* record = reinterpret_cast<const JournalRecordHeader*>(base + offset);
+                    size_t next = offset + record_bytes(record->size);
+                    if (next > end) break;
+                    fn(Record{base + offset + sizeof(JournalRecordHeader), record->size, record->recv_nanos});
+                    offset = next;
+                    count++;
+                }
+                return count;
+            }
+
+            uint64_t get_record_count() const;
+            int64_t get_created_nanos() const;
+
+            static constexpr size_t record_bytes(size_t size) {
+                return sizeof(JournalRecordHeader) + ((size + 7) & ~size_t(7));
+            }
+
+        private:
+            const char* base = nullptr;
+            size_t mapped = 0;
+            size_t end = 0;
+        };
+    };
+};
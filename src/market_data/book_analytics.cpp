@@ -0,0 +1,80 @@
+#include "market_data/book_analytics.h"
+
+namespace pascal {
+    namespace market_data {
+        void BookAnalyticsTable::refresh(pascal::common::SymbolId id, const OrderBook& book) {
+            if (id >= pascal::common::SymbolRegistry::MAX_SYMBOLS) return;
+            recompute(slots[id], book);
+        }
+        void BookAnalyticsTable::on_increment(const pascal::common::MarketDataIncrement& update, const OrderBook& book) {
+            if (update.symbol_id >= pascal::common::SymbolRegistry::MAX_SYMBOLS) return;
+            Slot& slot = slots[update.symbol_id];
+
+            //A single entry increment replaces the touch wherever its price is, so it always recomputes
+            bool behind = slot.bounded && update.marketDepth != 1 && slot.synchronized == book.is_synchronized();
+            for (size_t i = 0; behind && i < update.md_entries.size(); i++) {
+                const auto& md = update.md_entries[i];
+                behind = md.side == pascal::common::Side::BID ? md.priceLevel.Price < slot.bid_boundary : md.priceLevel.Price > slot.ask_boundary;
+            }
+            if (behind) {
+                skipped_updates.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            recompute(slot, book);
+        }
+        void BookAnalyticsTable::recompute(Slot& slot, const OrderBook& book) {
+            //The levels land on the stack
+            std::array<pascal::common::PriceLevel, DEPTH> bids;
+            std::array<pascal::common::PriceLevel, DEPTH> asks;
+            size_t bidCount = book.get_bids(bids);
+            size_t askCount = book.get_asks(asks);
+
+            BookAnalytics values;
+            values.book_version = book.get_version();
+            double bidNotional = 0.0;
+            double askNotional = 0.0;
+            for (size_t i = 0; i < bidCount; i++) {
+                values.bid_depth += bids[i].Quantity;
+                bidNotional += static_cast<double>(bids[i].Price) * static_cast<double>(bids[i].Quantity);
+            }
+            for (size_t i = 0; i < askCount; i++) {
+                values.ask_depth += asks[i].Quantity;
+                askNotional += static_cast<double>(asks[i].Price) * static_cast<double>(asks[i].Quantity);
+            }
+            if (values.bid_depth > 0) values.bid_depth_price = bidNotional / static_cast<double>(values.bid_depth);
+            if (values.ask_depth > 0) values.ask_depth_price = askNotional / static_cast<double>(values.ask_depth);
+            if (values.bid_depth + values.ask_depth > 0) {
+                values.imbalance = static_cast<double>(values.bid_depth - values.ask_depth) / static_cast<double>(values.bid_depth + values.ask_depth);
+            }
+
+            bool synchronized = book.is_synchronized();
+            if (bidCount) values.best_bid = bids[0];
+            if (askCount) values.best_ask = asks[0];
+            if (bidCount && askCount) {
+                values.valid = synchronized;
+                values.spread = values.best_ask.Price - values.best_bid.Price;
+                values.mid = 0.5 * static_cast<double>(values.best_bid.Price + values.best_ask.Price);
+                double touchSize = static_cast<double>(values.best_bid.Quantity + values.best_ask.Quantity);
+                values.microprice = touchSize > 0.0
+                    ? (static_cast<double>(values.best_bid.Price) * static_cast<double>(values.best_ask.Quantity) + static_cast<double>(values.best_ask.Price) * static_cast<double>(values.best_bid.Quantity)) / touchSize
+                    : values.mid;
+            }
+
+            slot.seqlock.begin_write();
+            slot.values = values;
+            slot.seqlock.end_write();
+
+            slot.bounded = bidCount == DEPTH && askCount == DEPTH;
+            slot.bid_boundary = bidCount ? bids[bidCount-1].Price : 0;
+            slot.ask_boundary = askCount ? asks[askCount-1].Price : 0;
+            slot.synchronized = synchronized;
+            recomputes.fetch_add(1, std::memory_order_relaxed);
+        }
+        uint64_t BookAnalyticsTable::get_recomputes() const {
+            return recomputes.load(std::memory_order_relaxed);
+        }
+        uint64_t BookAnalyticsTable::get_skipped_updates() const {
+            return skipped_updates.load(std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,257 @@
+#include "market_data/consolidated_book.h"
+#include <algorithm>
+
+namespace pascal {
+    namespace market_data {
+        ConsolidatedBook::ConsolidatedBook(const std::string& symbol, const pascal::common::InstrumentSpec& spec) : symbol(symbol), spec(spec) {
+            //prevent resizing
+            bids.reserve(MAX_LEVELS);
+            asks.reserve(MAX_LEVELS);
+            scratch.reserve(MAX_LEVELS);
+        }
+        bool ConsolidatedBook::apply_increment(pascal::common::VenueId venue, const pascal::common::MarketDataIncrement& update, const OrderBook& venueBook, CrossVenueBBO& out) {
+            if (venue >= pascal::common::MAX_VENUES) return false;
+            uint32_t bit = uint32_t(1) << venue;
+            bool synchronized = venueBook.is_synchronized();
+
+            begin_update();
+            //Anything but a live venue taking the update is a change of membership
+            if (!(venues & bit) || !synchronized) {
+                fold_book(venue, venueBook, synchronized);
+                return end_update(out);
+            }
+            if (update.marketDepth == 1 && update.md_entries.front().update_action != pascal::common::UpdateAction::NEW) {
+                //Top of book stream, the entry changed the venue's best level wherever that was
+                pascal::common::Side side = update.md_entries.front().side;
+                const std::vector<ConsolidatedLevel>& levels = side == pascal::common::Side::BID ? bids : asks;
+                auto best = std::find_if(levels.rbegin(), levels.rend(), [venue](const ConsolidatedLevel& level) {
+                    return level.venue_quantity[venue] > 0;
+                });
+                if (best != levels.rend()) {
+                    pascal::common::Ticks price = best->price;
+                    set_level(venue, side, price, side == pascal::common::Side::BID ? venueBook.get_bid_quantity_at_price(price) : venueBook.get_ask_quantity_at_price(price));
+                }
+            }
+            //The venue book already holds the result, copy its quantity at every price the update touched
+            for (const auto& md : update.md_entries) {
+                pascal::common::Ticks price = md.priceLevel.Price;
+                if (md.side == pascal::common::Side::BID) set_level(venue, md.side, price, venueBook.get_bid_quantity_at_price(price));
+                else if (md.side == pascal::common::Side::OFFER) set_level(venue, md.side, price, venueBook.get_ask_quantity_at_price(price));
+            }
+            return end_update(out);
+        }
+        bool ConsolidatedBook::apply_book(pascal::common::VenueId venue, const OrderBook& venueBook, CrossVenueBBO& out) {
+            if (venue >= pascal::common::MAX_VENUES) return false;
+            bool synchronized = venueBook.is_synchronized();
+
+            begin_update();
+            fold_book(venue, venueBook, synchronized);
+            return end_update(out);
+        }
+        void ConsolidatedBook::fold_book(pascal::common::VenueId venue, const OrderBook& venueBook, bool synchronized) {
+            uint32_t bit = uint32_t(1) << venue;
+            if (!synchronized && !(venues & bit)) return;
+            clear_venue(venue);
+            venues &= ~bit;
+            if (!synchronized) return;
+            scratch.resize(venueBook.get_total_bid_levels());
+            scratch.resize(venueBook.get_bids(std::span<pascal::common::PriceLevel>(scratch)));
+            for (const auto& level : scratch) set_level(venue, pascal::common::Side::BID, level.Price, level.Quantity);
+            scratch.resize(venueBook.get_total_ask_levels());
+            scratch.resize(venueBook.get_asks(std::span<pascal::common::PriceLevel>(scratch)));
+            for (const auto& level : scratch) set_level(venue, pascal::common::Side::OFFER, level.Price, level.Quantity);
+            venues |= bit;
+        }
+        void ConsolidatedBook::begin_update() {
+            while (writer.test_and_set(std::memory_order_acquire)) pascal::common::cpu_relax();
+            seqlock.begin_write();
+        }
+        bool ConsolidatedBook::end_update(CrossVenueBBO& out) {
+            CrossVenueBBO next;
+            auto venues_of = [](const ConsolidatedLevel& level) {
+                uint32_t mask = 0;
+                for (size_t v = 0; v < level.venue_quantity.size(); v++) {
+                    if (level.venue_quantity[v] > 0) mask |= uint32_t(1) << v;
+                }
+                return mask;
+            };
+            if (!bids.empty()) {
+                next.bid = {.Price = bids.back().price, .Quantity = bids.back().quantity};
+                next.bid_venues = venues_of(bids.back());
+            }
+            if (!asks.empty()) {
+                next.ask = {.Price = asks.back().price, .Quantity = asks.back().quantity};
+                next.ask_venues = venues_of(asks.back());
+            }
+            bool changed = next.bid.Price != bbo.bid.Price || next.bid.Quantity != bbo.bid.Quantity || next.ask.Price != bbo.ask.Price ||
+                next.ask.Quantity != bbo.ask.Quantity || next.bid_venues != bbo.bid_venues || next.ask_venues != bbo.ask_venues;
+            if (changed) {
+                next.sequence = bbo.sequence+1;
+                bbo = next;
+                out = next;
+            }
+            seqlock.end_write();
+            writer.clear(std::memory_order_release);
+            return changed;
+        }
+        void ConsolidatedBook::set_level(pascal::common::VenueId venue, pascal::common::Side side, pascal::common::Ticks price, pascal::common::Lots quantity) {
+            bool bid = side == pascal::common::Side::BID;
+            std::vector<ConsolidatedLevel>& levels = bid ? bids : asks;
+            std::vector<ConsolidatedLevel>& deep = bid ? deepBids : deepAsks;
+            auto worse = [bid](pascal::common::Ticks a, pascal::common::Ticks b) {
+                return bid ? a < b : a > b;
+            };
+            auto position = [&worse, price](std::vector<ConsolidatedLevel>& sorted) {
+                return std::lower_bound(sorted.begin(), sorted.end(), price, [&worse](const ConsolidatedLevel& level, pascal::common::Ticks p) { return worse(level.price, p); });
+            };
+            if (quantity < 0) quantity = 0;
+
+            //Prices behind a full side live in the deep levels
+            bool kept = levels.size() < MAX_LEVELS || !worse(price, levels.front().price);
+            std::vector<ConsolidatedLevel>& target = kept ? levels : deep;
+            auto it = position(target);
+            if (it != target.end() && it->price == price) {
+                it->quantity += quantity - it->venue_quantity[venue];
+                it->venue_quantity[venue] = quantity;
+                if (it->quantity <= 0) {
+                    target.erase(it);
+                    if (kept) refill(levels, deep);
+                }
+                return;
+            }
+            if (quantity == 0) return;
+            ConsolidatedLevel level{.price = price, .quantity = quantity, .venue_quantity = {}};
+            level.venue_quantity[venue] = quantity;
+            if (kept && levels.size() == MAX_LEVELS) {
+                //Full, the worst kept level moves to the front of the deep ones, every venue's quantity with it
+                auto index = it - levels.begin() - 1;
+                deep.push_back(levels.front());
+                levels.erase(levels.begin());
+                it = levels.begin() + index;
+            }
+            target.insert(it, level);
+        }
+        void ConsolidatedBook::refill(std::vector<ConsolidatedLevel>& levels, std::vector<ConsolidatedLevel>& deep) {
+            //The best deep levels are worse than every kept one, they go in front in the same order
+            size_t moved = std::min(MAX_LEVELS - levels.size(), deep.size());
+            if (moved == 0) return;
+            levels.insert(levels.begin(), deep.end() - moved, deep.end());
+            deep.erase(deep.end() - moved, deep.end());
+        }
+        void ConsolidatedBook::clear_venue(pascal::common::VenueId venue) {
+            for (auto* levels : {&bids, &asks, &deepBids, &deepAsks}) {
+                for (auto& level : *levels) {
+                    level.quantity -= level.venue_quantity[venue];
+                    level.venue_quantity[venue] = 0;
+                }
+                levels->erase(std::remove_if(levels->begin(), levels->end(), [](const ConsolidatedLevel& level) {
+                    return level.quantity <= 0;
+                }), levels->end());
+            }
+            refill(bids, deepBids);
+            refill(asks, deepAsks);
+        }
+        CrossVenueBBO ConsolidatedBook::get_bbo() const {
+            return seqlock.read_consistent([this]() {
+                return bbo;
+            });
+        }
+        size_t ConsolidatedBook::get_bids(std::span<ConsolidatedLevel> out) const {
+            //Size is read once and clamped to the reserved storage, a concurrent writer can only make the copy stale
+            return seqlock.read_consistent([this, out]() {
+                const ConsolidatedLevel* data = bids.data();
+                size_t size = std::min(bids.size(), bids.capacity());
+                size_t n = std::min(out.size(), size);
+                for (size_t i = 0; i < n; i++) out[i] = data[size-1-i];
+                return n;
+            });
+        }
+        size_t ConsolidatedBook::get_asks(std::span<ConsolidatedLevel> out) const {
+            return seqlock.read_consistent([this, out]() {
+                const ConsolidatedLevel* data = asks.data();
+                size_t size = std::min(asks.size(), asks.capacity());
+                size_t n = std::min(out.size(), size);
+                for (size_t i = 0; i < n; i++) out[i] = data[size-1-i];
+                return n;
+            });
+        }
+        uint32_t ConsolidatedBook::get_venues() const {
+            return seqlock.read_consistent([this]() {
+                return venues;
+            });
+        }
+        const std::string& ConsolidatedBook::get_symbol() const {
+            return symbol;
+        }
+        const pascal::common::InstrumentSpec& ConsolidatedBook::get_instrument_spec() const {
+            return spec;
+        }
+        uint64_t ConsolidatedBook::get_version() const {
+            return seqlock.sequence();
+        }
+
+        ConsolidatedBookManager::ConsolidatedBookManager() {
+            for (auto& manager : venueManagers) manager = std::make_unique<FIXOrderBookManager>();
+        }
+        pascal::common::SymbolId ConsolidatedBookManager::add_symbol(pascal::common::VenueId venue, const std::string& symbol, const pascal::common::InstrumentSpec& spec, BookType type) {
+            if (venue >= pascal::common::MAX_VENUES) return pascal::common::INVALID_SYMBOL_ID;
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().register_symbol(symbol);
+            if (id == pascal::common::INVALID_SYMBOL_ID) return id;
+            if (!symbols[id]) {
+                symbols[id] = std::make_unique<SymbolBooks>(symbol, spec);
+            }
+            else {
+                const pascal::common::InstrumentSpec& shared = symbols[id]->consolidated.get_instrument_spec();
+                if (shared.tick_units != spec.tick_units || shared.lot_units != spec.lot_units) return pascal::common::INVALID_SYMBOL_ID;
+            }
+            venueManagers[venue]->add_symbol(symbol, spec, type);
+            symbols[id]->venues[venue] = venueManagers[venue]->get_book(id);
+            return id;
+        }
+        void ConsolidatedBookManager::process_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
+            SymbolBooks* books = symbol_books(snapshot.venue, snapshot.symbol_id);
+            if (!books) return;
+            venueManagers[snapshot.venue]->process_snapshot(snapshot);
+            CrossVenueBBO bbo;
+            if (books->consolidated.apply_book(snapshot.venue, *books->venues[snapshot.venue], bbo)) publish_bbo(snapshot.symbol_id, bbo);
+        }
+        void ConsolidatedBookManager::process_increment(const pascal::common::MarketDataIncrement& update) {
+            SymbolBooks* books = symbol_books(update.venue, update.symbol_id);
+            if (!books) return;
+            const OrderBook& book = *books->venues[update.venue];
+            uint64_t before = book.get_version();
+            bool synchronized = book.is_synchronized();
+            venueManagers[update.venue]->process_increment(update);
+            //Buffered or already covered, the venue book and so the consolidated one are unchanged
+            if (book.get_version() == before && book.is_synchronized() == synchronized) return;
+            CrossVenueBBO bbo;
+            if (books->consolidated.apply_increment(update.venue, update, book, bbo)) publish_bbo(update.symbol_id, bbo);
+        }
+        void ConsolidatedBookManager::set_bbo_handler(BboHandler handler) {
+            bboHandler = std::move(handler);
+        }
+        FIXOrderBookManager& ConsolidatedBookManager::get_venue(pascal::common::VenueId venue) {
+            return *venueManagers.at(venue);
+        }
+        std::shared_ptr<OrderBook> ConsolidatedBookManager::get_book(pascal::common::VenueId venue, pascal::common::SymbolId id) {
+            if (venue >= pascal::common::MAX_VENUES) return nullptr;
+            return venueManagers[venue]->get_book(id);
+        }
+        std::shared_ptr<OrderBook> ConsolidatedBookManager::get_book_by_symbol(pascal::common::VenueId venue, const std::string& symbol) {
+            return get_book(venue, pascal::common::SymbolRegistry::instance().find(symbol));
+        }
+        const ConsolidatedBook* ConsolidatedBookManager::get_consolidated(pascal::common::SymbolId id) const {
+            return id < symbols.size() && symbols[id] ? &symbols[id]->consolidated : nullptr;
+        }
+        const ConsolidatedBook* ConsolidatedBookManager::get_consolidated_by_symbol(const std::string& symbol) const {
+            return get_consolidated(pascal::common::SymbolRegistry::instance().find(symbol));
+        }
+        uint64_t ConsolidatedBookManager::get_bbo_changes() const {
+            return bbo_changes.load(std::memory_order_relaxed);
+        }
+        void ConsolidatedBookManager::publish_bbo(pascal::common::SymbolId id, const CrossVenueBBO& bbo) {
+            bbo_changes.fetch_add(1, std::memory_order_relaxed);
+            if (bboHandler) bboHandler(id, bbo);
+        }
+    }
+}
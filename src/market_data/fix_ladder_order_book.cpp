@@ -0,0 +1,359 @@
+#include "market_data/fix_ladder_order_book.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace pascal {
+    namespace market_data {
+        namespace {
+            constexpr ptrdiff_t TICKS_PER_SUMMARY_WORD = 64*64;
+        }
+
+        void FIXLadderOrderBook::Ladder::resize(size_t ticks) {
+            qty.assign(ticks, 0);
+            bits.assign(ticks/64, 0);
+            summary.assign(ticks/TICKS_PER_SUMMARY_WORD, 0);
+            levels = 0;
+        }
+        void FIXLadderOrderBook::Ladder::reset() {
+            if (!levels) return;
+            std::fill(qty.begin(), qty.end(), 0);
+            std::fill(bits.begin(), bits.end(), 0);
+            std::fill(summary.begin(), summary.end(), 0);
+            levels = 0;
+        }
+        void FIXLadderOrderBook::Ladder::set(ptrdiff_t idx, pascal::common::Lots quantity) {
+            if (qty[idx] <= 0) {
+                levels++;
+                bits[idx >> 6] |= 1ULL << (idx & 63);
+                summary[idx >> 12] |= 1ULL << ((idx >> 6) & 63);
+            }
+            qty[idx] = quantity;
+        }
+        void FIXLadderOrderBook::Ladder::clear(ptrdiff_t idx) {
+            if (qty[idx] <= 0) return;
+            levels--;
+            qty[idx] = 0;
+            uint64_t& word = bits[idx >> 6];
+            word &= ~(1ULL << (idx & 63));
+            if (!word) summary[idx >> 12] &= ~(1ULL << ((idx >> 6) & 63));
+        }
+        ptrdiff_t FIXLadderOrderBook::Ladder::highest_at_or_below(ptrdiff_t idx) const {
+            if (idx < 0) return -1;
+            ptrdiff_t w = idx >> 6;
+            int bit = idx & 63;
+            uint64_t word = bits[w] & (bit == 63 ? ~0ULL : ((1ULL << (bit+1)) - 1));
+            if (word) return (w << 6) + 63 - __builtin_clzll(word);
+
+            //Words strictly below w
+            ptrdiff_t s = w >> 6;
+            int sbit = w & 63;
+            uint64_t sword = summary[s] & ((1ULL << sbit) - 1);
+            while (true) {
+                if (sword) {
+                    //A reader can see the summary bit of a word the writer just emptied, the seqlock retries it
+                    ptrdiff_t ww = (s << 6) + 63 - __builtin_clzll(sword);
+                    uint64_t found = bits[ww];
+                    return found ? (ww << 6) + 63 - __builtin_clzll(found) : -1;
+                }
+                if (--s < 0) return -1;
+                sword = summary[s];
+            }
+        }
+        ptrdiff_t FIXLadderOrderBook::Ladder::lowest_at_or_above(ptrdiff_t idx) const {
+            if (idx >= static_cast<ptrdiff_t>(qty.size())) return -1;
+            ptrdiff_t w = idx >> 6;
+            uint64_t word = bits[w] & (~0ULL << (idx & 63));
+            if (word) return (w << 6) + __builtin_ctzll(word);
+
+            //Words strictly above w
+            ptrdiff_t s = w >> 6;
+            int sbit = w & 63;
+            uint64_t sword = sbit == 63 ? 0 : summary[s] & (~0ULL << (sbit+1));
+            while (true) {
+                if (sword) {
+                    ptrdiff_t ww = (s << 6) + __builtin_ctzll(sword);
+                    uint64_t found = bits[ww];
+                    return found ? (ww << 6) + __builtin_ctzll(found) : -1;
+                }
+                if (++s >= static_cast<ptrdiff_t>(summary.size())) return -1;
+                sword = summary[s];
+            }
+        }
+
+        FIXLadderOrderBook::FIXLadderOrderBook(const std::string& symbol, const pascal::common::InstrumentSpec& spec, size_t window_ticks) : OrderBook(symbol, spec) {
+            size_t words = std::max<size_t>(1, (window_ticks + TICKS_PER_SUMMARY_WORD - 1) / TICKS_PER_SUMMARY_WORD);
+            window = static_cast<ptrdiff_t>(words * TICKS_PER_SUMMARY_WORD);
+            bidLadder.resize(window);
+            askLadder.resize(window);
+
+            //Readers may walk the far levels while the writer changes them, keep their storage from moving
+            farBids.reserve(MAX_FAR_LEVELS);
+            farAsks.reserve(MAX_FAR_LEVELS);
+        }
+
+        void FIXLadderOrderBook::initialize_from_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
+            pascal::common::SeqLock::WriteGuard write(seqlock);
+            clear_book();
+
+            //Anchor the window on the touch of the snapshot
+            auto bestBid = std::max_element(snapshot.bids.begin(), snapshot.bids.end(), [](auto a, auto b) {
+                return a.Price < b.Price;
+            });
+            auto bestAsk = std::min_element(snapshot.asks.begin(), snapshot.asks.end(), [](auto a, auto b) {
+                return a.Price < b.Price;
+            });
+            if (bestBid != snapshot.bids.end() && bestAsk != snapshot.asks.end()) {
+                base_ = (bestBid->Price + bestAsk->Price)/2 - window/2;
+                anchored_ = true;
+            }
+            else if (bestBid != snapshot.bids.end()) {
+                base_ = bestBid->Price - window/2;
+                anchored_ = true;
+            }
+            else if (bestAsk != snapshot.asks.end()) {
+                base_ = bestAsk->Price - window/2;
+                anchored_ = true;
+            }
+
+            for (const auto& level : snapshot.bids) {
+                apply_level(pascal::common::Side::BID, level.Price, pascal::common::UpdateAction::CHANGE, level.Quantity);
+            }
+            for (const auto& level : snapshot.asks) {
+                apply_level(pascal::common::Side::OFFER, level.Price, pascal::common::UpdateAction::CHANGE, level.Quantity);
+            }
+
+            is_synchronized_.store(true, std::memory_order_release);
+            total_updates_processed.fetch_add(1, std::memory_order_release);
+            last_update_time = pascal::common::TscClock::now();
+        }
+        void FIXLadderOrderBook::update_from_increment(const pascal::common::MarketDataIncrement& update) {
+            pascal::common::SeqLock::WriteGuard write(seqlock);
+            for (const auto& md : update.md_entries) {
+                if (update.marketDepth == 1 && md.update_action == pascal::common::UpdateAction::CHANGE) {
+                    //Top of book stream, the entry replaces the current best level
+                    auto best = md.side == pascal::common::Side::BID ? best_bid_level() : best_ask_level();
+                    if (best.Quantity > 0 && best.Price != md.priceLevel.Price) {
+                        apply_level(md.side, best.Price, pascal::common::UpdateAction::CHANGE, 0);
+                    }
+                }
+                apply_level(md.side, md.priceLevel.Price, md.update_action, md.priceLevel.Quantity);
+            }
+            maybe_recenter();
+
+            total_updates_processed.fetch_add(1, std::memory_order_relaxed);
+            last_update_time = pascal::common::TscClock::now();
+        }
+
+        void FIXLadderOrderBook::apply_level(pascal::common::Side side, pascal::common::Ticks price, pascal::common::UpdateAction action, pascal::common::Lots quantity) {
+            if (!anchored_) {
+                base_ = price - window/2;
+                anchored_ = true;
+            }
+            ptrdiff_t idx = price - base_;
+            if (idx < 0 || idx >= window) {
+                //Parked outside the window, maybe_recenter moves the window if this became the touch
+                apply_far_level(side, price, action, quantity);
+                return;
+            }
+
+            if (side == pascal::common::Side::BID) {
+                pascal::common::Lots next = next_quantity(action, bidLadder.qty[idx], quantity);
+                if (next <= 0) {
+                    bidLadder.clear(idx);
+                    if (idx == bestBid_) bestBid_ = bidLadder.highest_at_or_below(idx-1);
+                }
+                else {
+                    bidLadder.set(idx, next);
+                    if (idx > bestBid_) bestBid_ = idx;
+                }
+            }
+            else {
+                pascal::common::Lots next = next_quantity(action, askLadder.qty[idx], quantity);
+                if (next <= 0) {
+                    askLadder.clear(idx);
+                    if (idx == bestAsk_) bestAsk_ = askLadder.lowest_at_or_above(idx+1);
+                }
+                else {
+                    askLadder.set(idx, next);
+                    if (bestAsk_ < 0 || idx < bestAsk_) bestAsk_ = idx;
+                }
+            }
+        }
+        void FIXLadderOrderBook::apply_far_level(pascal::common::Side side, pascal::common::Ticks price, pascal::common::UpdateAction action, pascal::common::Lots quantity) {
+            auto& far = side == pascal::common::Side::BID ? farBids : farAsks;
+            std::vector<pascal::common::PriceLevel>::iterator it;
+            if (side == pascal::common::Side::BID) {
+                it = std::lower_bound(far.begin(), far.end(), price, [](const auto& level, pascal::common::Ticks p) {
+                    return level.Price > p;
+                });
+            }
+            else {
+                it = std::lower_bound(far.begin(), far.end(), price, [](const auto& level, pascal::common::Ticks p) {
+                    return level.Price < p;
+                });
+            }
+            bool found = it != far.end() && it->Price == price;
+            pascal::common::Lots next = next_quantity(action, found ? it->Quantity : 0, quantity);
+            if (next <= 0) {
+                if (found) far.erase(it);
+            }
+            else if (found) {
+                it->Quantity = next;
+            }
+            else {
+                //Full, the new level displaces the worst one unless it is worse still. Growing past the
+                //reserved storage would move it under readers
+                if (far.size() == MAX_FAR_LEVELS) {
+                    if (it == far.end()) return;
+                    auto position = it - far.begin();
+                    far.pop_back();
+                    it = far.begin() + position;
+                }
+                far.insert(it, pascal::common::PriceLevel{.Price = price, .Quantity = next});
+            }
+        }
+        void FIXLadderOrderBook::recenter(pascal::common::Ticks center) {
+            //Collect every level best first, then re-home them against the new window
+            scratchBids.resize(bid_levels());
+            scratchBids.resize(copy_bids(scratchBids.data(), scratchBids.size()));
+            scratchAsks.resize(ask_levels());
+            scratchAsks.resize(copy_asks(scratchAsks.data(), scratchAsks.size()));
+
+            clear_book();
+            base_ = center - window/2;
+            anchored_ = true;
+            total_recenters++;
+
+            //Levels are visited best first, so out of window levels are appended to the far vectors in order
+            //and the ones past MAX_FAR_LEVELS are the worst
+            for (const auto& level : scratchBids) {
+                ptrdiff_t idx = level.Price - base_;
+                if (idx >= 0 && idx < window) {
+                    bidLadder.set(idx, level.Quantity);
+                    if (idx > bestBid_) bestBid_ = idx;
+                }
+                else if (farBids.size() < MAX_FAR_LEVELS) {
+                    farBids.emplace_back(level);
+                }
+            }
+            for (const auto& level : scratchAsks) {
+                ptrdiff_t idx = level.Price - base_;
+                if (idx >= 0 && idx < window) {
+                    askLadder.set(idx, level.Quantity);
+                    if (bestAsk_ < 0 || idx < bestAsk_) bestAsk_ = idx;
+                }
+                else if (farAsks.size() < MAX_FAR_LEVELS) {
+                    farAsks.emplace_back(level);
+                }
+            }
+        }
+        void FIXLadderOrderBook::maybe_recenter() {
+            auto bid = best_bid_level();
+            auto ask = best_ask_level();
+            ptrdiff_t bidIdx = bid.Price - base_;
+            ptrdiff_t askIdx = ask.Price - base_;
+            bool bidsOutside = bid.Quantity > 0 && (bidIdx < 0 || bidIdx >= window - window/8);
+            bool asksOutside = ask.Quantity > 0 && (askIdx < window/8 || askIdx >= window);
+            if (!bidsOutside && !asksOutside) return;
+
+            pascal::common::Ticks center;
+            if (bid.Quantity > 0 && ask.Quantity > 0) center = (bid.Price + ask.Price)/2;
+            else if (bid.Quantity > 0) center = bid.Price;
+            else if (ask.Quantity > 0) center = ask.Price;
+            else return;
+
+            //Only move when the touch has really drifted, a spread wider than the window must not thrash
+            ptrdiff_t shift = center - (base_ + window/2);
+            if (std::abs(shift) > window/8) recenter(center);
+        }
+        void FIXLadderOrderBook::clear_book() {
+            bidLadder.reset();
+            askLadder.reset();
+            farBids.clear();
+            farAsks.clear();
+            bestBid_ = -1;
+            bestAsk_ = -1;
+            anchored_ = false;
+        }
+
+        //Far levels normally sit behind the window, but a touch that jumped past it is parked there
+        //until maybe_recenter runs, so the best level is the better of the two candidates
+        pascal::common::PriceLevel FIXLadderOrderBook::best_bid_level() const {
+            ptrdiff_t idx = bestBid_;
+            if (idx >= 0 && idx < window && (farBids.empty() || base_+idx > farBids.front().Price)) {
+                return pascal::common::PriceLevel{.Price = base_+idx, .Quantity = bidLadder.qty[idx]};
+            }
+            if (!farBids.empty()) return farBids.front();
+            return pascal::common::PriceLevel{.Price = 0, .Quantity = 0};
+        }
+        pascal::common::PriceLevel FIXLadderOrderBook::best_ask_level() const {
+            ptrdiff_t idx = bestAsk_;
+            if (idx >= 0 && idx < window && (farAsks.empty() || base_+idx < farAsks.front().Price)) {
+                return pascal::common::PriceLevel{.Price = base_+idx, .Quantity = askLadder.qty[idx]};
+            }
+            if (!farAsks.empty()) return farAsks.front();
+            return pascal::common::PriceLevel{.Price = 0, .Quantity = 0};
+        }
+        size_t FIXLadderOrderBook::copy_bids(pascal::common::PriceLevel* out, size_t depth) const {
+            //Merge the window and the far levels, both descending. Indices are checked against the window
+            //since a read racing the writer can see any of them, the seqlock throws such a copy away
+            size_t n = 0;
+            size_t far = 0;
+            ptrdiff_t idx = bestBid_;
+            while (n < depth && (idx >= 0 || far < farBids.size())) {
+                if (idx >= window) break;
+                if (idx >= 0 && (far == farBids.size() || base_+idx > farBids[far].Price)) {
+                    out[n++] = pascal::common::PriceLevel{.Price = base_+idx, .Quantity = bidLadder.qty[idx]};
+                    idx = bidLadder.highest_at_or_below(idx-1);
+                }
+                else {
+                    out[n++] = farBids[far++];
+                }
+            }
+            return n;
+        }
+        size_t FIXLadderOrderBook::copy_asks(pascal::common::PriceLevel* out, size_t depth) const {
+            //Merge the window and the far levels, both ascending
+            size_t n = 0;
+            size_t far = 0;
+            ptrdiff_t idx = bestAsk_;
+            while (n < depth && (idx >= 0 || far < farAsks.size())) {
+                if (idx >= window) break;
+                if (idx >= 0 && (far == farAsks.size() || base_+idx < farAsks[far].Price)) {
+                    out[n++] = pascal::common::PriceLevel{.Price = base_+idx, .Quantity = askLadder.qty[idx]};
+                    idx = askLadder.lowest_at_or_above(idx+1);
+                }
+                else {
+                    out[n++] = farAsks[far++];
+                }
+            }
+            return n;
+        }
+
+        pascal::common::Lots FIXLadderOrderBook::bid_quantity_at(pascal::common::Ticks price) const {
+            ptrdiff_t idx = price - base_;
+            if (idx >= 0 && idx < window) return bidLadder.qty[idx];
+            auto it = std::find_if(farBids.begin(), farBids.end(), [price](const auto& level) {
+                return level.Price == price;
+            });
+            return it == farBids.end() ? 0 : it->Quantity;
+        }
+        pascal::common::Lots FIXLadderOrderBook::ask_quantity_at(pascal::common::Ticks price) const {
+            ptrdiff_t idx = price - base_;
+            if (idx >= 0 && idx < window) return askLadder.qty[idx];
+            auto it = std::find_if(farAsks.begin(), farAsks.end(), [price](const auto& level) {
+                return level.Price == price;
+            });
+            return it == farAsks.end() ? 0 : it->Quantity;
+        }
+        size_t FIXLadderOrderBook::bid_levels() const {
+            return bidLadder.levels + farBids.size();
+        }
+        size_t FIXLadderOrderBook::ask_levels() const {
+            return askLadder.levels + farAsks.size();
+        }
+        uint64_t FIXLadderOrderBook::get_total_recenters() const {
+            return total_recenters;
+        }
+    }
+}
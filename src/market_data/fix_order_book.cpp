@@ -1,26 +1,82 @@
 #include "market_data/fix_order_book.h"
+#include "market_data/fix_ladder_order_book.h"
 #include <algorithm>
+#include <functional>
 #include <mutex>
+#include <utility>
 
 namespace pascal {
     namespace market_data {
         void FIXOrderBook::initialize_from_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
-            uint64_t newVersion = version_.load()+1;
-            bids = std::move(snapshot.bids);
-            std::sort(bids.begin(), bids.end(), [](auto a, auto b) {
+            std::sort(snapshot.bids.begin(), snapshot.bids.end(), [](auto a, auto b) {
                 return a.Price < b.Price;
             });
-            asks = std::move(snapshot.asks);
-            std::sort(asks.begin(), asks.end(), [](auto a, auto b) {
+            std::sort(snapshot.asks.begin(), snapshot.asks.end(), [](auto a, auto b) {
                 return a.Price > b.Price;
             });
+
+            //Copy into the reserved storage rather than adopting the snapshot buffers, readers may still be walking them
+            pascal::common::SeqLock::WriteGuard write(seqlock);
+            bids.clear();
+            asks.clear();
+            append_levels(bids, snapshot.bids.begin(), snapshot.bids.end());
+            append_levels(asks, snapshot.asks.begin(), snapshot.asks.end());
             is_synchronized_.store(true, std::memory_order_release);
             total_updates_processed.fetch_add(1, std::memory_order_release);
-            last_update_time = std::chrono::high_resolution_clock::now();
-            version_.store(newVersion, std::memory_order_release);
+            last_update_time = pascal::common::TscClock::now();
+        }
+        template<typename Before>
+        void FIXOrderBook::merge_side(pascal::common::Side side, const pascal::common::MarketDataIncrement& update, std::vector<pascal::common::PriceLevel>& levels, Before before) {
+            mergeEntries.clear();
+            uint32_t seq = 0;
+            for (const auto& md : update.md_entries) {
+                if (md.side == side) mergeEntries.push_back({md.priceLevel.Price, md.priceLevel.Quantity, md.update_action, seq});
+                seq++;
+            }
+            if (mergeEntries.empty()) return;
+            std::sort(mergeEntries.begin(), mergeEntries.end(), [before](const MergeEntry& a, const MergeEntry& b) {
+                return a.price != b.price ? before(a.price, b.price) : a.seq < b.seq;
+            });
+
+            //Levels stored ahead of the first touched price stay in place, only the tail behind it is rebuilt
+            auto first = std::lower_bound(levels.begin(), levels.end(), mergeEntries.front().price, [before](const pascal::common::PriceLevel& level, pascal::common::Ticks price) {
+                return before(level.Price, price);
+            });
+            mergeTail.assign(first, levels.end());
+            levels.erase(first, levels.end());
+
+            auto tail = mergeTail.begin();
+            for (auto entry = mergeEntries.begin(); entry != mergeEntries.end();) {
+                pascal::common::Ticks price = entry->price;
+                auto kept = tail;
+                while (tail != mergeTail.end() && before(tail->Price, price)) ++tail;
+                append_levels(levels, kept, tail);
+                pascal::common::Lots quantity = 0;
+                if (tail != mergeTail.end() && tail->Price == price) quantity = (tail++)->Quantity;
+
+                //Entries at one price apply in message order, a level left without quantity is dropped
+                for (; entry != mergeEntries.end() && entry->price == price; ++entry) {
+                    switch (entry->action) {
+                        case pascal::common::UpdateAction::NEW :
+                            quantity += entry->quantity;
+                            break;
+                        case pascal::common::UpdateAction::DELETE :
+                            quantity -= entry->quantity;
+                            break;
+                        case pascal::common::UpdateAction::CHANGE :
+                            quantity = entry->quantity;
+                            break;
+                    }
+                }
+                if (quantity > 0) {
+                    pascal::common::PriceLevel level{.Price = price, .Quantity = quantity};
+                    append_levels(levels, &level, &level + 1);
+                }
+            }
+            append_levels(levels, tail, mergeTail.end());
         }
         void FIXOrderBook::update_from_increment(const pascal::common::MarketDataIncrement& update) {
-            uint64_t newVersion = version_.load()+1;
+            pascal::common::SeqLock::WriteGuard write(seqlock);
             if (update.marketDepth == 1) {
                 auto md = update.md_entries.front();
                 switch (md.update_action) {
@@ -43,205 +99,243 @@ namespace pascal {
                 }
             }
             else {
-                for (auto md : update.md_entries) {
-                    std::vector<pascal::common::PriceLevel>::iterator it;
-                    if (md.side == pascal::common::BID) {
-                        auto priceLevel = md.priceLevel;
-                        it = std::find_if(bids.begin(), bids.end(), [priceLevel](auto& price) {
-                            return priceLevel.Price <= price.Price;
-                        });
-                    }
-                    else {
-                        auto priceLevel = md.priceLevel;
-                        it = std::find_if(asks.begin(), asks.end(), [priceLevel](auto& price) {
-                            return priceLevel.Price >= price.Price;
-                        });
-                    }
-
-                    switch (md.update_action) {
-                        case pascal::common::UpdateAction::NEW :
-                            if (md.side == pascal::common::BID) {
-                                if (it == bids.end()) {
-                                    bids.emplace_back(md.priceLevel);
-                                }
-                                else if (it->Price == md.priceLevel.Price) {
-                                    it->Quantity += md.priceLevel.Quantity;
-                                }
-                                else {
-                                    bids.emplace(it, md.priceLevel);
-                                }
-                            }
-                            else {
-                                if (it == asks.end()) {
-                                    asks.emplace_back(md.priceLevel);
-                                }
-                                else if (it->Price == md.priceLevel.Price) {
-                                    it->Quantity += md.priceLevel.Quantity;
-                                }
-                                else {
-                                    asks.emplace(it, md.priceLevel);
-                                }
-                            }
-                            break;
-
-                        case pascal::common::UpdateAction::DELETE :
-                            it->Quantity -= md.priceLevel.Quantity;
-                            if (md.side == pascal::common::BID) {
-                                if (it->Quantity == 0) bids.erase(it);
-                            }
-                            else {
-                                if (it->Quantity == 0) asks.erase(it);
-                            }
-                            break;
-
-                        case pascal::common::UpdateAction::CHANGE :
-                            it->Quantity = md.priceLevel.Quantity;
-                            break; 
-                    }
-                }
+                //Bids are stored ascending and asks descending, so the touch is the back of both
+                merge_side(pascal::common::Side::BID, update, bids, std::less<pascal::common::Ticks>{});
+                merge_side(pascal::common::Side::OFFER, update, asks, std::greater<pascal::common::Ticks>{});
             }
-            is_synchronized_.store(true, std::memory_order_relaxed);
             total_updates_processed.fetch_add(1, std::memory_order_relaxed);
-            last_update_time = std::chrono::high_resolution_clock::now();
-            version_.store(newVersion, std::memory_order_release);
+            last_update_time = pascal::common::TscClock::now();
         }
         
-        pascal::common::PriceLevel FIXOrderBook::get_best_bid() const {
-            uint64_t v1, v2;
-            pascal::common::PriceLevel result;
-            do {
-                v1 = version_.load(std::memory_order_acquire);
-                result = bids.back();
-                v2 = version_.load(std::memory_order_acquire);
-            } while (v1 != v2);
-
-            return result;
-        }
-        pascal::common::PriceLevel FIXOrderBook::get_best_ask() const {
-            uint64_t v1, v2;
-            pascal::common::PriceLevel result;
-            do {
-                v1 = version_.load(std::memory_order_acquire);
-                result = asks.back();
-                v2 = version_.load(std::memory_order_acquire);
-            } while (v1 != v2);
-
-            return result;
-        }
-        std::vector<pascal::common::PriceLevel> FIXOrderBook::get_bids(size_t depth) const {
-            uint64_t v1, v2;
-            do {
-                v1 = version_.load(std::memory_order_acquire);
-                v2 = version_.load(std::memory_order_acquire);
-            } while (v1 != v2);
-            
-            return bids;
-        }
-        std::vector<pascal::common::PriceLevel> FIXOrderBook::get_asks(size_t depth) const {
-            uint64_t v1, v2;
-            do {
-                v1 = version_.load(std::memory_order_acquire);
-                v2 = version_.load(std::memory_order_acquire);
-            } while (v1 != v2);
-            
-            return asks;
-        }
-        double FIXOrderBook::get_bid_quantity_at_price(double price) {
-            uint64_t v1, v2;
-            double quantity = 0;
-            do {
-                v1 = version_.load(std::memory_order_acquire);
-                auto it = std::find_if(bids.begin(), bids.end(), [price](auto priceLvl) {
-                    return priceLvl.Price == price;
-                });
-                quantity = it->Quantity;
-                v2 = version_.load(std::memory_order_acquire);
-            } while (v1 != v2);
-            
-            return quantity;
-        }
-        double FIXOrderBook::get_ask_quantity_at_price(double price) {
-            uint64_t v1, v2;
-            double quantity = 0;
-            do {
-                v1 = version_.load(std::memory_order_acquire);
-                auto it = std::find_if(asks.begin(), asks.end(), [price](auto priceLvl) {
-                    return priceLvl.Price == price;
-                });
-                quantity = it->Quantity;
-                v2 = version_.load(std::memory_order_acquire);
-            } while (v1 != v2);
-            
-            return quantity;
-        }
-        bool FIXOrderBook::is_synchronized() const {
-            return is_synchronized_.load(std::memory_order_acquire);
-        }
-        std::chrono::high_resolution_clock::time_point FIXOrderBook::get_last_update_time() const {
-            return last_update_time;
-        }
-        size_t FIXOrderBook::get_total_bid_levels() const {
-            uint64_t v1, v2;
-            size_t size;
-            do {
-                v1 = version_.load(std::memory_order_acquire);
-                size = bids.size();
-                v2 = version_.load(std::memory_order_acquire);
-            } while (v1 != v2);
-
-            return size;
-        }
-        size_t FIXOrderBook::get_total_ask_levels() const {
-            uint64_t v1, v2;
-            size_t size;
-            do {
-                v1 = version_.load(std::memory_order_acquire);
-                size = asks.size();
-                v2 = version_.load(std::memory_order_acquire);
-            } while (v1 != v2);
-
-            return size;
+        pascal::common::PriceLevel FIXOrderBook::best_bid_level() const {
+            size_t size = std::min(bids.size(), bids.capacity());
+            if (!size) return pascal::common::PriceLevel{.Price = 0, .Quantity = 0};
+            return bids.data()[size-1];
         }
-        uint64_t FIXOrderBook::get_total_updates_processed() const {
-            return total_updates_processed.load(std::memory_order_relaxed);
+        pascal::common::PriceLevel FIXOrderBook::best_ask_level() const {
+            size_t size = std::min(asks.size(), asks.capacity());
+            if (!size) return pascal::common::PriceLevel{.Price = 0, .Quantity = 0};
+            return asks.data()[size-1];
+        }
+        size_t FIXOrderBook::copy_bids(pascal::common::PriceLevel* out, size_t depth) const {
+            //Best level is at the back, size is read once and clamped to the reserved storage so a
+            //concurrent writer can only make the copy stale (caught by the version check), never out of bounds
+            const pascal::common::PriceLevel* data = bids.data();
+            size_t size = std::min(bids.size(), bids.capacity());
+            size_t n = std::min(depth, size);
+            for (size_t i = 0; i < n; i++) {
+                out[i] = data[size-1-i];
+            }
+            return n;
+        }
+        size_t FIXOrderBook::copy_asks(pascal::common::PriceLevel* out, size_t depth) const {
+            const pascal::common::PriceLevel* data = asks.data();
+            size_t size = std::min(asks.size(), asks.capacity());
+            size_t n = std::min(depth, size);
+            for (size_t i = 0; i < n; i++) {
+                out[i] = data[size-1-i];
+            }
+            return n;
+        }
+        pascal::common::Lots FIXOrderBook::bid_quantity_at(pascal::common::Ticks price) const {
+            auto it = std::find_if(bids.begin(), bids.end(), [price](const auto& priceLvl) {
+                return priceLvl.Price == price;
+            });
+            return it == bids.end() ? 0 : it->Quantity;
+        }
+        pascal::common::Lots FIXOrderBook::ask_quantity_at(pascal::common::Ticks price) const {
+            auto it = std::find_if(asks.begin(), asks.end(), [price](const auto& priceLvl) {
+                return priceLvl.Price == price;
+            });
+            return it == asks.end() ? 0 : it->Quantity;
+        }
+        size_t FIXOrderBook::bid_levels() const {
+            return bids.size();
+        }
+        size_t FIXOrderBook::ask_levels() const {
+            return asks.size();
         }
 
-        void FIXOrderBookManager::add_symbol(const std::string& symbol) {
-            std::unique_lock<std::shared_mutex> lk(book_mtx);
-            books[symbol] = std::make_shared<FIXOrderBook>(symbol);
+        pascal::common::SymbolId FIXOrderBookManager::add_symbol(const std::string& symbol, const pascal::common::InstrumentSpec& spec, BookType type) {
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().register_symbol(symbol);
+            if (id == pascal::common::INVALID_SYMBOL_ID) return id;
+            std::lock_guard<std::mutex> lk(table_mtx);
+            auto next = std::make_shared<BookTable>(*currentTable);
+            BookEntry& entry = next->entries[id];
+            if (!entry.book) next->totalBooks++;
+            entry.sequence = std::make_shared<BookSequence>();
+            if (type == BookType::LADDER) {
+                entry.book = std::make_shared<FIXLadderOrderBook>(symbol, spec);
+            }
+            else {
+                entry.book = std::make_shared<FIXOrderBook>(symbol, spec);
+            }
+            publish_table(std::move(next));
+            return id;
         }
         void FIXOrderBookManager::remove_symbol(const std::string& symbol) {
-            std::unique_lock<std::shared_mutex> lk(book_mtx);
-            books.erase(symbol);
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().find(symbol);
+            std::lock_guard<std::mutex> lk(table_mtx);
+            if (id >= pascal::common::SymbolRegistry::MAX_SYMBOLS || !currentTable->entries[id].book) return;
+            auto next = std::make_shared<BookTable>(*currentTable);
+            next->entries[id] = BookEntry{};
+            next->totalBooks--;
+            publish_table(std::move(next));
+        }
+        void FIXOrderBookManager::publish_table(std::shared_ptr<const BookTable> next) {
+            //Readers that loaded the old table keep using it (and the books only it holds) until their guard ends
+            table.store(next.get(), std::memory_order_seq_cst);
+            epochs.retire(std::exchange(currentTable, std::move(next)));
+            epochs.reclaim();
         }
         void FIXOrderBookManager::process_snapshot(pascal::common::MarketDataSnapshot& snapshot) {
-            std::string symbol = snapshot.symbol;
-            books[symbol]->initialize_from_snapshot(snapshot);
+            pascal::common::EpochDomain::Guard guard(epochs);
+            const BookEntry* entry = entry_for(snapshot.symbol_id);
+            if (!entry) return;
+            OrderBook* book = entry->book.get();
+            book->initialize_from_snapshot(snapshot);
             total_updates_processed.fetch_add(1, std::memory_order_relaxed);
+            mark_dirty(snapshot.symbol_id);
+            if (analytics) analytics->refresh(snapshot.symbol_id, *book);
+            if (publisher) publisher->publish(*book);
+
+            BookSequence& sequence = *entry->sequence;
+            sequence.last_update_id = snapshot.last_update_id;
+            sequence.last_first_id = 0;
+            sequence.resync_requested = false;
+            sequence.overflowed = 0;
+            //Replay what arrived while the snapshot was on the way, stopping at the first hole it doesn't cover
+            while (!sequence.pending.empty()) {
+                if (!apply_in_sequence(*book, sequence, sequence.pending.front())) {
+                    book->mark_unsynchronized();
+                    if (analytics) analytics->refresh(snapshot.symbol_id, *book);
+                    if (publisher) publisher->publish(*book);
+                    total_sequence_gaps.fetch_add(1, std::memory_order_relaxed);
+                    request_resync(snapshot.symbol_id, sequence);
+                    return;
+                }
+                sequence.pending.pop_front();
+            }
         }
         void FIXOrderBookManager::process_increment(const pascal::common::MarketDataIncrement& update) {
-            std::string symbol = update.symbol;
-            books[symbol]->update_from_increment(update);
+            pascal::common::EpochDomain::Guard guard(epochs);
+            const BookEntry* entry = entry_for(update.symbol_id);
+            if (!entry) return;
+            OrderBook* book = entry->book.get();
+            if (update.last_update_id == 0) {
+                book->update_from_increment(update);
+                total_updates_processed.fetch_add(1, std::memory_order_relaxed);
+                mark_dirty(update.symbol_id);
+                if (analytics) analytics->on_increment(update, *book);
+                if (publisher) publisher->publish(*book);
+                return;
+            }
+
+            BookSequence& sequence = *entry->sequence;
+            if (!book->is_synchronized()) {
+                //Before the first snapshot or while a resync is outstanding
+                buffer_update(sequence, update);
+                return;
+            }
+            if (!apply_in_sequence(*book, sequence, update)) {
+                book->mark_unsynchronized();
+                if (analytics) analytics->refresh(update.symbol_id, *book);
+                if (publisher) publisher->publish(*book);
+                total_sequence_gaps.fetch_add(1, std::memory_order_relaxed);
+                buffer_update(sequence, update);
+                request_resync(update.symbol_id, sequence);
+            }
+        }
+        void FIXOrderBookManager::set_resync_handler(ResyncHandler handler) {
+            resyncHandler = std::move(handler);
+        }
+        void FIXOrderBookManager::set_conflation(bool enabled) {
+            conflation = enabled;
+        }
+        void FIXOrderBookManager::set_analytics(BookAnalyticsTable* table) {
+            analytics = table;
+        }
+        void FIXOrderBookManager::set_publisher(ShmBookPublisher* shm) {
+            publisher = shm;
+        }
+        bool FIXOrderBookManager::take_conflated(pascal::common::SymbolId id) {
+            if (id >= pascal::common::SymbolRegistry::MAX_SYMBOLS) return false;
+            uint64_t bit = uint64_t(1) << (id % 64);
+            if (!(dirtySymbols[id / 64].bits.fetch_and(~bit, std::memory_order_acquire) & bit)) return false;
+            conflation_deliveries.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        bool FIXOrderBookManager::apply_in_sequence(OrderBook& book, BookSequence& sequence, const pascal::common::MarketDataIncrement& update) {
+            bool fragment = update.first_update_id == sequence.last_first_id && update.last_update_id == sequence.last_update_id;
+            if (update.last_update_id <= sequence.last_update_id && !fragment) return true; //already in the book
+            //Continues the book, or overlaps the snapshot it follows. A book without ids yet adopts the feed's
+            if (sequence.last_update_id != 0 && update.first_update_id > sequence.last_update_id + 1) return false;
+
+            book.update_from_increment(update);
             total_updates_processed.fetch_add(1, std::memory_order_relaxed);
+            mark_dirty(update.symbol_id);
+            if (analytics) analytics->on_increment(update, book);
+            if (publisher) publisher->publish(book);
+            sequence.last_first_id = update.first_update_id;
+            sequence.last_update_id = update.last_update_id;
+            return true;
+        }
+        void FIXOrderBookManager::buffer_update(BookSequence& sequence, const pascal::common::MarketDataIncrement& update) {
+            if (sequence.pending.size() >= MAX_PENDING_UPDATES) {
+                //The oldest updates are the ones a snapshot will cover anyway. One that is a whole buffer
+                //overdue was probably lost, ask again
+                sequence.pending.pop_front();
+                if (++sequence.overflowed % MAX_PENDING_UPDATES == 0) {
+                    sequence.resync_requested = false;
+                    request_resync(update.symbol_id, sequence);
+                }
+            }
+            sequence.pending.push_back(update);
+        }
+        void FIXOrderBookManager::request_resync(pascal::common::SymbolId id, BookSequence& sequence) {
+            if (sequence.resync_requested) return;
+            sequence.resync_requested = true;
+            if (resyncHandler) resyncHandler(id);
+        }
+        std::shared_ptr<OrderBook> FIXOrderBookManager::get_book_by_symbol(const std::string& symbol) {
+            return get_book(pascal::common::SymbolRegistry::instance().find(symbol));
+        }
+        std::shared_ptr<OrderBook> FIXOrderBookManager::get_book(pascal::common::SymbolId id) {
+            pascal::common::EpochDomain::Guard guard(epochs);
+            const BookEntry* entry = entry_for(id);
+            return entry ? entry->book : nullptr;
         }
-        std::shared_ptr<FIXOrderBook> FIXOrderBookManager::get_book_by_symbol(const std::string& symbol) {
-            std::shared_lock<std::shared_mutex> lk(book_mtx);
-            return books[symbol];
-        }   
         std::vector<std::string> FIXOrderBookManager::get_symbols() const {
-            std::shared_lock<std::shared_mutex> lk(book_mtx);
-            std::vector<std::string> symbols(books.size());
-            std::transform(books.begin(), books.end(), symbols.begin(), [](auto a) {
-                return a.first;
-            });
+            pascal::common::EpochDomain::Guard guard(epochs);
+            const BookTable* current = table.load(std::memory_order_seq_cst);
+            std::vector<std::string> symbols;
+            symbols.reserve(current->totalBooks);
+            for (const auto& entry : current->entries) {
+                if (entry.book) symbols.push_back(entry.book->get_symbol());
+            }
             return symbols;
         }
         size_t FIXOrderBookManager::get_total_books() const {
-            std::shared_lock<std::shared_mutex> lk(book_mtx);
-            return books.size();
+            pascal::common::EpochDomain::Guard guard(epochs);
+            return table.load(std::memory_order_seq_cst)->totalBooks;
         }
         uint64_t FIXOrderBookManager::get_total_updates_processed() const {
             return total_updates_processed.load(std::memory_order_relaxed);
         }
+        uint64_t FIXOrderBookManager::get_total_sequence_gaps() const {
+            return total_sequence_gaps.load(std::memory_order_relaxed);
+        }
+        uint64_t FIXOrderBookManager::get_conflated_updates() const {
+            uint64_t total = 0;
+            for (size_t id = 0; id < pascal::common::SymbolRegistry::MAX_SYMBOLS; id++)
+                total += conflatedUpdates[id].load(std::memory_order_relaxed);
+            return total;
+        }
+        uint64_t FIXOrderBookManager::get_conflated_updates(pascal::common::SymbolId id) const {
+            return id < pascal::common::SymbolRegistry::MAX_SYMBOLS ? conflatedUpdates[id].load(std::memory_order_relaxed) : 0;
+        }
+        uint64_t FIXOrderBookManager::get_conflation_deliveries() const {
+            return conflation_deliveries.load(std::memory_order_relaxed);
+        }
     }   
 }
\ No newline at end of file
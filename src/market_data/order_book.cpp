@@ -0,0 +1,89 @@
+#include "market_data/order_book.h"
+
+namespace pascal {
+    namespace market_data {
+        pascal::common::PriceLevel OrderBook::get_best_bid() const {
+            return seqlock.read_consistent([this]() {
+                return best_bid_level();
+            });
+        }
+        pascal::common::PriceLevel OrderBook::get_best_ask() const {
+            return seqlock.read_consistent([this]() {
+                return best_ask_level();
+            });
+        }
+        void OrderBook::get_top_of_book(pascal::common::PriceLevel& bid, pascal::common::PriceLevel& ask) const {
+            auto top = seqlock.read_consistent([this]() {
+                return std::array<pascal::common::PriceLevel, 2>{best_bid_level(), best_ask_level()};
+            });
+            bid = top[0];
+            ask = top[1];
+        }
+        pascal::common::Lots OrderBook::get_bid_quantity_at_price(pascal::common::Ticks price) const {
+            return seqlock.read_consistent([this, price]() {
+                return bid_quantity_at(price);
+            });
+        }
+        pascal::common::Lots OrderBook::get_ask_quantity_at_price(pascal::common::Ticks price) const {
+            return seqlock.read_consistent([this, price]() {
+                return ask_quantity_at(price);
+            });
+        }
+        size_t OrderBook::get_bids(std::span<pascal::common::PriceLevel> out) const {
+            return seqlock.read_consistent([this, out]() {
+                return copy_bids(out.data(), out.size());
+            });
+        }
+        size_t OrderBook::get_asks(std::span<pascal::common::PriceLevel> out) const {
+            return seqlock.read_consistent([this, out]() {
+                return copy_asks(out.data(), out.size());
+            });
+        }
+        std::vector<pascal::common::PriceLevel> OrderBook::get_bids(size_t depth) const {
+            std::vector<pascal::common::PriceLevel> levels(depth);
+            levels.resize(get_bids(std::span<pascal::common::PriceLevel>(levels)));
+            return levels;
+        }
+        std::vector<pascal::common::PriceLevel> OrderBook::get_asks(size_t depth) const {
+            std::vector<pascal::common::PriceLevel> levels(depth);
+            levels.resize(get_asks(std::span<pascal::common::PriceLevel>(levels)));
+            return levels;
+        }
+        const pascal::common::InstrumentSpec& OrderBook::get_instrument_spec() const {
+            return spec;
+        }
+        const std::string& OrderBook::get_symbol() const {
+            return symbol;
+        }
+        pascal::common::SymbolId OrderBook::get_symbol_id() const {
+            return symbolId;
+        }
+        bool OrderBook::is_synchronized() const {
+            return is_synchronized_.load(std::memory_order_acquire);
+        }
+        void OrderBook::mark_unsynchronized() {
+            is_synchronized_.store(false, std::memory_order_release);
+        }
+        std::chrono::high_resolution_clock::time_point OrderBook::get_last_update_time() const {
+            return seqlock.read_consistent([this]() {
+                return last_update_time;
+            });
+        }
+        uint64_t OrderBook::get_version() const {
+            return seqlock.sequence();
+        }
+        size_t OrderBook::get_total_bid_levels() const {
+            return seqlock.read_consistent([this]() {
+                return bid_levels();
+            });
+        }
+        size_t OrderBook::get_total_ask_levels() const {
+            return seqlock.read_consistent([this]() {
+                return ask_levels();
+            });
+        }
+        uint64_t OrderBook::get_total_updates_processed() const {
+            return total_updates_processed.load(std::memory_order_relaxed);
+        }
+    }
+}
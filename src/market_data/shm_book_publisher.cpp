@@ -0,0 +1,100 @@
+#include "market_data/shm_book.h"
+#include "market_data/order_book.h"
+#include "common/tsc_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pascal {
+    namespace market_data {
+        namespace {
+            std::runtime_error shm_error(const std::string& what, const std::string& name) {
+                return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+            }
+        }
+
+        ShmBookPublisher::ShmBookPublisher(const std::string& name, size_t slot_count) : name(name), slotCount(slot_count) {
+            int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0) throw shm_error("Cannot create book region", name);
+            size_t size = sizeof(ShmBookHeader) + slotCount*sizeof(ShmBookSlot);
+            struct stat st;
+            if (::fstat(fd, &st) == 0 && st.st_size != 0 && static_cast<size_t>(st.st_size) != size) {
+                //Readers of the other layout would fault on a resize, it has to be unlinked first
+                ::close(fd);
+                throw std::runtime_error("Book region of another slot count exists " + name);
+            }
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                ::close(fd);
+                throw shm_error("Cannot size book region", name);
+            }
+            void* region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (region == MAP_FAILED) throw shm_error("Cannot map book region", name);
+            base = static_cast<char*>(region);
+            mapped = size;
+
+            //Clear the slots before stamping a new creation time, readers of a previous publisher then find
+            //nothing until their symbols are published again
+            ShmBookSlot* slots = reinterpret_cast<ShmBookSlot*>(base + sizeof(ShmBookHeader));
+            for (size_t i = 0; i < slotCount; i++) slots[i].sequence.reset();
+            ShmBookHeader* h = reinterpret_cast<ShmBookHeader*>(base);
+            std::memcpy(h->magic, ShmBookHeader::MAGIC, sizeof(h->magic));
+            h->version = ShmBookHeader::VERSION;
+            h->header_size = sizeof(ShmBookHeader);
+            h->slot_size = sizeof(ShmBookSlot);
+            h->slot_count = static_cast<uint32_t>(slotCount);
+            h->depth = SHM_BOOK_DEPTH;
+            std::atomic_thread_fence(std::memory_order_release);
+            std::atomic_ref<int64_t>(h->created_nanos).store(pascal::common::TscClock::now_nanos(), std::memory_order_release);
+        }
+        ShmBookPublisher::~ShmBookPublisher() {
+            if (base) ::munmap(base, mapped);
+        }
+        void ShmBookPublisher::publish(const OrderBook& book) {
+            pascal::common::SymbolId id = book.get_symbol_id();
+            if (id >= slotCount) return;
+            ShmBookSlot& slot = reinterpret_cast<ShmBookSlot*>(base + sizeof(ShmBookHeader))[id];
+
+            //Copy the levels out before opening the slot's write
+            pascal::common::PriceLevel bids[SHM_BOOK_DEPTH];
+            pascal::common::PriceLevel asks[SHM_BOOK_DEPTH];
+            size_t bidCount = book.get_bids(std::span<pascal::common::PriceLevel>(bids));
+            size_t askCount = book.get_asks(std::span<pascal::common::PriceLevel>(asks));
+
+            bool first = !slot.sequence.written();
+            slot.sequence.begin_write();
+            ShmBookData& data = slot.data;
+            if (first) {
+                const std::string& symbol = book.get_symbol();
+                std::memset(data.symbol, 0, sizeof(data.symbol));
+                std::memcpy(data.symbol, symbol.data(), std::min(symbol.size(), sizeof(data.symbol)-1));
+                data.spec = book.get_instrument_spec();
+            }
+            data.book_version = book.get_version();
+            data.publish_nanos = pascal::common::TscClock::now_nanos();
+            data.synchronized = book.is_synchronized();
+            data.bid_count = static_cast<uint32_t>(bidCount);
+            data.ask_count = static_cast<uint32_t>(askCount);
+            std::copy_n(bids, bidCount, data.bids);
+            std::copy_n(asks, askCount, data.asks);
+            slot.sequence.end_write();
+            publications.fetch_add(1, std::memory_order_relaxed);
+        }
+        uint64_t ShmBookPublisher::get_publications() const {
+            return publications.load(std::memory_order_relaxed);
+        }
+        const std::string& ShmBookPublisher::get_name() const {
+            return name;
+        }
+        void ShmBookPublisher::unlink(const std::string& name) {
+            ::shm_unlink(name.c_str());
+        }
+    }
+}
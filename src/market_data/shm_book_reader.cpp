@@ -0,0 +1,65 @@
+#include "market_data/shm_book.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pascal {
+    namespace market_data {
+        namespace {
+            std::runtime_error shm_error(const std::string& what, const std::string& name) {
+                return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+            }
+        }
+
+        ShmBookReader::ShmBookReader(const std::string& name) {
+            int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) throw shm_error("Cannot open book region", name);
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmBookHeader)) {
+                ::close(fd);
+                throw std::runtime_error("Not a book region " + name);
+            }
+            void* region = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (region == MAP_FAILED) throw shm_error("Cannot map book region", name);
+            base = static_cast<const char*>(region);
+            mapped = static_cast<size_t>(st.st_size);
+
+            const ShmBookHeader* h = reinterpret_cast<const ShmBookHeader*>(base);
+            bool valid = std::memcmp(h->magic, ShmBookHeader::MAGIC, sizeof(h->magic)) == 0 && h->version == ShmBookHeader::VERSION &&
+                h->slot_size == sizeof(ShmBookSlot) && h->depth == SHM_BOOK_DEPTH && sizeof(ShmBookHeader) + size_t(h->slot_count)*sizeof(ShmBookSlot) <= mapped;
+            if (!valid) {
+                ::munmap(const_cast<char*>(base), mapped);
+                throw std::runtime_error("Not a book region of this layout " + name);
+            }
+            slotCount = h->slot_count;
+            createdNanos = std::atomic_ref<const int64_t>(h->created_nanos).load(std::memory_order_acquire);
+        }
+        ShmBookReader::~ShmBookReader() {
+            if (base) ::munmap(const_cast<char*>(base), mapped);
+        }
+        size_t ShmBookReader::find(const std::string& symbol) const {
+            if (symbol.size() >= SHM_SYMBOL_LENGTH) return NOT_FOUND;
+            for (size_t slot = 0; slot < slotCount; slot++) {
+                bool match = false;
+                read_consistent(slot, [&symbol, &match](const ShmBookData& data) {
+                    match = std::strncmp(data.symbol, symbol.c_str(), SHM_SYMBOL_LENGTH) == 0;
+                });
+                if (match) return slot;
+            }
+            return NOT_FOUND;
+        }
+        size_t ShmBookReader::get_slot_count() const {
+            return slotCount;
+        }
+        bool ShmBookReader::is_current() const {
+            const ShmBookHeader* h = reinterpret_cast<const ShmBookHeader*>(base);
+            return std::atomic_ref<const int64_t>(h->created_nanos).load(std::memory_order_acquire) == createdNanos;
+        }
+    }
+}
@@ -0,0 +1,150 @@
+#include "market_data/trade_tape.h"
+#include "common/tsc_clock.h"
+#include <algorithm>
+#include <chrono>
+
+namespace pascal {
+    namespace market_data {
+        uint64_t TradeTape::push(const pascal::common::Trade& trade) {
+            uint64_t sequence = head.load(std::memory_order_relaxed)+1;
+            Slot& slot = slots[sequence & MASK];
+            slot.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.trade = trade;
+            slot.sequence.store(sequence, std::memory_order_release);
+            head.store(sequence, std::memory_order_release);
+            return sequence;
+        }
+        uint64_t TradeTape::get_last_sequence() const {
+            return head.load(std::memory_order_acquire);
+        }
+        size_t TradeTape::read_since(uint64_t after, std::span<pascal::common::Trade> out, uint64_t& last) const {
+            uint64_t newest = head.load(std::memory_order_acquire);
+            uint64_t oldest = newest > CAPACITY ? newest-CAPACITY+1 : 1;
+            uint64_t sequence = std::max(after+1, oldest);
+            last = std::max(after, sequence-1);
+            size_t copied = 0;
+            for (; sequence <= newest && copied < out.size(); sequence++) {
+                const Slot& slot = slots[sequence & MASK];
+                last = sequence;
+                if (slot.sequence.load(std::memory_order_acquire) != sequence) continue;
+                pascal::common::Trade trade = slot.trade;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+                out[copied++] = trade;
+            }
+            return copied;
+        }
+        size_t TradeTape::read_latest(std::span<pascal::common::Trade> out) const {
+            uint64_t newest = head.load(std::memory_order_acquire);
+            uint64_t last;
+            return read_since(newest > out.size() ? newest-out.size() : 0, out, last);
+        }
+
+        void TradeRecorder::Bucket::add(const Bucket& other) {
+            trades += other.trades;
+            volume += other.volume;
+            buy_volume += other.buy_volume;
+            sell_volume += other.sell_volume;
+            notional += other.notional;
+        }
+        void TradeRecorder::Bucket::remove(const Bucket& other) {
+            trades -= other.trades;
+            volume -= other.volume;
+            buy_volume -= other.buy_volume;
+            sell_volume -= other.sell_volume;
+            //Keeps rounding left over from removed buckets out of an empty window
+            notional = volume == 0 ? 0.0 : notional - other.notional;
+        }
+        pascal::common::SymbolId TradeRecorder::add_symbol(const std::string& symbol) {
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().register_symbol(symbol);
+            if (id == pascal::common::INVALID_SYMBOL_ID) return id;
+            if (!symbols[id]) symbols[id] = std::make_unique<SymbolTrades>();
+            return id;
+        }
+        void TradeRecorder::on_trade(const pascal::common::Trade& trade) {
+            if (trade.symbol_id >= symbols.size() || !symbols[trade.symbol_id]) {
+                dropped_trades.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            SymbolTrades& state = *symbols[trade.symbol_id];
+            uint64_t sequence = state.tape.push(trade);
+
+            Bucket added;
+            added.trades = 1;
+            added.volume = trade.priceLevel.Quantity;
+            if (trade.aggressor == pascal::common::AggressorSide::BUYER) added.buy_volume = trade.priceLevel.Quantity;
+            else if (trade.aggressor == pascal::common::AggressorSide::SELLER) added.sell_volume = trade.priceLevel.Quantity;
+            added.notional = static_cast<double>(trade.priceLevel.Price) * static_cast<double>(trade.priceLevel.Quantity);
+
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(trade.recv_time.time_since_epoch()).count();
+            pascal::common::SeqLock::WriteGuard write(state.seqlock);
+            state.last_sequence = sequence;
+            state.last_trade = trade;
+            for (size_t w = 0; w < TRADE_WINDOWS.size(); w++) {
+                Window& window = state.windows[w];
+                //Buckets that fell out of the window leave the sums as the head moves past them. A trade stamped
+                //before the head (out of order receive times) counts towards the head bucket
+                int64_t index = bucket_index(now, w);
+                if (index > window.head) {
+                    int64_t expired = std::min<int64_t>(index-window.head, WINDOW_BUCKETS);
+                    for (int64_t i = 1; i <= expired; i++) {
+                        Bucket& bucket = window.buckets[(window.head+i) % WINDOW_BUCKETS];
+                        window.sum.remove(bucket);
+                        bucket = Bucket{};
+                    }
+                    window.head = index;
+                }
+                window.buckets[window.head % WINDOW_BUCKETS].add(added);
+                window.sum.add(added);
+            }
+            total_trades.fetch_add(1, std::memory_order_relaxed);
+        }
+        const TradeTape* TradeRecorder::get_tape(pascal::common::SymbolId id) const {
+            return id < symbols.size() && symbols[id] ? &symbols[id]->tape : nullptr;
+        }
+        bool TradeRecorder::load_stats(pascal::common::SymbolId id, TradeStats& out) const {
+            return load_stats(id, out, pascal::common::TscClock::now());
+        }
+        bool TradeRecorder::load_stats(pascal::common::SymbolId id, TradeStats& out, std::chrono::high_resolution_clock::time_point now) const {
+            if (id >= symbols.size() || !symbols[id]) return false;
+            const SymbolTrades& state = *symbols[id];
+            if (!state.seqlock.written()) return false;
+            int64_t nowNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+            std::array<Bucket, TRADE_WINDOWS.size()> sums;
+            state.seqlock.read_consistent([&state, &out, &sums, nowNanos]() {
+                out.last_sequence = state.last_sequence;
+                out.last_trade = state.last_trade;
+                for (size_t w = 0; w < TRADE_WINDOWS.size(); w++) {
+                    //Same roll as the writer's, without clearing the buckets
+                    const Window& window = state.windows[w];
+                    sums[w] = window.sum;
+                    int64_t index = bucket_index(nowNanos, w);
+                    if (index <= window.head) continue;
+                    int64_t expired = std::min<int64_t>(index-window.head, WINDOW_BUCKETS);
+                    for (int64_t i = 1; i <= expired; i++) sums[w].remove(window.buckets[(window.head+i) % WINDOW_BUCKETS]);
+                }
+            });
+
+            for (size_t w = 0; w < TRADE_WINDOWS.size(); w++) {
+                const Bucket& sum = sums[w];
+                TradeWindowStats& stats = out.windows[w];
+                stats = TradeWindowStats{};
+                stats.trades = sum.trades;
+                stats.volume = sum.volume;
+                stats.buy_volume = sum.buy_volume;
+                stats.sell_volume = sum.sell_volume;
+                if (stats.volume > 0) stats.vwap = sum.notional / static_cast<double>(stats.volume);
+                pascal::common::Lots aggressed = stats.buy_volume + stats.sell_volume;
+                if (aggressed > 0) stats.imbalance = static_cast<double>(stats.buy_volume - stats.sell_volume) / static_cast<double>(aggressed);
+            }
+            return true;
+        }
+        uint64_t TradeRecorder::get_total_trades() const {
+            return total_trades.load(std::memory_order_relaxed);
+        }
+        uint64_t TradeRecorder::get_dropped_trades() const {
+            return dropped_trades.load(std::memory_order_relaxed);
+        }
+    }
+}
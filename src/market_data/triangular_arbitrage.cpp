@@ -0,0 +1,167 @@
+#include "market_data/triangular_arbitrage.h"
+#include "common/tsc_clock.h"
+#include <algorithm>
+
+namespace pascal {
+    namespace market_data {
+        TriangularArbitrageDetector::~TriangularArbitrageDetector() {
+            for (auto& slot : producers) delete slot.load(std::memory_order_acquire);
+        }
+        CycleId TriangularArbitrageDetector::add_cycle(const std::array<CycleLeg, CYCLE_LEGS>& legs, double min_edge) {
+            Cycle cycle;
+            cycle.min_edge = min_edge;
+            for (size_t i = 0; i < CYCLE_LEGS; i++) {
+                std::shared_ptr<OrderBook> book = manager->get_book_by_symbol(legs[i].symbol);
+                if (!book) return INVALID_CYCLE_ID;
+                pascal::common::SymbolId symbol = book->get_symbol_id();
+                cycle.legs[i] = Leg{.symbol = symbol, .side = legs[i].side, .fee_factor = 1.0 - legs[i].fee};
+                books[symbol] = std::move(book);
+            }
+            CycleId id = static_cast<CycleId>(cycles.size());
+            cycles.push_back(cycle);
+            cycleLegs.push_back(legs);
+            for (const Leg& leg : cycle.legs) {
+                auto& dependents = cyclesBySymbol[leg.symbol];
+                if (std::find(dependents.begin(), dependents.end(), id) == dependents.end()) dependents.push_back(id);
+                refresh_quote(leg.symbol);
+            }
+            return id;
+        }
+        const std::array<CycleLeg, CYCLE_LEGS>& TriangularArbitrageDetector::get_cycle(CycleId id) const {
+            return cycleLegs.at(id);
+        }
+        size_t TriangularArbitrageDetector::get_cycle_count() const {
+            return cycles.size();
+        }
+        size_t TriangularArbitrageDetector::on_book_changed(pascal::common::SymbolId id, std::chrono::high_resolution_clock::time_point recv_time) {
+            if (id >= pascal::common::SymbolRegistry::MAX_SYMBOLS || cyclesBySymbol[id].empty()) return 0;
+            if (!refresh_quote(id)) return 0;
+
+            const auto& dependents = cyclesBySymbol[id];
+            ArbitrageOpportunity opportunity;
+            Producer* producer = thread_producer();
+            if (!producer) {
+                //Nowhere to queue, count what this thread finds and drop it
+                overflow.bbo_changes.fetch_add(1, std::memory_order_relaxed);
+                for (CycleId cycle : dependents) {
+                    if (evaluate(cycle, id, recv_time, opportunity)) overflow.unqueued.fetch_add(1, std::memory_order_relaxed);
+                }
+                overflow.evaluations.fetch_add(dependents.size(), std::memory_order_relaxed);
+                return dependents.size();
+            }
+            producer->bbo_changes.store(producer->bbo_changes.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+            for (CycleId cycle : dependents) {
+                if (!evaluate(cycle, id, recv_time, opportunity)) continue;
+                producer->opportunities.store(producer->opportunities.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+                if (!producer->queue.push(opportunity)) producer->dropped.store(producer->dropped.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+            }
+            producer->evaluations.store(producer->evaluations.load(std::memory_order_relaxed)+dependents.size(), std::memory_order_relaxed);
+            return dependents.size();
+        }
+        bool TriangularArbitrageDetector::refresh_quote(pascal::common::SymbolId id) {
+            const OrderBook* book = books[id].get();
+            if (!book) return false;
+            Quote& quote = quotes[id];
+
+            pascal::common::PriceLevel bid, ask;
+            book->get_top_of_book(bid, ask);
+            bool synchronized = book->is_synchronized();
+            if (synchronized == quote.synchronized && bid.Price == quote.bid_level.Price && bid.Quantity == quote.bid_level.Quantity &&
+                ask.Price == quote.ask_level.Price && ask.Quantity == quote.ask_level.Quantity) return false;
+            quote.bid_level = bid;
+            quote.ask_level = ask;
+            quote.synchronized = synchronized;
+
+            const pascal::common::InstrumentSpec& spec = book->get_instrument_spec();
+            bool bidValid = synchronized && bid.Quantity > 0;
+            bool askValid = synchronized && ask.Quantity > 0;
+            pascal::common::SeqLock::WriteGuard write(quote.seqlock);
+            quote.bid = bidValid ? spec.to_price(bid.Price) : 0.0;
+            quote.bid_size = bidValid ? spec.to_quantity(bid.Quantity) : 0.0;
+            quote.ask = askValid ? spec.to_price(ask.Price) : 0.0;
+            quote.ask_size = askValid ? spec.to_quantity(ask.Quantity) : 0.0;
+            return true;
+        }
+        TriangularArbitrageDetector::QuoteValues TriangularArbitrageDetector::load_quote(pascal::common::SymbolId id) const {
+            const Quote& quote = quotes[id];
+            return quote.seqlock.read_consistent([&quote]() {
+                return QuoteValues{quote.bid, quote.bid_size, quote.ask, quote.ask_size};
+            });
+        }
+        bool TriangularArbitrageDetector::evaluate(CycleId id, pascal::common::SymbolId trigger, std::chrono::high_resolution_clock::time_point recv_time, ArbitrageOpportunity& opportunity) const {
+            const Cycle& cycle = cycles[id];
+            //rate converts one unit of the starting currency into the currency the next leg spends
+            double rate = 1.0;
+            double startQuantity = std::numeric_limits<double>::infinity();
+            for (size_t i = 0; i < CYCLE_LEGS; i++) {
+                const Leg& leg = cycle.legs[i];
+                QuoteValues quote = load_quote(leg.symbol);
+                double capacity; //what the touch absorbs, in the currency the leg spends
+                if (leg.side == LegSide::BUY) {
+                    if (quote.ask <= 0.0) return false;
+                    capacity = quote.ask * quote.ask_size;
+                    opportunity.prices[i] = quote.ask;
+                    startQuantity = std::min(startQuantity, capacity / rate);
+                    rate *= leg.fee_factor / quote.ask;
+                }
+                else {
+                    if (quote.bid <= 0.0) return false;
+                    capacity = quote.bid_size;
+                    opportunity.prices[i] = quote.bid;
+                    startQuantity = std::min(startQuantity, capacity / rate);
+                    rate *= quote.bid * leg.fee_factor;
+                }
+            }
+            double edge = rate - 1.0;
+            if (edge <= cycle.min_edge) return false;
+
+            opportunity.cycle = id;
+            opportunity.trigger = trigger;
+            opportunity.edge = edge;
+            opportunity.start_quantity = startQuantity;
+            opportunity.expected_profit = startQuantity * edge;
+            opportunity.recv_time = recv_time;
+            opportunity.detect_nanos = pascal::common::TscClock::now_nanos();
+            return true;
+        }
+        TriangularArbitrageDetector::Producer* TriangularArbitrageDetector::thread_producer() {
+            size_t index = pascal::common::thread_index();
+            if (index >= MAX_PRODUCERS) return nullptr;
+            //Only the thread holding the index installs its slot, the consumer picks it up with the acquire load in drain
+            Producer* producer = producers[index].load(std::memory_order_relaxed);
+            if (!producer) {
+                producer = new Producer();
+                producers[index].store(producer, std::memory_order_release);
+            }
+            return producer;
+        }
+        uint64_t TriangularArbitrageDetector::get_bbo_changes() const {
+            uint64_t changes = overflow.bbo_changes.load(std::memory_order_relaxed);
+            for (const auto& slot : producers) {
+                if (const Producer* producer = slot.load(std::memory_order_acquire)) changes += producer->bbo_changes.load(std::memory_order_relaxed);
+            }
+            return changes;
+        }
+        uint64_t TriangularArbitrageDetector::get_evaluations() const {
+            uint64_t evaluations = overflow.evaluations.load(std::memory_order_relaxed);
+            for (const auto& slot : producers) {
+                if (const Producer* producer = slot.load(std::memory_order_acquire)) evaluations += producer->evaluations.load(std::memory_order_relaxed);
+            }
+            return evaluations;
+        }
+        uint64_t TriangularArbitrageDetector::get_opportunities() const {
+            uint64_t opportunities = overflow.unqueued.load(std::memory_order_relaxed);
+            for (const auto& slot : producers) {
+                if (const Producer* producer = slot.load(std::memory_order_acquire)) opportunities += producer->opportunities.load(std::memory_order_relaxed);
+            }
+            return opportunities;
+        }
+        uint64_t TriangularArbitrageDetector::get_dropped_opportunities() const {
+            uint64_t dropped = overflow.unqueued.load(std::memory_order_relaxed);
+            for (const auto& slot : producers) {
+                if (const Producer* producer = slot.load(std::memory_order_acquire)) dropped += producer->dropped.load(std::memory_order_relaxed);
+            }
+            return dropped;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include "net/engine_config.h"
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace pascal {
+    namespace net {
+        namespace {
+            //Whole value as a non-negative integer, surrounding blanks allowed
+            bool parse_count(const std::string& text, uint64_t& value) {
+                size_t first = text.find_first_not_of(" \t");
+                if (first == std::string::npos) return false;
+                size_t last = text.find_last_not_of(" \t")+1;
+                auto [end, error] = std::from_chars(text.data()+first, text.data()+last, value);
+                return error == std::errc() && end == text.data()+last;
+            }
+        }
+        std::vector<int> parse_worker_cores(const std::string& list) {
+            std::vector<int> cores;
+            std::stringstream entries(list);
+            std::string entry;
+            while (std::getline(entries, entry, ',')) {
+                if (entry.find_first_not_of(" \t") == std::string::npos) continue;
+                uint64_t core;
+                if (!parse_count(entry, core) || core > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+                    throw std::invalid_argument("WorkerCores entry is not a core number: " + entry);
+                }
+                cores.push_back(static_cast<int>(core));
+            }
+            return cores;
+        }
+        std::vector<int> default_worker_cores(size_t symbolCount, unsigned available) {
+            if (available <= 1) return {0};
+            std::vector<int> cores;
+            for (int core = 1; core < static_cast<int>(available) && cores.size() < symbolCount; core++) cores.push_back(core);
+            if (cores.empty()) cores.push_back(1);
+            return cores;
+        }
+        pascal::common::WaitStrategyConfig load_wait_config(const SettingLookup& lookup, const std::string& symbol) {
+            auto setting = [&lookup, &symbol](const std::string& key, std::string& value) {
+                return lookup(key + "." + symbol, value) || lookup(key, value);
+            };
+
+            pascal::common::WaitStrategyConfig config;
+            std::string value;
+            uint64_t count;
+            if (setting("WaitStrategy", value) && !pascal::common::parse_wait_strategy(value, config.type)) {
+                throw std::invalid_argument("Unknown WaitStrategy " + value + " for " + symbol);
+            }
+            if (setting("WaitSpinCount", value)) {
+                if (!parse_count(value, count) || count > std::numeric_limits<uint32_t>::max()) throw std::invalid_argument("Bad WaitSpinCount " + value + " for " + symbol);
+                config.spin_count = static_cast<uint32_t>(count);
+            }
+            if (setting("WaitParkTimeoutUs", value)) {
+                if (!parse_count(value, count)) throw std::invalid_argument("Bad WaitParkTimeoutUs " + value + " for " + symbol);
+                config.park_timeout = std::chrono::microseconds(count);
+            }
+            return config;
+        }
+        pascal::common::WaitStrategyConfig merge_wait_configs(const pascal::common::WaitStrategyConfig& a, const pascal::common::WaitStrategyConfig& b) {
+            pascal::common::WaitStrategyConfig config;
+            config.type = std::min(a.type, b.type);
+            config.spin_count = std::max(a.spin_count, b.spin_count);
+            config.park_timeout = std::min(a.park_timeout, b.park_timeout);
+            return config;
+        }
+        std::vector<WorkerPlan> plan_workers(const std::vector<int>& cores, const std::vector<pascal::common::SymbolId>& symbols,
+            const std::vector<pascal::common::WaitStrategyConfig>& waitConfigs) {
+            if (cores.empty() && !symbols.empty()) throw std::invalid_argument("At least one worker core is required");
+            std::vector<WorkerPlan> plans;
+            size_t workerCount = std::min(cores.size(), symbols.size());
+            for (size_t w = 0; w < workerCount; w++) {
+                plans.push_back({cores[w], {}, {}});
+            }
+            //A worker idles the way its most latency sensitive symbol asks for
+            for (size_t i = 0; i < symbols.size(); i++) {
+                WorkerPlan& plan = plans[i % workerCount];
+                const pascal::common::WaitStrategyConfig& symbolConfig = waitConfigs.at(symbols[i]);
+                plan.wait = plan.symbols.empty() ? symbolConfig : merge_wait_configs(plan.wait, symbolConfig);
+                plan.symbols.push_back(symbols[i]);
+            }
+            return plans;
+        }
+    }
+}
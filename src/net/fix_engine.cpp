@@ -3,27 +3,32 @@
 #include <chrono>
 #include <thread>
 #include "net/ed25519_signer.h"
+#include "net/engine_config.h"
 #include "common/types.h"
 #include <stdexcept>
+#include <algorithm>
 
 namespace pascal {
     namespace net {
-        bool FIXMarketDataEngine::start() {
+        bool FIXMarketDataEngineBase::start() {
             try {
-                initiator_->start();
+                //Workers own the queues before the first message can arrive
                 is_running.store(true, std::memory_order_release);
                 start_symbol_processing();
+                initiator_->start();
                 return true;
             }
             catch (std::exception& e) {
                 std::cerr << "Failed to start QuickFIX initiator" << e.what() << std::endl;
+                stop_symbol_processing();
                 return false;
             }
         }
-        bool FIXMarketDataEngine::stop() {
+        bool FIXMarketDataEngineBase::stop() {
             try {
                 stop_symbol_processing();
                 initiator_->stop();
+                if (captureJournal) captureJournal->flush();
                 return true;
             }
             catch (std::exception& e) {
@@ -31,17 +36,49 @@ namespace pascal {
                 return false;
             }
         }
-        bool FIXMarketDataEngine::is_logged() const {
+        bool FIXMarketDataEngineBase::is_logged() const {
             return is_logged_on.load(std::memory_order_acquire);
         }
-        void FIXMarketDataEngine::onLogon(const FIX::SessionID& sessionID) {
+        uint64_t FIXMarketDataEngineBase::get_dropped_messages() const {
+            return dropped_messages.load(std::memory_order_relaxed);
+        }
+        pascal::common::LatencySnapshot FIXMarketDataEngineBase::get_latency(const std::string& symbol, pascal::common::LatencyStage stage) const {
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().find(symbol);
+            if (id >= symbolLatency.size() || !symbolLatency[id]) return {};
+            FIX::Locker lock(latency_mtx);
+            return symbolLatency[id]->interval(stage);
+        }
+        void FIXMarketDataEngineBase::reset_latency_interval() {
+            FIX::Locker lock(latency_mtx);
+            for (pascal::common::SymbolId id : tradedSymbolIds) {
+                symbolLatency[id]->reset_interval();
+            }
+        }
+        void FIXMarketDataEngineBase::set_capture_journal(const std::string& path) {
+            captureJournal.reset();
+            if (!path.empty()) captureJournal = std::make_unique<MessageJournalWriter>(path);
+        }
+        void FIXMarketDataEngineBase::set_venue(pascal::common::VenueId id) {
+            if (id >= pascal::common::MAX_VENUES) throw std::invalid_argument("Venue must be below MAX_VENUES");
+            venue = id;
+            if (parserBase) parserBase->set_venue(id);
+        }
+        pascal::common::VenueId FIXMarketDataEngineBase::get_venue() const {
+            return venue;
+        }
+        void FIXMarketDataEngineBase::set_instrument_spec(const std::string& symbol, const pascal::common::InstrumentSpec& spec) {
+            if (parserBase) parserBase->set_instrument_spec(symbol, spec);
+        }
+        void FIXMarketDataEngineBase::onLogon(const FIX::SessionID& sessionID) {
+            FIX::Locker lock(subscription_mtx);
             this->sessionID = sessionID;
             is_logged_on.store(true, std::memory_order_release);
         }
-        void FIXMarketDataEngine::onLogout(const FIX::SessionID& sessionID) {
+        void FIXMarketDataEngineBase::onLogout(const FIX::SessionID& sessionID) {
+            FIX::Locker lock(subscription_mtx);
             is_logged_on.store(false, std::memory_order_release);
         }
-        void FIXMarketDataEngine::toAdmin(FIX::Message& message, const FIX::SessionID& sessionID) {
+        void FIXMarketDataEngineBase::toAdmin(FIX::Message& message, const FIX::SessionID& sessionID) {
             FIX::MsgType msgType;
             message.getHeader().getField(msgType);
             std::cout << "Sending to admin: " << msgType.getValue() << std::endl;
@@ -53,7 +90,7 @@ namespace pascal {
                 std::cout << message.toString() << std::endl;
             }
         }
-        void FIXMarketDataEngine::fromAdmin(const FIX::Message& message, const FIX::SessionID& sessionID) {
+        void FIXMarketDataEngineBase::fromAdmin(const FIX::Message& message, const FIX::SessionID& sessionID) {
             FIX::MsgType msgType;
             message.getHeader().getField(msgType);
             std::cout << "HI" << std::endl;
@@ -63,7 +100,7 @@ namespace pascal {
                 std::cerr << "Text is: " << text.getString() << std::endl;  
             }
         }
-        void FIXMarketDataEngine::sign_logon_message(FIX::Message& message) {
+        void FIXMarketDataEngineBase::sign_logon_message(FIX::Message& message) {
             std::string payload = create_logon_payload(message);
             std::cout << "Payload is: " << payload << std::endl;
             std::string signature = signer_->sign_payload(payload);
@@ -72,7 +109,7 @@ namespace pascal {
             message.setField(FIX::RawDataLength(signature.length()));
             message.setField(FIX::RawData(signature));
         }
-        std::string FIXMarketDataEngine::create_logon_payload(const FIX::Message& message) {
+        std::string FIXMarketDataEngineBase::create_logon_payload(const FIX::Message& message) {
             FIX::MsgType msgType;
             FIX::SenderCompID senderCompId;
             FIX::TargetCompID targetCompId;
@@ -87,20 +124,43 @@ namespace pascal {
             const char SOH = '\x01';
             return msgType.getString()+SOH+senderCompId.getString()+SOH+targetCompId.getString()+SOH+std::to_string(msgSeqNum.getValue())+SOH+sendingTime.getString();
         }
-        void FIXMarketDataEngine::fromApp(const FIX::Message& message, const FIX::SessionID& sessionID) {
-            FIX::Symbol symbol; 
-            if (!message.isSetField(symbol)) return;
-            
-            message.getField(symbol); 
-            auto recv_time = std::chrono::high_resolution_clock::now();
-            symbolQueues[symbol].push(message, recv_time);
+        void FIXMarketDataEngineBase::fromApp(const FIX::Message& message, const FIX::SessionID& sessionID) {
+            auto recv_time = pascal::common::TscClock::now();
+            if (!message.isSetField(FIX::FIELD::Symbol)) return;
+
+            //Resolved in place, no Symbol field copy or string hash map on the way in
+            const std::string& symbol = message.getFieldRef(FIX::FIELD::Symbol).getString();
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().find(symbol);
+            if (id >= symbolQueues.size() || !symbolQueues[id]) return;
+
+            //Serialize into a buffer that keeps its capacity across calls and copy the bytes into the ring,
+            //the worker decodes them with the raw parser instead of receiving a cloned field map
+            thread_local std::string wire;
+            message.toString(wire);
+            int64_t received = std::chrono::duration_cast<std::chrono::nanoseconds>(recv_time.time_since_epoch()).count();
+            if (captureJournal) captureJournal->append(wire.data(), wire.size(), received);
+
+            //A resync ends with the snapshot it asked for
+            if (resyncPending[id].load(std::memory_order_relaxed) && message.getHeader().getFieldRef(FIX::FIELD::MsgType).getString() == FIX::MsgType_MarketDataSnapshotFullRefresh) {
+                resyncPending[id].store(false, std::memory_order_relaxed);
+            }
+            //The receive hop rides along in the record so the worker can place the enqueue point
+            int64_t receive_nanos = std::clamp<int64_t>(pascal::common::latency_clock_now() - received, 0, UINT32_MAX);
+            if (!symbolQueues[id]->push(wire.data(), wire.size(), recv_time.time_since_epoch().count(), static_cast<uint32_t>(receive_nanos))) {
+                //The book downstream has lost an update, rebuild it from a fresh snapshot
+                dropped_messages.fetch_add(1, std::memory_order_relaxed);
+                request_snapshot(id);
+                return;
+            }
+            if (symbolWorkers[id]) symbolWorkers[id]->wait.notify();
+            symbolLatency[id]->record(pascal::common::LatencyStage::RECEIVE, receive_nanos);
         }
-        std::string FIXMarketDataEngine::generate_request_id() {
+        std::string FIXMarketDataEngineBase::generate_request_id() {
             int req_id = next_req_id.fetch_add(1, std::memory_order_relaxed);
             return std::to_string(req_id);
 
         }
-        std::string FIXMarketDataEngine::send_market_data_request(const pascal::common::MarketDataRequest& request) {
+        std::string FIXMarketDataEngineBase::send_market_data_request(const pascal::common::MarketDataRequest& request) {
             FIX44::MarketDataRequest req;
             FIX::Header& header = req.getHeader();
             header.setField(FIX::BeginString("FIX.4.4"));
@@ -138,56 +198,117 @@ namespace pascal {
             FIX::Session::sendToTarget(req, sessionID);
             return req_id;
         }
-        void FIXMarketDataEngine::sub_to_symbol(pascal::common::MarketDataRequest& request) {
+        void FIXMarketDataEngineBase::sub_to_symbol(pascal::common::MarketDataRequest& request) {
             FIX::Locker lock(subscription_mtx);
             request.Subscribe = '1';
-            std::string req_id = send_market_data_request(request);
-            active_subscriptions[request.Symbol] = req_id;
+            request.ReqID = send_market_data_request(request);
+            active_subscriptions[request.Symbol] = request;
         }
-        void FIXMarketDataEngine::unsub_to_symbol(const std::string& symbol) {
+        void FIXMarketDataEngineBase::unsub_to_symbol(const std::string& symbol) {
             FIX::Locker lock(subscription_mtx);
             auto it = active_subscriptions.find(symbol);
             if (it == active_subscriptions.end()) return;
             
-            std::string req_id = it->second;
             pascal::common::MarketDataRequest request;
-            request.ReqID = req_id;
+            request.ReqID = it->second.ReqID;
             request.Subscribe = '2';
             request.Symbol = symbol;
             send_market_data_request(request);
             active_subscriptions.erase(it);
         }
-        void FIXMarketDataEngine::process_market_data(const std::string& symbol) {
-            QueuedFIXMessage message;
-            MessageQueue& msgQueue = symbolQueues[symbol];
-            while (is_running.load(std::memory_order_acquire)) {
-                if (msgQueue.pop(message)) {
-                    parser->parse_message(message.message, message.recv_time);
-                }
-                else {
-                    std::this_thread::sleep_for(std::chrono::nanoseconds(100)); //sleep for 100ns
-                }
-            }
-        }
-        void FIXMarketDataEngine::start_symbol_processing() {
-            int core_id = 1;
-            for (const auto& symbol : tradedSymbols) {
-                symbolsThreads[symbol] = std::thread([this, symbol]() {
-                    process_market_data(symbol);
-                });
+        bool FIXMarketDataEngineBase::request_snapshot(const std::string& symbol) {
+            return request_snapshot(pascal::common::SymbolRegistry::instance().find(symbol));
+        }
+        bool FIXMarketDataEngineBase::request_snapshot(pascal::common::SymbolId id) {
+            if (id >= pascal::common::SymbolRegistry::MAX_SYMBOLS || !is_logged()) return false;
+            if (resyncPending[id].exchange(true, std::memory_order_relaxed)) return false;
 
-                bind_thread_to_core(symbolsThreads[symbol], core_id++);
+            //The venue snapshots on subscribe, so drop the live subscription and take it again
+            FIX::Locker lock(subscription_mtx);
+            auto it = active_subscriptions.find(pascal::common::SymbolRegistry::instance().name(id));
+            if (it == active_subscriptions.end()) {
+                resyncPending[id].store(false, std::memory_order_relaxed);
+                return false;
+            }
+            pascal::common::MarketDataRequest request = it->second;
+            try {
+                request.Subscribe = '2';
+                send_market_data_request(request);
+                request.Subscribe = '1';
+                it->second.ReqID = send_market_data_request(request);
+                return true;
+            }
+            catch (FIX::SessionNotFound&) {
+                //Logged out underneath us, the next logon starts from a snapshot anyway
+                resyncPending[id].store(false, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        void FIXMarketDataEngineBase::start_symbol_processing() {
+            workers.clear();
+            std::fill(symbolWorkers.begin(), symbolWorkers.end(), nullptr);
+            for (WorkerPlan& plan : plan_workers(workerCores, tradedSymbolIds, symbolWaitConfigs)) {
+                workers.push_back(std::make_unique<Worker>(plan.core_id, plan.wait));
+                workers.back()->symbols = std::move(plan.symbols);
+                for (pascal::common::SymbolId id : workers.back()->symbols) symbolWorkers[id] = workers.back().get();
+            }
+            for (auto& worker : workers) {
+                Worker* w = worker.get();
+                w->thread = std::thread([this, w]() {
+                    process_market_data(*w);
+                });
+                bind_thread_to_core(w->thread, w->core_id);
             }
         }
-        void FIXMarketDataEngine::stop_symbol_processing() {
+        void FIXMarketDataEngineBase::stop_symbol_processing() {
             is_running.store(false, std::memory_order_release);
-            for (const auto& symbol : tradedSymbols) {
-                symbolsThreads[symbol].join();
+            //Workers stay allocated until the next start so a late fromApp can still notify them
+            for (auto& worker : workers) {
+                worker->wait.notify(); //unpark so the thread sees the stop
             }
-            symbolQueues.clear();
-            symbolsThreads.clear();
+            for (auto& worker : workers) {
+                if (worker->thread.joinable()) worker->thread.join();
+            }
+        }
+        void FIXMarketDataEngineBase::set_wait_strategy(const pascal::common::WaitStrategyConfig& config) {
+            for (pascal::common::SymbolId id : tradedSymbolIds) {
+                symbolWaitConfigs[id] = config;
+            }
+        }
+        void FIXMarketDataEngineBase::set_wait_strategy(const std::string& symbol, const pascal::common::WaitStrategyConfig& config) {
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().find(symbol);
+            if (id >= symbolQueues.size() || !symbolQueues[id]) throw std::invalid_argument("Not a traded symbol: " + symbol);
+            symbolWaitConfigs[id] = config;
+        }
+        pascal::common::WaitStats FIXMarketDataEngineBase::get_wait_stats(const std::string& symbol) const {
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().find(symbol);
+            if (id >= symbolWorkers.size() || !symbolWorkers[id]) return {};
+            return symbolWorkers[id]->wait.get_stats();
+        }
+        void FIXMarketDataEngineBase::set_worker_cores(const std::vector<int>& cores) {
+            if (cores.empty()) throw std::invalid_argument("At least one worker core is required");
+            workerCores = cores;
+        }
+        size_t FIXMarketDataEngineBase::get_worker_count() const {
+            return workers.size();
+        }
+        std::vector<int> FIXMarketDataEngineBase::load_worker_cores() const {
+            //WorkerCores=2,3,5 in [DEFAULT], one worker pinned on each listed core
+            std::string list;
+            std::vector<int> cores;
+            if (setting_lookup()("WorkerCores", list)) cores = parse_worker_cores(list);
+            if (!cores.empty()) return cores;
+            return default_worker_cores(tradedSymbolIds.size(), std::thread::hardware_concurrency());
+        }
+        SettingLookup FIXMarketDataEngineBase::setting_lookup() const {
+            const FIX::Dictionary& defaults = settings_->get();
+            return [&defaults](const std::string& key, std::string& value) {
+                if (!defaults.has(key)) return false;
+                value = defaults.getString(key);
+                return true;
+            };
         }
-        void FIXMarketDataEngine::bind_thread_to_core(std::thread& thread, int core_id) {
+        void FIXMarketDataEngineBase::bind_thread_to_core(std::thread& thread, int core_id) {
             #ifdef __linux__
 
             cpu_set_t cpuset;
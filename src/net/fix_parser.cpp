@@ -1,32 +1,122 @@
 #include "net/fix_parser.h"
+#include "common/latency_histogram.h"
 #include "quickfix/fix44/MarketDataSnapshotFullRefresh.h"
 #include <algorithm>
 
 namespace pascal {
     namespace market_data {
-        uint64_t FIXMarketDataParser::get_messages_processed() const {
-            return messaged_processed.load(std::memory_order_acquire);
+        namespace {
+            //Decimal fields are read from their wire string so no double rounding happens on the way in
+            inline int64_t wire_value(const FIX::FieldBase& field) {
+                const std::string& value = field.getString();
+                return pascal::common::parse_wire_decimal(value.data(), value.data()+value.size());
+            }
+            //Integer fields outside the FIX44 dictionary (book update ids, TradeID), 0 when absent
+            inline uint64_t uint_field(const FIX::FieldMap& fields, int tag) {
+                if (!fields.isSetField(tag)) return 0;
+                const std::string& value = fields.getField(tag);
+                return raw::parse_uint(value.data(), value.data()+value.size());
+            }
+        }
+        uint64_t FIXMarketDataParserBase::get_messages_processed() const {
+            uint64_t processed = 0;
+            for (size_t i = 0; i <= MAX_STAT_SHARDS; i++) processed += statShards[i].messages_processed.load(std::memory_order_relaxed);
+            return processed;
         }
-        double FIXMarketDataParser::get_average_processing_time() const {
-            auto processed = messaged_processed.load(std::memory_order_acquire);
+        double FIXMarketDataParserBase::get_average_processing_time() const {
+            uint64_t processed = 0, nanos = 0;
+            for (size_t i = 0; i <= MAX_STAT_SHARDS; i++) {
+                processed += statShards[i].messages_processed.load(std::memory_order_relaxed);
+                nanos += statShards[i].nanos_processing.load(std::memory_order_relaxed);
+            }
             if (processed == 0) return 0.0;
-            return time_spent_processing.load(std::memory_order_acquire) / processed;
-        }
-        void FIXMarketDataParser::parse_message(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time) {
-            FIX::MsgType type;
-            message.getHeader().getField(type);
-            if (type == FIX::MsgType_MarketDataSnapshotFullRefresh) {
-                pascal::common::MarketDataSnapshot snapshot = parse_snapshot(message, recv_time);
-                snapshotClbk(snapshot);
+            return static_cast<double>(nanos) / 1000.0 / static_cast<double>(processed);
+        }
+        pascal::common::MarketDataSnapshot& FIXMarketDataParserBase::thread_snapshot() {
+            thread_local pascal::common::MarketDataSnapshot snapshot;
+            return snapshot;
+        }
+        pascal::common::MarketDataIncrement& FIXMarketDataParserBase::thread_increment() {
+            thread_local pascal::common::MarketDataIncrement update;
+            return update;
+        }
+        pascal::common::MarketDataSnapshot* FIXMarketDataParserBase::decode_snapshot(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time) {
+            pascal::common::MarketDataSnapshot& snapshot = thread_snapshot();
+            if (!parse_snapshot(message, recv_time, snapshot)) return nullptr;
+            snapshot.venue = venue;
+            return &snapshot;
+        }
+        pascal::common::MarketDataIncrement* FIXMarketDataParserBase::decode_increment(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time) {
+            pascal::common::MarketDataIncrement& update = thread_increment();
+            if (!parse_increment(message, recv_time, update)) return nullptr;
+            update.venue = venue;
+            for (auto& trade : update.trades) trade.venue = venue;
+            return &update;
+        }
+        pascal::common::MarketDataSnapshot* FIXMarketDataParserBase::decode_raw_snapshot(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time) {
+            pascal::common::MarketDataSnapshot& snapshot = thread_snapshot();
+            if (!FIXRawDecoder::decode_snapshot(data, len, recv_time, snapshot)) return nullptr;
+            snapshot.venue = venue;
+            const pascal::common::InstrumentSpec& spec = instrument_spec(snapshot.symbol_id);
+            if (!spec.is_identity()) {
+                for (auto& level : snapshot.bids) rescale(spec, level);
+                for (auto& level : snapshot.asks) rescale(spec, level);
             }
-            else if (type == FIX::MsgType_MarketDataIncrementalRefresh) {
-                pascal::common::MarketDataIncrement update = parse_increment(message, recv_time);
-                incrementalClbk(update);
+            record_processing_time(recv_time);
+            return &snapshot;
+        }
+        pascal::common::MarketDataIncrement* FIXMarketDataParserBase::decode_raw_increment(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time) {
+            pascal::common::MarketDataIncrement& update = thread_increment();
+            if (!FIXRawDecoder::decode_increment(data, len, recv_time, update)) return nullptr;
+            update.venue = venue;
+            for (auto& trade : update.trades) trade.venue = venue;
+            const pascal::common::InstrumentSpec& spec = instrument_spec(update.symbol_id);
+            if (!spec.is_identity()) {
+                for (auto& md : update.md_entries) rescale(spec, md.priceLevel);
+                for (auto& trade : update.trades) rescale(spec, trade.priceLevel);
+            }
+            record_processing_time(recv_time);
+            return &update;
+        }
+        void FIXMarketDataParserBase::set_instrument_spec(const std::string& symbol, const pascal::common::InstrumentSpec& spec) {
+            pascal::common::SymbolId id = pascal::common::SymbolRegistry::instance().register_symbol(symbol);
+            if (id == pascal::common::INVALID_SYMBOL_ID) return;
+            instrumentSpecs[id] = spec;
+        }
+        void FIXMarketDataParserBase::set_venue(pascal::common::VenueId id) {
+            venue = id;
+        }
+        const pascal::common::InstrumentSpec& FIXMarketDataParserBase::instrument_spec(pascal::common::SymbolId id) const {
+            static const pascal::common::InstrumentSpec defaultSpec;
+            return id < instrumentSpecs.size() ? instrumentSpecs[id] : defaultSpec;
+        }
+        void FIXMarketDataParserBase::rescale(const pascal::common::InstrumentSpec& spec, pascal::common::PriceLevel& level) {
+            level.Price = spec.ticks_from_wire(level.Price);
+            level.Quantity = spec.lots_from_wire(level.Quantity);
+        }
+        void FIXMarketDataParserBase::record_processing_time(std::chrono::high_resolution_clock::time_point recv_time) {
+            int64_t now = pascal::common::latency_clock_now();
+            int64_t received = std::chrono::duration_cast<std::chrono::nanoseconds>(recv_time.time_since_epoch()).count();
+            pascal::common::thread_stage_marks().parsed = now;
+
+            uint64_t nanos = now > received ? static_cast<uint64_t>(now-received) : 0;
+            size_t index = pascal::common::thread_index();
+            if (index < MAX_STAT_SHARDS) {
+                //Only the thread holding the index writes its shard
+                StatShard& shard = statShards[index];
+                shard.messages_processed.store(shard.messages_processed.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+                shard.nanos_processing.store(shard.nanos_processing.load(std::memory_order_relaxed)+nanos, std::memory_order_relaxed);
+                return;
             }
+            StatShard& shared = statShards[MAX_STAT_SHARDS];
+            shared.messages_processed.fetch_add(1, std::memory_order_relaxed);
+            shared.nanos_processing.fetch_add(nanos, std::memory_order_relaxed);
         }
-        pascal::common::MarketDataSnapshot FIXMarketDataParser::parse_snapshot(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time) {
-            FIX::Symbol symbol;
-            message.getField(symbol);
+        bool FIXMarketDataParserBase::parse_snapshot(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time, pascal::common::MarketDataSnapshot& snapshot) {
+            const std::string& symbol = message.getFieldRef(FIX::FIELD::Symbol).getString();
+            //Symbols are registered at subscription time, the message path only looks them up
+            snapshot.symbol_id = pascal::common::SymbolRegistry::instance().find(symbol);
+            if (snapshot.symbol_id == pascal::common::INVALID_SYMBOL_ID) return false;
             FIX::NoMDEntries numEntries;
             message.getField(numEntries);
             FIX44::MarketDataSnapshotFullRefresh::NoMDEntries group;
@@ -34,8 +124,9 @@ namespace pascal {
             FIX::MDEntryPx MDEntryPx;
             FIX::MDEntrySize MDEntrySize;
 
-            pascal::common::MarketDataSnapshot snapshot;
-            snapshot.symbol = std::move(symbol.getString());
+            snapshot.bids.clear();
+            snapshot.asks.clear();
+            const pascal::common::InstrumentSpec& spec = instrument_spec(snapshot.symbol_id);
             snapshot.bids.reserve(numEntries.getValue());
             snapshot.asks.reserve(numEntries.getValue());
             for (int i = 1; i <= numEntries; i++) {
@@ -43,8 +134,8 @@ namespace pascal {
                 group.get(MDEntryType);
                 group.get(MDEntryPx);
                 group.get(MDEntrySize);
-                double price = MDEntryPx.getValue();
-                double qty = MDEntrySize.getValue();
+                pascal::common::Ticks price = spec.ticks_from_wire(wire_value(MDEntryPx));
+                pascal::common::Lots qty = spec.lots_from_wire(wire_value(MDEntrySize));
                 char entry_type = MDEntryType.getValue();
                 pascal::common::Side side;
                 if (entry_type == '0') side = pascal::common::Side::BID;
@@ -55,16 +146,15 @@ namespace pascal {
             }
 
             snapshot.recv_time = recv_time;
+            snapshot.last_update_id = uint_field(message, raw::LAST_BOOK_UPDATE_ID);
 
-            auto end_time = std::chrono::high_resolution_clock::now();
-            uint64_t processing_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time-recv_time).count();
-            messaged_processed.fetch_add(1, std::memory_order_release);
-            time_spent_processing.fetch_add(processing_time, std::memory_order_release);
-            return snapshot;
+            record_processing_time(recv_time);
+            return true;
         }
-        pascal::common::MarketDataIncrement FIXMarketDataParser::parse_increment(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time) {
-            FIX::Symbol symbol;
-            message.getField(symbol);
+        bool FIXMarketDataParserBase::parse_increment(const FIX::Message& message, std::chrono::high_resolution_clock::time_point recv_time, pascal::common::MarketDataIncrement& update) {
+            const std::string& symbol = message.getFieldRef(FIX::FIELD::Symbol).getString();
+            update.symbol_id = pascal::common::SymbolRegistry::instance().find(symbol);
+            if (update.symbol_id == pascal::common::INVALID_SYMBOL_ID) return false;
             FIX::MDUpdateAction action;
             message.getField(action);
             FIX::NoMDEntries numEntries;
@@ -74,33 +164,43 @@ namespace pascal {
             FIX::MDEntryPx MDEntryPx;
             FIX::MDEntrySize MDEntrySize;
 
-            pascal::common::MarketDataIncrement update;
-            update.symbol = std::move(symbol.getString());
+            update.md_entries.clear();
+            update.trades.clear();
+            const pascal::common::InstrumentSpec& spec = instrument_spec(update.symbol_id);
             update.recv_time = recv_time;
             update.marketDepth = static_cast<uint32_t>(numEntries.getValue());
             update.md_entries.reserve(update.marketDepth);
+            update.first_update_id = uint_field(message, raw::FIRST_BOOK_UPDATE_ID);
+            update.last_update_id = uint_field(message, raw::LAST_BOOK_UPDATE_ID);
             for (int i = 1; i <= numEntries; i++) {
                 message.getGroup(i, group);
                 group.get(MDEntryType);
                 group.get(MDEntryPx);
                 group.get(MDEntrySize);
-                double price = MDEntryPx.getValue();
-                double qty = MDEntrySize.getValue();
+                pascal::common::Ticks price = spec.ticks_from_wire(wire_value(MDEntryPx));
+                pascal::common::Lots qty = spec.lots_from_wire(wire_value(MDEntrySize));
                 char entry_type = MDEntryType.getValue();
+                if (entry_type == '2') {
+                    char aggressor = 0;
+                    if (group.isSetField(raw::AGGRESSOR_SIDE)) {
+                        const std::string& value = group.getField(raw::AGGRESSOR_SIDE);
+                        if (!value.empty()) aggressor = value.front();
+                    }
+                    update.trades.emplace_back(pascal::common::Trade{.symbol_id = update.symbol_id, .priceLevel = pascal::common::PriceLevel{.Price = price, .Quantity = qty},
+                        .aggressor = static_cast<pascal::common::AggressorSide>(aggressor), .trade_id = uint_field(group, raw::TRADE_ID), .recv_time = recv_time});
+                    continue;
+                }
                 pascal::common::Side side;
                 if (entry_type == '0') side = pascal::common::Side::BID;
                 else if (entry_type == '1') side = pascal::common::Side::OFFER;
                 else continue; // Skip invalid entry types
                 update.md_entries.emplace_back(pascal::common::MarketDataEntry{.side = side, .priceLevel = pascal::common::PriceLevel{.Price = price, .Quantity = qty}, .update_action = static_cast<pascal::common::UpdateAction>(action.getValue())});
             }
+            //268 counts the trades too, the books only see the book entries
+            update.marketDepth = static_cast<uint32_t>(update.md_entries.size());
 
-            
-            
-            auto end_time = std::chrono::high_resolution_clock::now();
-            uint64_t processing_time = std::chrono::duration_cast<std::chrono::microseconds>(end_time-recv_time).count();
-            messaged_processed.fetch_add(1, std::memory_order_release);
-            time_spent_processing.fetch_add(processing_time, std::memory_order_release);
-            return update;
+            record_processing_time(recv_time);
+            return true;
         }
 
     }
@@ -0,0 +1,188 @@
+#include "net/fix_raw_decoder.h"
+
+namespace pascal {
+    namespace market_data {
+        namespace {
+            //Calls fn(tag, value_begin, value_end) for every field in the buffer, fn returns false to stop early
+            template<typename Fn>
+            inline bool for_each_field(const char* data, size_t len, Fn&& fn) {
+                const char* end = data+len;
+                raw::SohScanner scanner(data, end);
+                const char* field = data;
+                while (field < end) {
+                    const char* soh = scanner.next();
+                    const char* eq = field;
+                    uint32_t tag = 0;
+                    while (eq < soh && *eq != '=') {
+                        tag = tag*10 + static_cast<uint32_t>(*eq - '0');
+                        eq++;
+                    }
+                    if (eq == soh) return false; //Malformed field, no '='
+                    if (!fn(tag, eq+1, soh)) return true;
+                    field = soh+1;
+                }
+                return true;
+            }
+
+            //Repeating group entry being assembled, flushed when the next entry starts or at end of message
+            struct PendingEntry {
+                char type = 0;
+                char action = 0;
+                int64_t price = 0;
+                int64_t qty = 0;
+                uint64_t trade_id = 0;
+                char aggressor = 0;
+
+                void reset() {
+                    *this = PendingEntry{};
+                }
+            };
+        }
+
+        FIXRawDecoder::MessageKind FIXRawDecoder::message_kind(const char* data, size_t len) {
+            MessageKind kind = MessageKind::UNKNOWN;
+            for_each_field(data, len, [&kind](uint32_t tag, const char* value, const char* value_end) {
+                if (tag != raw::MSG_TYPE) return true;
+                if (value_end-value == 1) {
+                    if (*value == 'W') kind = MessageKind::SNAPSHOT;
+                    else if (*value == 'X') kind = MessageKind::INCREMENT;
+                }
+                return false;
+            });
+            return kind;
+        }
+        bool FIXRawDecoder::decode_snapshot(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time, pascal::common::MarketDataSnapshot& snapshot) {
+            //The event may be reused, keep its storage
+            snapshot.symbol_id = pascal::common::INVALID_SYMBOL_ID;
+            snapshot.bids.clear();
+            snapshot.asks.clear();
+            snapshot.last_update_id = 0;
+            PendingEntry entry;
+            bool has_symbol = false;
+            auto flush = [&snapshot, &entry]() {
+                if (entry.type == '0') snapshot.bids.emplace_back(pascal::common::PriceLevel{.Price = entry.price, .Quantity = entry.qty});
+                else if (entry.type == '1') snapshot.asks.emplace_back(pascal::common::PriceLevel{.Price = entry.price, .Quantity = entry.qty});
+                entry.reset();
+            };
+
+            bool ok = for_each_field(data, len, [&](uint32_t tag, const char* value, const char* value_end) {
+                switch (tag) {
+                    case raw::SYMBOL:
+                        if (!has_symbol) {
+                            snapshot.symbol_id = pascal::common::SymbolRegistry::instance().find(std::string_view(value, value_end-value));
+                            has_symbol = snapshot.symbol_id != pascal::common::INVALID_SYMBOL_ID;
+                        }
+                        break;
+                    case raw::NO_MD_ENTRIES: {
+                        size_t numEntries = raw::parse_uint(value, value_end);
+                        snapshot.bids.reserve(numEntries);
+                        snapshot.asks.reserve(numEntries);
+                        break;
+                    }
+                    case raw::LAST_BOOK_UPDATE_ID:
+                        snapshot.last_update_id = raw::parse_uint(value, value_end);
+                        break;
+                    case raw::MD_ENTRY_TYPE:
+                        if (entry.type) flush();
+                        entry.type = *value;
+                        break;
+                    case raw::MD_ENTRY_PX:
+                        entry.price = pascal::common::parse_wire_decimal(value, value_end);
+                        break;
+                    case raw::MD_ENTRY_SIZE:
+                        entry.qty = pascal::common::parse_wire_decimal(value, value_end);
+                        break;
+                    default:
+                        break;
+                }
+                return true;
+            });
+            if (entry.type) flush();
+
+            snapshot.recv_time = recv_time;
+            return ok && has_symbol;
+        }
+        bool FIXRawDecoder::decode_increment(const char* data, size_t len, std::chrono::high_resolution_clock::time_point recv_time, pascal::common::MarketDataIncrement& update) {
+            update.symbol_id = pascal::common::INVALID_SYMBOL_ID;
+            update.md_entries.clear();
+            update.trades.clear();
+            update.recv_time = recv_time;
+            update.marketDepth = 0;
+            update.first_update_id = 0;
+            update.last_update_id = 0;
+            PendingEntry entry;
+            bool has_symbol = false;
+            bool in_group = false;
+            char default_action = pascal::common::UpdateAction::NEW;
+            auto flush = [&update, &entry, &default_action]() {
+                if (entry.type == '0' || entry.type == '1') {
+                    auto side = entry.type == '0' ? pascal::common::Side::BID : pascal::common::Side::OFFER;
+                    auto action = static_cast<pascal::common::UpdateAction>(entry.action ? entry.action : default_action);
+                    update.md_entries.emplace_back(pascal::common::MarketDataEntry{.side = side, .priceLevel = pascal::common::PriceLevel{.Price = entry.price, .Quantity = entry.qty}, .update_action = action});
+                }
+                else if (entry.type == '2') {
+                    update.trades.emplace_back(pascal::common::Trade{.priceLevel = pascal::common::PriceLevel{.Price = entry.price, .Quantity = entry.qty},
+                        .aggressor = static_cast<pascal::common::AggressorSide>(entry.aggressor), .trade_id = entry.trade_id, .recv_time = update.recv_time});
+                }
+                entry.reset();
+            };
+
+            bool ok = for_each_field(data, len, [&](uint32_t tag, const char* value, const char* value_end) {
+                switch (tag) {
+                    case raw::SYMBOL:
+                        if (!has_symbol) {
+                            update.symbol_id = pascal::common::SymbolRegistry::instance().find(std::string_view(value, value_end-value));
+                            has_symbol = update.symbol_id != pascal::common::INVALID_SYMBOL_ID;
+                        }
+                        break;
+                    case raw::NO_MD_ENTRIES:
+                        update.marketDepth = static_cast<uint32_t>(raw::parse_uint(value, value_end));
+                        update.md_entries.reserve(update.marketDepth);
+                        in_group = true;
+                        break;
+                    case raw::FIRST_BOOK_UPDATE_ID:
+                        update.first_update_id = raw::parse_uint(value, value_end);
+                        break;
+                    case raw::LAST_BOOK_UPDATE_ID:
+                        update.last_update_id = raw::parse_uint(value, value_end);
+                        break;
+                    case raw::MD_UPDATE_ACTION:
+                        //Before the group it applies to every entry, inside the group it opens a new entry
+                        if (!in_group) {
+                            default_action = *value;
+                            break;
+                        }
+                        if (entry.action) flush();
+                        entry.action = *value;
+                        break;
+                    case raw::MD_ENTRY_TYPE:
+                        if (entry.type) flush();
+                        entry.type = *value;
+                        break;
+                    case raw::MD_ENTRY_PX:
+                        entry.price = pascal::common::parse_wire_decimal(value, value_end);
+                        break;
+                    case raw::MD_ENTRY_SIZE:
+                        entry.qty = pascal::common::parse_wire_decimal(value, value_end);
+                        break;
+                    case raw::TRADE_ID:
+                        entry.trade_id = raw::parse_uint(value, value_end);
+                        break;
+                    case raw::AGGRESSOR_SIDE:
+                        entry.aggressor = value != value_end ? *value : 0;
+                        break;
+                    default:
+                        break;
+                }
+                return true;
+            });
+            if (entry.type) flush();
+            //268 counts the trades too, the books only see the book entries
+            update.marketDepth = static_cast<uint32_t>(update.md_entries.size());
+
+            //The Symbol field may follow the trades it applies to
+            for (auto& trade : update.trades) trade.symbol_id = update.symbol_id;
+            return ok && has_symbol;
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#include "net/message_journal.h"
+#include "common/tsc_clock.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pascal {
+    namespace net {
+        namespace {
+            std::runtime_error journal_error(const std::string& what, const std::string& path) {
+                return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+            }
+        }
+
+        MessageJournalWriter::MessageJournalWriter(const std::string& path, size_t growth) : path(path), growth(growth < 4096 ? 4096 : growth) {
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) throw journal_error("Cannot create journal", path);
+            if (!remap(this->growth)) {
+                ::close(fd);
+                throw journal_error("Cannot map journal", path);
+            }
+            JournalHeader* h = header();
+            std::memcpy(h->magic, JournalHeader::MAGIC, sizeof(h->magic));
+            h->version = JournalHeader::VERSION;
+            h->header_size = sizeof(JournalHeader);
+            h->record_count = 0;
+            h->created_nanos = pascal::common::TscClock::now_nanos();
+            used = sizeof(JournalHeader);
+            h->end_offset = used;
+        }
+        MessageJournalWriter::~MessageJournalWriter() {
+            close();
+        }
+        JournalHeader* MessageJournalWriter::header() const {
+            return reinterpret_cast<JournalHeader*>(base);
+        }
+        bool MessageJournalWriter::remap(size_t size) {
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0) return false;
+            void* region;
+#ifdef __linux__
+            region = base ? ::mremap(base, mapped, size, MREMAP_MAYMOVE) : ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#else
+            if (base) {
+                ::munmap(base, mapped);
+                base = nullptr;
+                mapped = 0;
+            }
+            region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+            if (region == MAP_FAILED) return false;
+
+            //Take the page faults of the new range here rather than on the message path
+            volatile char* pages = static_cast<char*>(region);
+            for (size_t offset = mapped; offset < size; offset += 4096) pages[offset] = 0;
+            base = static_cast<char*>(region);
+            mapped = size;
+            return true;
+        }
+        bool MessageJournalWriter::append(const char* data, size_t len, int64_t recv_nanos) {
+            if (!base || len > UINT32_MAX) return false;
+            size_t need = MessageJournalReader::record_bytes(len);
+            if (used + need > mapped) {
+                size_t size = mapped + growth;
+                while (used + need > size) size += growth;
+                if (!remap(size)) return false;
+            }
+            JournalRecordHeader* record = reinterpret_cast<JournalRecordHeader*>(base + used);
+            record->size = static_cast<uint32_t>(len);
+            record->reserved = 0;
+            record->recv_nanos = recv_nanos;
+            std::memcpy(record+1, data, len);
+            used += need;
+
+            JournalHeader* h = header();
+            h->record_count++;
+            __atomic_store_n(&h->end_offset, used, __ATOMIC_RELEASE);
+            return true;
+        }
+        void MessageJournalWriter::flush() {
+            if (base) ::msync(base, used, MS_ASYNC);
+        }
+        void MessageJournalWriter::close() {
+            if (fd < 0) return;
+            if (base) {
+                ::msync(base, used, MS_SYNC);
+                ::munmap(base, mapped);
+                base = nullptr;
+            }
+            //A failed truncate only keeps the zero filled tail, readers stop at end_offset
+            [[maybe_unused]] int rc = ::ftruncate(fd, static_cast<off_t>(used));
+            ::close(fd);
+            fd = -1;
+        }
+        uint64_t MessageJournalWriter::get_record_count() const {
+            return base ? header()->record_count : 0;
+        }
+        uint64_t MessageJournalWriter::get_bytes_written() const {
+            return used;
+        }
+        const std::string& MessageJournalWriter::get_path() const {
+            return path;
+        }
+
+        MessageJournalReader::MessageJournalReader(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) throw journal_error("Cannot open journal", path);
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(JournalHeader)) {
+                ::close(fd);
+                throw std::runtime_error("Not a journal: " + path);
+            }
+            mapped = static_cast<size_t>(st.st_size);
+            void* region = ::mmap(nullptr, mapped, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (region == MAP_FAILED) throw journal_error("Cannot map journal", path);
+            base = static_cast<const char*>(region);
+
+            const JournalHeader* h = reinterpret_cast<const JournalHeader*>(base);
+            if (std::memcmp(h->magic, JournalHeader::MAGIC, sizeof(h->magic)) != 0 || h->version != JournalHeader::VERSION) {
+                ::munmap(const_cast<char*>(base), mapped);
+                throw std::runtime_error("Not a journal: " + path);
+            }
+            end = std::min<size_t>(h->end_offset, mapped);
+#ifdef __linux__
+            ::madvise(const_cast<char*>(base), mapped, MADV_SEQUENTIAL);
+#endif
+        }
+        MessageJournalReader::~MessageJournalReader() {
+            if (base) ::munmap(const_cast<char*>(base), mapped);
+        }
+        uint64_t MessageJournalReader::get_record_count() const {
+            return reinterpret_cast<const JournalHeader*>(base)->record_count;
+        }
+        int64_t MessageJournalReader::get_created_nanos() const {
+            return reinterpret_cast<const JournalHeader*>(base)->created_nanos;
+        }
+    }
+}
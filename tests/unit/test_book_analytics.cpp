@@ -0,0 +1,121 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_approx.hpp"
+#include "market_data/fix_order_book.h"
+#include "market_data/book_analytics.h"
+#include "common/types.h"
+#include <vector>
+
+namespace pascal {
+    namespace test {
+
+        class BookAnalyticsTestFeature {
+        public:
+            pascal::market_data::FIXOrderBookManager manager;
+            pascal::market_data::BookAnalyticsTable analytics;
+            pascal::common::SymbolId id;
+
+            BookAnalyticsTestFeature() {
+                id = manager.add_symbol("ANALYTICSUSDT", pascal::common::InstrumentSpec::from_increments(0.01, 0.00001));
+                manager.set_analytics(&analytics);
+            }
+
+            //levels bid and ask levels one tick apart around 1000/1010, quantity 10 at every level
+            void seed(int levels) {
+                pascal::common::MarketDataSnapshot snapshot;
+                snapshot.symbol_id = id;
+                for (int i = 0; i < levels; i++) {
+                    snapshot.bids.push_back({.Price = 1000 - i, .Quantity = 10});
+                    snapshot.asks.push_back({.Price = 1010 + i, .Quantity = 10});
+                }
+                manager.process_snapshot(snapshot);
+            }
+            void apply(std::vector<pascal::common::MarketDataEntry> entries) {
+                pascal::common::MarketDataIncrement update;
+                update.symbol_id = id;
+                update.md_entries.assign(entries.begin(), entries.end());
+                update.marketDepth = static_cast<uint32_t>(entries.size());
+                manager.process_increment(update);
+            }
+            pascal::market_data::BookAnalytics load() {
+                pascal::market_data::BookAnalytics values;
+                REQUIRE(analytics.load(id, values));
+                return values;
+            }
+        };
+
+        TEST_CASE("Book Analytics - Values follow the book", "[book_analytics]") {
+            BookAnalyticsTestFeature feature;
+            pascal::market_data::BookAnalytics values;
+            CHECK_FALSE(feature.analytics.load(feature.id, values));
+
+            feature.seed(3);
+            values = feature.load();
+            CHECK(values.valid);
+            CHECK(values.best_bid.Price == 1000);
+            CHECK(values.best_ask.Price == 1010);
+            CHECK(values.spread == 10);
+            CHECK(values.mid == Catch::Approx(1005.0));
+            CHECK(values.microprice == Catch::Approx(1005.0));
+            CHECK(values.bid_depth == 30);
+            CHECK(values.ask_depth == 30);
+            CHECK(values.imbalance == Catch::Approx(0.0));
+            CHECK(values.bid_depth_price == Catch::Approx(999.0));
+            CHECK(values.ask_depth_price == Catch::Approx(1011.0));
+
+            //More size on the bid pulls the microprice towards the ask
+            feature.apply({
+                {.side = pascal::common::Side::BID, .priceLevel = {.Price = 1000, .Quantity = 30}, .update_action = pascal::common::UpdateAction::CHANGE},
+                {.side = pascal::common::Side::OFFER, .priceLevel = {.Price = 1012, .Quantity = 10}, .update_action = pascal::common::UpdateAction::DELETE}
+            });
+            values = feature.load();
+            CHECK(values.microprice == Catch::Approx((1000.0*10 + 1010.0*30)/40));
+            CHECK(values.bid_depth == 50);
+            CHECK(values.ask_depth == 20);
+            CHECK(values.imbalance == Catch::Approx(30.0/70));
+            CHECK(values.ask_depth_price == Catch::Approx(1010.5));
+            CHECK(values.book_version == feature.manager.get_book(feature.id)->get_version());
+        }
+        TEST_CASE("Book Analytics - Updates behind the top levels are skipped", "[book_analytics]") {
+            BookAnalyticsTestFeature feature;
+            feature.seed(pascal::market_data::BookAnalyticsTable::DEPTH + 5);
+            uint64_t recomputes = feature.analytics.get_recomputes();
+            auto before = feature.load();
+
+            //Levels 12 and 13 deep on either side cannot move the top ten
+            feature.apply({
+                {.side = pascal::common::Side::BID, .priceLevel = {.Price = 988, .Quantity = 5}, .update_action = pascal::common::UpdateAction::CHANGE},
+                {.side = pascal::common::Side::OFFER, .priceLevel = {.Price = 1022, .Quantity = 10}, .update_action = pascal::common::UpdateAction::DELETE}
+            });
+            CHECK(feature.analytics.get_recomputes() == recomputes);
+            CHECK(feature.analytics.get_skipped_updates() == 1);
+            CHECK(feature.load().bid_depth == before.bid_depth);
+
+            //The tenth bid level is inside
+            feature.apply({
+                {.side = pascal::common::Side::BID, .priceLevel = {.Price = 991, .Quantity = 5}, .update_action = pascal::common::UpdateAction::CHANGE},
+                {.side = pascal::common::Side::BID, .priceLevel = {.Price = 985, .Quantity = 5}, .update_action = pascal::common::UpdateAction::NEW}
+            });
+            CHECK(feature.analytics.get_recomputes() == recomputes + 1);
+            CHECK(feature.load().bid_depth == before.bid_depth - 5);
+        }
+        TEST_CASE("Book Analytics - A stale book is published as invalid", "[book_analytics]") {
+            BookAnalyticsTestFeature feature;
+            pascal::common::MarketDataSnapshot snapshot;
+            snapshot.symbol_id = feature.id;
+            snapshot.bids.push_back({.Price = 1000, .Quantity = 10});
+            snapshot.asks.push_back({.Price = 1010, .Quantity = 10});
+            snapshot.last_update_id = 50;
+            feature.manager.process_snapshot(snapshot);
+            CHECK(feature.load().valid);
+
+            pascal::common::MarketDataIncrement update;
+            update.symbol_id = feature.id;
+            update.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = 1001, .Quantity = 10}, .update_action = pascal::common::UpdateAction::NEW});
+            update.marketDepth = 2;
+            update.first_update_id = 60;
+            update.last_update_id = 60;
+            feature.manager.process_increment(update);
+            CHECK_FALSE(feature.load().valid);
+        }
+    }
+}
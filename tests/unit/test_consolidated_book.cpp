@@ -0,0 +1,226 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include "market_data/consolidated_book.h"
+#include "market_data/synthetic_feed.h"
+#include "common/types.h"
+#include <array>
+#include <map>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+
+        class ConsolidatedBookTestFeature {
+        public:
+            static constexpr pascal::common::VenueId BINANCE = 0;
+            static constexpr pascal::common::VenueId COINAPI = 1;
+
+            pascal::market_data::ConsolidatedBookManager manager;
+            pascal::common::InstrumentSpec spec = pascal::common::InstrumentSpec::from_increments(0.01, 0.00001);
+            pascal::common::SymbolId id;
+            std::vector<pascal::market_data::CrossVenueBBO> changes;
+
+            ConsolidatedBookTestFeature(pascal::market_data::BookType type = pascal::market_data::BookType::VECTOR) {
+                id = manager.add_symbol(BINANCE, "CONSUSDT", spec, type);
+                manager.add_symbol(COINAPI, "CONSUSDT", spec, type);
+                manager.set_bbo_handler([this](pascal::common::SymbolId, const pascal::market_data::CrossVenueBBO& bbo) {
+                    changes.push_back(bbo);
+                });
+            }
+
+            void snapshot(pascal::common::VenueId venue, std::vector<pascal::common::PriceLevel> bids, std::vector<pascal::common::PriceLevel> asks, uint64_t last_update_id = 0) {
+                pascal::common::MarketDataSnapshot snapshot{.symbol_id = id, .venue = venue, .bids = bids, .asks = asks, .recv_time = {}, .last_update_id = last_update_id};
+                manager.process_snapshot(snapshot);
+            }
+            void apply(pascal::common::VenueId venue, std::vector<pascal::common::MarketDataEntry> entries, uint64_t update_id = 0) {
+                pascal::common::MarketDataIncrement update;
+                update.symbol_id = id;
+                update.venue = venue;
+                update.md_entries.assign(entries.begin(), entries.end());
+                update.marketDepth = static_cast<uint32_t>(entries.size());
+                update.first_update_id = update_id;
+                update.last_update_id = update_id;
+                manager.process_increment(update);
+            }
+            const pascal::market_data::ConsolidatedBook& book() const {
+                return *manager.get_consolidated(id);
+            }
+        };
+
+        TEST_CASE("Consolidated Book - Levels are attributed to their venues", "[consolidated_book]") {
+            using Feature = ConsolidatedBookTestFeature;
+            Feature feature;
+            REQUIRE(feature.id != pascal::common::INVALID_SYMBOL_ID);
+            CHECK(feature.manager.get_book(Feature::BINANCE, feature.id) != feature.manager.get_book(Feature::COINAPI, feature.id));
+            CHECK(feature.manager.add_symbol(Feature::COINAPI, "CONSUSDT", {}) == pascal::common::INVALID_SYMBOL_ID);
+            CHECK(feature.manager.add_symbol(pascal::common::MAX_VENUES, "CONSUSDT", feature.spec) == pascal::common::INVALID_SYMBOL_ID);
+
+            feature.snapshot(Feature::BINANCE, {{100, 5}, {99, 3}}, {{102, 4}});
+            feature.snapshot(Feature::COINAPI, {{101, 1}, {100, 2}}, {{102, 6}, {103, 1}});
+            CHECK(feature.book().get_venues() == 0b11);
+
+            std::array<pascal::market_data::ConsolidatedLevel, 8> levels;
+            REQUIRE(feature.book().get_bids(levels) == 3);
+            CHECK(levels[0].price == 101);
+            CHECK(levels[1].price == 100);
+            CHECK(levels[1].quantity == 7);
+            CHECK(levels[1].venue_quantity[Feature::BINANCE] == 5);
+            CHECK(levels[1].venue_quantity[Feature::COINAPI] == 2);
+            CHECK(levels[2].venue_quantity[Feature::COINAPI] == 0);
+            REQUIRE(feature.book().get_asks(levels) == 2);
+            CHECK(levels[0].quantity == 10);
+            CHECK(levels[1].price == 103);
+
+            pascal::market_data::CrossVenueBBO bbo = feature.book().get_bbo();
+            CHECK(bbo.bid.Price == 101);
+            CHECK(bbo.bid_venues == 0b10);
+            CHECK(bbo.ask.Price == 102);
+            CHECK(bbo.ask.Quantity == 10);
+            CHECK(bbo.ask_venues == 0b11);
+            CHECK_FALSE(bbo.crossed());
+            REQUIRE(feature.changes.size() == 2);
+            CHECK(feature.changes.back().sequence == bbo.sequence);
+
+            //Deep changes leave the BBO alone
+            feature.apply(Feature::BINANCE, {
+                {.side = pascal::common::Side::BID, .priceLevel = {.Price = 99, .Quantity = 8}, .update_action = pascal::common::UpdateAction::CHANGE},
+                {.side = pascal::common::Side::BID, .priceLevel = {.Price = 98, .Quantity = 1}, .update_action = pascal::common::UpdateAction::NEW}
+            });
+            CHECK(feature.changes.size() == 2);
+            REQUIRE(feature.book().get_bids(levels) == 4);
+            CHECK(levels[2].quantity == 8);
+            CHECK(levels[3].venue_quantity[Feature::BINANCE] == 1);
+
+
+            feature.apply(Feature::BINANCE, {{.side = pascal::common::Side::OFFER, .priceLevel = {.Price = 102, .Quantity = 4}, .update_action = pascal::common::UpdateAction::DELETE}});
+            REQUIRE(feature.changes.size() == 3);
+            CHECK(feature.changes.back().ask.Quantity == 6);
+            CHECK(feature.changes.back().ask_venues == 0b10);
+
+            //One venue bidding through the other's offer
+            feature.apply(Feature::BINANCE, {{.side = pascal::common::Side::BID, .priceLevel = {.Price = 103, .Quantity = 2}, .update_action = pascal::common::UpdateAction::NEW}});
+            REQUIRE(feature.changes.size() == 4);
+            CHECK(feature.changes.back().crossed());
+            CHECK(feature.changes.back().bid_venues == 0b01);
+
+            //A top of book change replaces the venue's best level wherever it was
+            feature.apply(Feature::BINANCE, {{.side = pascal::common::Side::BID, .priceLevel = {.Price = 104, .Quantity = 3}, .update_action = pascal::common::UpdateAction::CHANGE}});
+            REQUIRE(feature.changes.size() == 5);
+            CHECK(feature.changes.back().bid.Price == 104);
+            REQUIRE(feature.book().get_bids(levels) == 5);
+            CHECK(levels[1].price == 101);
+            CHECK(feature.manager.get_bbo_changes() == 5);
+        }
+        TEST_CASE("Consolidated Book - Stale venues drop out until resynchronized", "[consolidated_book]") {
+            using Feature = ConsolidatedBookTestFeature;
+            Feature feature;
+            feature.snapshot(Feature::BINANCE, {{100, 5}}, {{102, 4}});
+            feature.snapshot(Feature::COINAPI, {{101, 1}}, {{103, 1}}, 10);
+            CHECK(feature.book().get_bbo().bid.Price == 101);
+
+            //A gap on one venue takes its levels out, the other keeps quoting
+            feature.apply(Feature::COINAPI, {{.side = pascal::common::Side::BID, .priceLevel = {.Price = 101, .Quantity = 3}, .update_action = pascal::common::UpdateAction::CHANGE}}, 15);
+            CHECK(feature.book().get_venues() == 0b01);
+            CHECK(feature.book().get_bbo().bid.Price == 100);
+            CHECK(feature.book().get_bbo().bid_venues == 0b01);
+
+            //Buffered updates of the stale venue change nothing
+            size_t seen = feature.changes.size();
+            feature.apply(Feature::COINAPI, {{.side = pascal::common::Side::BID, .priceLevel = {.Price = 101, .Quantity = 4}, .update_action = pascal::common::UpdateAction::CHANGE}}, 16);
+            CHECK(feature.changes.size() == seen);
+
+            //The resync snapshot folds the venue back in, with the buffered update replayed
+            feature.snapshot(Feature::COINAPI, {{101, 2}}, {{103, 1}}, 15);
+            CHECK(feature.book().get_venues() == 0b11);
+            CHECK(feature.book().get_bbo().bid.Price == 101);
+            CHECK(feature.book().get_bbo().bid.Quantity == 4);
+        }
+        TEST_CASE("Consolidated Book - Levels behind a full side keep their venue quantities", "[consolidated_book]") {
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            using Feature = ConsolidatedBookTestFeature;
+            using pascal::market_data::ConsolidatedBook;
+            Feature feature(type);
+            auto ladder = [](pascal::common::Ticks worst, pascal::common::Ticks best) {
+                std::vector<pascal::common::PriceLevel> levels;
+                for (pascal::common::Ticks price = best; price >= worst; price--) levels.push_back({price, 1});
+                return levels;
+            };
+            std::vector<pascal::market_data::ConsolidatedLevel> levels(ConsolidatedBook::MAX_LEVELS);
+
+            //Binance fills the side, Coinapi joins its worst price and quotes one behind it
+            feature.snapshot(Feature::BINANCE, ladder(1, ConsolidatedBook::MAX_LEVELS), {});
+            feature.snapshot(Feature::COINAPI, {{1, 5}, {0, 7}}, {});
+            REQUIRE(feature.book().get_bids(levels) == ConsolidatedBook::MAX_LEVELS);
+            CHECK(levels.back().price == 1);
+            CHECK(levels.back().quantity == 6);
+
+            //A better level pushes the shared one out of the kept levels
+            auto deeper = ladder(1, ConsolidatedBook::MAX_LEVELS);
+            deeper.insert(deeper.begin(), {5000, 1});
+            feature.snapshot(Feature::BINANCE, deeper, {});
+            REQUIRE(feature.book().get_bids(levels) == ConsolidatedBook::MAX_LEVELS);
+            CHECK(levels.back().price == 2);
+
+            //Once Binance thins out, both come back with every venue's quantity
+            feature.snapshot(Feature::BINANCE, ladder(1, 10), {});
+            REQUIRE(feature.book().get_bids(levels) == 11);
+            CHECK(levels[9].price == 1);
+            CHECK(levels[9].quantity == 6);
+            CHECK(levels[9].venue_quantity[Feature::BINANCE] == 1);
+            CHECK(levels[9].venue_quantity[Feature::COINAPI] == 5);
+            CHECK(levels[10].price == 0);
+            CHECK(levels[10].venue_quantity[Feature::COINAPI] == 7);
+        }
+        TEST_CASE("Consolidated Book - Matches the venue books merged", "[consolidated_book]") {
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            using Feature = ConsolidatedBookTestFeature;
+            Feature feature(type);
+            std::array<pascal::market_data::SyntheticFeed, 2> feeds = {
+                pascal::market_data::SyntheticFeed(feature.id, 5000000, 40, pascal::market_data::DepthProfile::GEOMETRIC, 3),
+                pascal::market_data::SyntheticFeed(feature.id, 5000004, 40, pascal::market_data::DepthProfile::UNIFORM, 5)
+            };
+            for (pascal::common::VenueId venue = 0; venue < feeds.size(); venue++) {
+                pascal::common::MarketDataSnapshot snapshot = feeds[venue].snapshot();
+                snapshot.venue = venue;
+                feature.manager.process_snapshot(snapshot);
+            }
+
+            pascal::common::MarketDataIncrement update;
+            std::vector<pascal::market_data::ConsolidatedLevel> levels(200);
+            for (int n = 1; n <= 4000; n++) {
+                pascal::common::VenueId venue = static_cast<pascal::common::VenueId>(n % 2);
+                feeds[venue].next_increment(update, 3);
+                update.venue = venue;
+                feature.manager.process_increment(update);
+                if (n % 500) continue;
+
+                //Rebuilt from scratch, best first
+                std::map<pascal::common::Ticks, std::array<pascal::common::Lots, 2>, std::greater<>> bids;
+                std::map<pascal::common::Ticks, std::array<pascal::common::Lots, 2>> asks;
+                for (size_t v = 0; v < feeds.size(); v++) {
+                    pascal::common::MarketDataSnapshot expected = feeds[v].snapshot();
+                    for (const auto& level : expected.bids) bids[level.Price][v] = level.Quantity;
+                    for (const auto& level : expected.asks) asks[level.Price][v] = level.Quantity;
+                }
+                REQUIRE(feature.book().get_bids(levels) == bids.size());
+                size_t i = 0;
+                for (const auto& [price, quantities] : bids) {
+                    REQUIRE(levels[i].price == price);
+                    REQUIRE(levels[i].venue_quantity[0] == quantities[0]);
+                    REQUIRE(levels[i].venue_quantity[1] == quantities[1]);
+                    REQUIRE(levels[i].quantity == quantities[0] + quantities[1]);
+                    i++;
+                }
+                REQUIRE(feature.book().get_asks(levels) == asks.size());
+                i = 0;
+                for (const auto& [price, quantities] : asks) {
+                    REQUIRE(levels[i].price == price);
+                    REQUIRE(levels[i].quantity == quantities[0] + quantities[1]);
+                    i++;
+                }
+                REQUIRE(feature.book().get_bbo().bid.Price == bids.begin()->first);
+                REQUIRE(feature.book().get_bbo().ask.Price == asks.begin()->first);
+            }
+        }
+    }
+}
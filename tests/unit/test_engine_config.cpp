@@ -0,0 +1,125 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/engine_config.h"
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+        //[DEFAULT] section of a settings file
+        pascal::net::SettingLookup lookup_in(const std::map<std::string, std::string>& settings) {
+            return [settings](const std::string& key, std::string& value) {
+                auto it = settings.find(key);
+                if (it == settings.end()) return false;
+                value = it->second;
+                return true;
+            };
+        }
+
+        TEST_CASE("Engine Config - WorkerCores lists", "[engine_config]") {
+            SECTION("Listed cores in order") {
+                CHECK(pascal::net::parse_worker_cores("2,3,5") == std::vector<int>{2, 3, 5});
+                CHECK(pascal::net::parse_worker_cores(" 4, 7 ,,") == std::vector<int>{4, 7});
+            }
+            SECTION("Empty lists leave the engine unconfigured") {
+                CHECK(pascal::net::parse_worker_cores("").empty());
+                CHECK(pascal::net::parse_worker_cores(",, ,").empty());
+            }
+            SECTION("Malformed entries are rejected") {
+                CHECK_THROWS_AS(pascal::net::parse_worker_cores("2,x"), std::invalid_argument);
+                CHECK_THROWS_AS(pascal::net::parse_worker_cores("2x"), std::invalid_argument);
+                CHECK_THROWS_AS(pascal::net::parse_worker_cores("-1"), std::invalid_argument);
+                CHECK_THROWS_AS(pascal::net::parse_worker_cores("1.5"), std::invalid_argument);
+                CHECK_THROWS_AS(pascal::net::parse_worker_cores("2 3"), std::invalid_argument);
+                CHECK_THROWS_AS(pascal::net::parse_worker_cores("99999999999"), std::invalid_argument);
+            }
+            SECTION("Unconfigured cores skip core 0 and stay on the machine") {
+                CHECK(pascal::net::default_worker_cores(3, 8) == std::vector<int>{1, 2, 3});
+                CHECK(pascal::net::default_worker_cores(10, 4) == std::vector<int>{1, 2, 3});
+                CHECK(pascal::net::default_worker_cores(0, 4) == std::vector<int>{1});
+                CHECK(pascal::net::default_worker_cores(5, 1) == std::vector<int>{0});
+                CHECK(pascal::net::default_worker_cores(5, 0) == std::vector<int>{0});
+            }
+        }
+        TEST_CASE("Engine Config - Wait strategy settings", "[engine_config]") {
+            SECTION("Unset keys keep the defaults") {
+                pascal::common::WaitStrategyConfig defaults;
+                auto config = pascal::net::load_wait_config(lookup_in({}), "BTCUSDT");
+                CHECK(config.type == pascal::common::WaitStrategyType::SPIN_PARK);
+                CHECK(config.type == defaults.type);
+                CHECK(config.spin_count == defaults.spin_count);
+                CHECK(config.park_timeout == defaults.park_timeout);
+            }
+            SECTION("Per symbol keys override the section wide ones") {
+                auto lookup = lookup_in({{"WaitStrategy", "SPIN_YIELD"}, {"WaitSpinCount", "500"}, {"WaitStrategy.ETHUSDT", "BUSY_SPIN"}, {"WaitParkTimeoutUs.ETHUSDT", "50"}});
+                auto btc = pascal::net::load_wait_config(lookup, "BTCUSDT");
+                CHECK(btc.type == pascal::common::WaitStrategyType::SPIN_YIELD);
+                CHECK(btc.spin_count == 500);
+                CHECK(btc.park_timeout == pascal::common::WaitStrategyConfig{}.park_timeout);
+                auto eth = pascal::net::load_wait_config(lookup, "ETHUSDT");
+                CHECK(eth.type == pascal::common::WaitStrategyType::BUSY_SPIN);
+                CHECK(eth.spin_count == 500);
+                CHECK(eth.park_timeout == std::chrono::microseconds(50));
+            }
+            SECTION("Malformed values are rejected") {
+                CHECK_THROWS_AS(pascal::net::load_wait_config(lookup_in({{"WaitStrategy", "SLEEP"}}), "BTCUSDT"), std::invalid_argument);
+                CHECK_THROWS_AS(pascal::net::load_wait_config(lookup_in({{"WaitSpinCount", "10k"}}), "BTCUSDT"), std::invalid_argument);
+                CHECK_THROWS_AS(pascal::net::load_wait_config(lookup_in({{"WaitSpinCount", "5000000000"}}), "BTCUSDT"), std::invalid_argument);
+                CHECK_THROWS_AS(pascal::net::load_wait_config(lookup_in({{"WaitParkTimeoutUs.BTCUSDT", "-5"}}), "BTCUSDT"), std::invalid_argument);
+            }
+        }
+        TEST_CASE("Engine Config - Symbols dealt to workers", "[engine_config]") {
+            using pascal::common::WaitStrategyType;
+            std::vector<pascal::common::WaitStrategyConfig> waitConfigs(8);
+            waitConfigs[1] = {.type = WaitStrategyType::SPIN_PARK, .spin_count = 100, .park_timeout = std::chrono::microseconds(500)};
+            waitConfigs[2] = {.type = WaitStrategyType::SPIN_YIELD, .spin_count = 50, .park_timeout = std::chrono::microseconds(2000)};
+            waitConfigs[3] = {.type = WaitStrategyType::SPIN_PARK, .spin_count = 20000, .park_timeout = std::chrono::microseconds(100)};
+
+            SECTION("Round-robin over the cores") {
+                auto plans = pascal::net::plan_workers({4, 6}, {1, 2, 3}, waitConfigs);
+                REQUIRE(plans.size() == 2);
+                CHECK(plans[0].core_id == 4);
+                CHECK(plans[0].symbols == std::vector<pascal::common::SymbolId>{1, 3});
+                CHECK(plans[1].core_id == 6);
+                CHECK(plans[1].symbols == std::vector<pascal::common::SymbolId>{2});
+            }
+            SECTION("A shared worker idles like its most latency sensitive symbol") {
+                auto plans = pascal::net::plan_workers({4}, {1, 2, 3}, waitConfigs);
+                REQUIRE(plans.size() == 1);
+                CHECK(plans[0].wait.type == WaitStrategyType::SPIN_YIELD);
+                CHECK(plans[0].wait.spin_count == 20000);
+                CHECK(plans[0].wait.park_timeout == std::chrono::microseconds(100));
+
+                //A worker with one symbol takes its config unchanged
+                plans = pascal::net::plan_workers({4, 5, 6}, {1, 2, 3}, waitConfigs);
+                REQUIRE(plans.size() == 3);
+                CHECK(plans[1].wait.type == WaitStrategyType::SPIN_YIELD);
+                CHECK(plans[1].wait.spin_count == 50);
+                CHECK(plans[1].wait.park_timeout == std::chrono::microseconds(2000));
+            }
+            SECTION("More cores than symbols start one worker per symbol") {
+                auto plans = pascal::net::plan_workers({1, 2, 3, 4, 5}, {1, 2}, waitConfigs);
+                REQUIRE(plans.size() == 2);
+                CHECK(plans[0].core_id == 1);
+                CHECK(plans[1].core_id == 2);
+                CHECK(plans[0].symbols.size() == 1);
+                CHECK(plans[1].symbols.size() == 1);
+            }
+            SECTION("Listing a core twice puts two workers on it") {
+                auto plans = pascal::net::plan_workers({3, 3}, {1, 2}, waitConfigs);
+                REQUIRE(plans.size() == 2);
+                CHECK(plans[0].core_id == 3);
+                CHECK(plans[1].core_id == 3);
+            }
+            SECTION("No symbols, no workers") {
+                CHECK(pascal::net::plan_workers({1, 2}, {}, waitConfigs).empty());
+                CHECK(pascal::net::plan_workers({}, {}, waitConfigs).empty());
+            }
+            SECTION("Symbols need a core") {
+                CHECK_THROWS_AS(pascal::net::plan_workers({}, {1}, waitConfigs), std::invalid_argument);
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#include "catch2/catch_test_macros.hpp"
+#include "common/epoch_domain.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace pascal {
+    namespace test {
+        TEST_CASE("Epoch Domain - Retired objects outlive the readers that may hold them", "[epoch_domain]") {
+            pascal::common::EpochDomain domain;
+            std::weak_ptr<int> first;
+            {
+                auto object = std::make_shared<int>(1);
+                first = object;
+                domain.retire(std::move(object));
+            }
+            CHECK(domain.get_retired() == 1);
+
+            //Nobody reads, it goes right away
+            CHECK(domain.reclaim() == 1);
+            CHECK(first.expired());
+
+            std::weak_ptr<int> second;
+            {
+                pascal::common::EpochDomain::Guard guard(domain);
+                {
+                    //Nested guards keep the outer pin
+                    pascal::common::EpochDomain::Guard inner(domain);
+                }
+                auto object = std::make_shared<int>(2);
+                second = object;
+                domain.retire(std::move(object));
+                CHECK(domain.reclaim() == 0);
+                CHECK_FALSE(second.expired());
+            }
+            CHECK(domain.reclaim() == 1);
+            CHECK(second.expired());
+        }
+        TEST_CASE("Epoch Domain - Readers pinned after a retirement don't hold it back", "[epoch_domain]") {
+            pascal::common::EpochDomain domain;
+            std::atomic<int> stage{0};
+            std::thread reader([&]() {
+                pascal::common::EpochDomain::Guard guard(domain);
+                stage.store(1);
+                while (stage.load() != 2) {}
+            });
+            while (stage.load() != 1) {}
+
+            //The other thread pinned before this retirement
+            domain.retire(std::make_shared<int>(1));
+            CHECK(domain.reclaim() == 0);
+            {
+                //This thread pins after it, and only holds back later ones
+                pascal::common::EpochDomain::Guard guard(domain);
+                domain.retire(std::make_shared<int>(2));
+                CHECK(domain.reclaim() == 0);
+            }
+            stage.store(2);
+            reader.join();
+            CHECK(domain.reclaim() == 2);
+            CHECK(domain.get_retired() == 0);
+        }
+        TEST_CASE("Epoch Domain - Reader slots of exited threads are reused", "[epoch_domain]") {
+            pascal::common::EpochDomain domain;
+            size_t highest = 0;
+            for (size_t i = 0; i < 4*pascal::common::EpochDomain::MAX_READERS; i++) {
+                size_t index = SIZE_MAX;
+                bool held = false;
+                std::thread reader([&]() {
+                    pascal::common::EpochDomain::Guard guard(domain);
+                    index = pascal::common::thread_index();
+                    domain.retire(std::make_shared<int>(1));
+                    held = domain.reclaim() == 0;
+                });
+                reader.join();
+                highest = std::max(highest, index);
+                CHECK(held);
+                //The slot was released with its pin, nothing is held back
+                CHECK(domain.reclaim() == 1);
+            }
+            //One thread at a time, however many came before, only ever needs the lowest few slots
+            CHECK(highest < pascal::common::EpochDomain::MAX_READERS);
+        }
+    }
+}
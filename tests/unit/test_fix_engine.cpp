@@ -1,6 +1,8 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/catch_approx.hpp"
+#include "catch2/generators/catch_generators.hpp"
 #include "net/fix_engine.h"
+#include "market_data/pipeline.h"
 #include <thread>
 #include <vector>
 #include "quickfix/fix44/MarketDataIncrementalRefresh.h"
@@ -9,9 +11,61 @@
 #include <chrono>
 #include <string>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
 
 namespace pascal {
     namespace test {
+        //Initiator settings for tests that never log on, nothing listens on the port
+        std::string write_offline_config() {
+            std::filesystem::path dir = std::filesystem::temp_directory_path() / "pascal_offline_engine";
+            std::filesystem::create_directories(dir);
+            std::ofstream config(dir / "engine.cfg");
+            config << "[DEFAULT]\nConnectionType=initiator\nReconnectInterval=60\n"
+                   << "FileStorePath=" << (dir / "store").string() << "\nFileLogPath=" << (dir / "log").string() << "\n"
+                   << "SocketConnectHost=127.0.0.1\nSocketConnectPort=1\nHeartBtInt=10\nUseDataDictionary=N\n"
+                   << "[SESSION]\nBeginString=FIX.4.4\nSenderCompID=PASCAL_MD\nTargetCompID=SPOT\n"
+                   << "StartTime=00:00:00\nEndTime=00:00:00\n";
+            return (dir / "engine.cfg").string();
+        }
+
+        TEST_CASE("FIX Engine - Instrument specs reach the parser", "[fix_engine]") {
+            //Received messages go through the ring and the worker's raw decode into a book on the instrument's grid
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            pascal::common::InstrumentSpec spec = pascal::common::InstrumentSpec::from_increments(0.01, 0.00001);
+            pascal::market_data::FIXOrderBookManager manager;
+            manager.add_symbol("SPECUSDT", spec, type);
+            std::vector<std::string> tradedSymbols = {"SPECUSDT"};
+            pascal::net::BasicFIXMarketDataEngine<pascal::market_data::BookUpdateStage> engine(write_offline_config(), "", "OFFLINE", tradedSymbols,
+                pascal::market_data::BookUpdateStage(manager));
+            engine.set_instrument_spec("SPECUSDT", spec);
+            REQUIRE(engine.start());
+
+            FIX44::MarketDataSnapshotFullRefresh snapshot;
+            snapshot.setField(FIX::Symbol("SPECUSDT"));
+            FIX44::MarketDataSnapshotFullRefresh::NoMDEntries bid;
+            bid.setField(FIX::MDEntryType('0'));
+            bid.setField(FIX::MDEntryPx(2500.37));
+            bid.setField(FIX::MDEntrySize(1.23456));
+            snapshot.addGroup(bid);
+            FIX44::MarketDataSnapshotFullRefresh::NoMDEntries ask;
+            ask.setField(FIX::MDEntryType('1'));
+            ask.setField(FIX::MDEntryPx(2500.38));
+            ask.setField(FIX::MDEntrySize(0.5));
+            snapshot.addGroup(ask);
+            engine.fromApp(snapshot, FIX::SessionID());
+
+            auto book = manager.get_book_by_symbol("SPECUSDT");
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (book->get_best_ask().Price == 0 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            engine.stop();
+            CHECK(book->get_best_bid().Price == spec.to_ticks(2500.37));
+            CHECK(book->get_best_bid().Quantity == spec.to_lots(1.23456));
+            CHECK(book->get_best_ask().Price == spec.to_ticks(2500.38));
+            CHECK(book->get_best_ask().Quantity == spec.to_lots(0.5));
+        }
         TEST_CASE("FIX Engine - Application lifecycle", "[fix_engine]") {
             SECTION("Test session start and logon") {
                 std::string fixConfig = std::string(std::getenv("BINANCE_FIX_CONFIG"));
@@ -48,7 +102,7 @@ namespace pascal {
                 int bidSize = 0;
                 int askSize = -1;
                 engine.register_parser_callback([&symbol, &bidSize, &askSize](const pascal::common::MarketDataSnapshot& snapshot) {
-                    symbol = snapshot.symbol;
+                    symbol = pascal::common::SymbolRegistry::instance().name(snapshot.symbol_id);
                     bidSize = snapshot.bids.size();
                     askSize = snapshot.asks.size();
                 });
@@ -79,7 +133,7 @@ namespace pascal {
                     //empty function
                 });
                 engine.register_parser_callback([&symbol](const pascal::common::MarketDataIncrement& increment) {
-                    symbol = increment.symbol;
+                    symbol = pascal::common::SymbolRegistry::instance().name(increment.symbol_id);
                 });
                 engine.sub_to_symbol(req);
                 std::this_thread::sleep_for(std::chrono::milliseconds(150));
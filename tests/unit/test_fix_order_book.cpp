@@ -1,6 +1,9 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/catch_approx.hpp"
+#include "catch2/generators/catch_generators.hpp"
 #include "market_data/fix_order_book.h"
+#include "market_data/fix_ladder_order_book.h"
+#include "market_data/synthetic_feed.h"
 #include <thread>
 #include <vector>
 #include "quickfix/fix44/MarketDataIncrementalRefresh.h"
@@ -9,6 +12,9 @@
 #include <chrono>
 #include <string>
 #include <iostream>
+#include <random>
+#include <array>
+#include <atomic>
 
 namespace pascal {
     namespace test {
@@ -16,18 +22,34 @@ namespace pascal {
         class FIXOrderBookTestFeature {
         public:
             pascal::market_data::FIXOrderBookManager manager;
+            pascal::common::InstrumentSpec spec = pascal::common::InstrumentSpec::from_increments(0.01, 0.00001);
 
-            FIXOrderBookTestFeature() {
-                manager.add_symbol("BTCUSDT");
+            FIXOrderBookTestFeature(pascal::market_data::BookType type = pascal::market_data::BookType::VECTOR) {
+                manager.add_symbol("BTCUSDT", spec, type);
             }
 
+            pascal::common::PriceLevel level(double price, double qty) const {
+                return pascal::common::PriceLevel{.Price = spec.to_ticks(price), .Quantity = spec.to_lots(qty)};
+            }
+            pascal::common::Ticks px(double price) const {
+                return spec.to_ticks(price);
+            }
+            pascal::common::Lots qty(double quantity) const {
+                return spec.to_lots(quantity);
+            }
+
+            pascal::common::MarketDataSnapshot create_test_snapshot(const std::string& symbol = "BTCUSDT") {
+                return create_test_snapshot(symbol,
+                    {level(50000.5, 1.0), level(51000.1, 2.0), level(47005.6, 1.4)},
+                    {level(51000.5, 1.0), level(48005.1, 2.0), level(50005.6, 1.4)});
+            }
             pascal::common::MarketDataSnapshot create_test_snapshot(
-                const std::string& symbol = "BTCUSDT",
-                std::vector<pascal::common::PriceLevel> bids = {{50000.5, 1.0}, {51000.1, 2.0}, {47005.6, 1.4}},
-                std::vector<pascal::common::PriceLevel> asks = {{51000.5, 1.0}, {48005.1, 2.0}, {50005.6, 1.4}}
+                const std::string& symbol,
+                std::vector<pascal::common::PriceLevel> bids,
+                std::vector<pascal::common::PriceLevel> asks
             ) {
                 auto recv_time = std::chrono::high_resolution_clock::now();
-                return pascal::common::MarketDataSnapshot{.symbol = symbol, .bids = bids, .asks = asks, .recv_time = recv_time};
+                return pascal::common::MarketDataSnapshot{.symbol_id = pascal::common::SymbolRegistry::instance().find(symbol), .bids = bids, .asks = asks, .recv_time = recv_time};
             }
 
             pascal::common::MarketDataIncrement create_test_increment(
@@ -39,7 +61,7 @@ namespace pascal {
             {
                 auto recv_time = std::chrono::high_resolution_clock::now();
                 pascal::common::MarketDataIncrement increment;
-                increment.symbol = symbol;
+                increment.symbol_id = pascal::common::SymbolRegistry::instance().find(symbol);
                 increment.md_entries.push_back(pascal::common::MarketDataEntry{.side = side, .priceLevel = priceLevel, .update_action = update_action});
                 increment.recv_time = recv_time;
                 increment.marketDepth = 1;
@@ -52,8 +74,8 @@ namespace pascal {
             {
                 auto recv_time = std::chrono::high_resolution_clock::now();
                 pascal::common::MarketDataIncrement increment;
-                increment.symbol = symbol;
-                increment.md_entries = md_entries;
+                increment.symbol_id = pascal::common::SymbolRegistry::instance().find(symbol);
+                increment.md_entries.assign(md_entries.begin(), md_entries.end());
                 increment.recv_time = recv_time;
                 increment.marketDepth = md_entries.size();
                 return increment;
@@ -61,7 +83,8 @@ namespace pascal {
         };
 
         TEST_CASE("FIX Order Book - Initialize from Snapshot", "[fix_order_book]") {
-            FIXOrderBookTestFeature feature;
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            FIXOrderBookTestFeature feature(type);
             SECTION("Initialize from snapshot") {
                 auto snapshot = feature.create_test_snapshot();
                 feature.manager.process_snapshot(snapshot);
@@ -70,100 +93,114 @@ namespace pascal {
 
                 CHECK(book->get_total_bid_levels() == 3);
                 CHECK(book->get_total_ask_levels() == 3);
-                CHECK(book->get_best_bid().Price == 51000.1);
-                CHECK(book->get_best_bid().Quantity == 2.0);
-                CHECK(book->get_best_ask().Price == 48005.1);
-                CHECK(book->get_best_ask().Quantity == 2.0);
-                CHECK(book->get_bid_quantity_at_price(47005.6) == 1.4);
-                CHECK(book->get_ask_quantity_at_price(51000.5) == 1.0);
+                CHECK(book->get_best_bid().Price == feature.px(51000.1));
+                CHECK(book->get_best_bid().Quantity == feature.qty(2.0));
+                CHECK(book->get_best_ask().Price == feature.px(48005.1));
+                CHECK(book->get_best_ask().Quantity == feature.qty(2.0));
+                CHECK(book->get_bid_quantity_at_price(feature.px(47005.6)) == feature.qty(1.4));
+                CHECK(book->get_ask_quantity_at_price(feature.px(51000.5)) == feature.qty(1.0));
+            }
+            SECTION("Display conversion at the API edge") {
+                auto snapshot = feature.create_test_snapshot();
+                feature.manager.process_snapshot(snapshot);
+
+                auto book = feature.manager.get_book_by_symbol("BTCUSDT");
+                const auto& spec = book->get_instrument_spec();
+
+                CHECK(book->get_best_bid().Price == 5100010);
+                CHECK(book->get_best_bid().Quantity == 200000);
+                CHECK(spec.to_price(book->get_best_bid().Price) == Catch::Approx(51000.1));
+                CHECK(spec.to_quantity(book->get_best_bid().Quantity) == Catch::Approx(2.0));
             }
         }
         
         TEST_CASE("FIX Order Book - Update from Increment", "[fix_order_book]") {
-            FIXOrderBookTestFeature feature;
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            FIXOrderBookTestFeature feature(type);
             auto snapshot = feature.create_test_snapshot();
             feature.manager.process_snapshot(snapshot);
             SECTION("Apply bid") {
-                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::NEW, pascal::common::PriceLevel{51000.1, 3.2});
+                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::NEW, feature.level(51000.1, 3.2));
                 
                 feature.manager.process_increment(increment);
                 auto book = feature.manager.get_book_by_symbol("BTCUSDT");
 
                 CHECK(book->get_total_bid_levels() == 3);
-                CHECK(book->get_best_bid().Price == 51000.1);
-                CHECK(book->get_best_bid().Quantity == 5.2);
+                CHECK(book->get_best_bid().Price == feature.px(51000.1));
+                CHECK(book->get_best_bid().Quantity == feature.qty(5.2));
                 CHECK(book->get_total_ask_levels() == 3);
             }
             SECTION("Apply ask") {
-                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::OFFER, pascal::common::UpdateAction::NEW, pascal::common::PriceLevel{48005.1, 3.2});
+                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::OFFER, pascal::common::UpdateAction::NEW, feature.level(48005.1, 3.2));
 
                 feature.manager.process_increment(increment);
                 auto book = feature.manager.get_book_by_symbol("BTCUSDT");
 
                 CHECK(book->get_total_ask_levels() == 3);
-                CHECK(book->get_best_ask().Price == 48005.1);
-                CHECK(book->get_best_ask().Quantity == 5.2);
+                CHECK(book->get_best_ask().Price == feature.px(48005.1));
+                CHECK(book->get_best_ask().Quantity == feature.qty(5.2));
                 CHECK(book->get_total_bid_levels() == 3);
             }
             SECTION("Change bid") {
-                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::CHANGE, pascal::common::PriceLevel{51000.1, 3.2});
+                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::CHANGE, feature.level(51000.1, 3.2));
 
                 feature.manager.process_increment(increment);
                 auto book = feature.manager.get_book_by_symbol("BTCUSDT");
 
                 CHECK(book->get_total_bid_levels() == 3);
-                CHECK(book->get_best_bid().Price == 51000.1);
-                CHECK(book->get_best_bid().Quantity == 3.2);
+                CHECK(book->get_best_bid().Price == feature.px(51000.1));
+                CHECK(book->get_best_bid().Quantity == feature.qty(3.2));
                 CHECK(book->get_total_ask_levels() == 3);
             }
             SECTION("Change ask") {
-                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::OFFER, pascal::common::UpdateAction::CHANGE, pascal::common::PriceLevel{48005.1, 3.2});
+                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::OFFER, pascal::common::UpdateAction::CHANGE, feature.level(48005.1, 3.2));
 
                 feature.manager.process_increment(increment);
                 auto book = feature.manager.get_book_by_symbol("BTCUSDT");
 
                 CHECK(book->get_total_ask_levels() == 3);
-                CHECK(book->get_best_ask().Price == 48005.1);
-                CHECK(book->get_best_ask().Quantity == 3.2);
+                CHECK(book->get_best_ask().Price == feature.px(48005.1));
+                CHECK(book->get_best_ask().Quantity == feature.qty(3.2));
                 CHECK(book->get_total_bid_levels() == 3);
             }
             SECTION("Delete bid") {
-                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::DELETE, pascal::common::PriceLevel{51000.1, 1.4});
+                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::DELETE, feature.level(51000.1, 1.4));
 
                 feature.manager.process_increment(increment);
                 auto book = feature.manager.get_book_by_symbol("BTCUSDT");
 
                 CHECK(book->get_total_bid_levels() == 3);
-                CHECK(book->get_best_bid().Price == 51000.1);
-                CHECK(book->get_best_bid().Quantity == Catch::Approx(0.6));
+                CHECK(book->get_best_bid().Price == feature.px(51000.1));
+                CHECK(book->get_best_bid().Quantity == feature.qty(0.6));
                 CHECK(book->get_total_ask_levels() == 3);
             }
             SECTION("Delete ask") {
-                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::OFFER, pascal::common::UpdateAction::DELETE, pascal::common::PriceLevel{48005.1, 1.4});
+                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::OFFER, pascal::common::UpdateAction::DELETE, feature.level(48005.1, 1.4));
 
                 feature.manager.process_increment(increment);
                 auto book = feature.manager.get_book_by_symbol("BTCUSDT");
 
                 CHECK(book->get_total_ask_levels() == 3);
-                CHECK(book->get_best_ask().Price == 48005.1);
-                CHECK(book->get_best_ask().Quantity == Catch::Approx(0.6));
+                CHECK(book->get_best_ask().Price == feature.px(48005.1));
+                CHECK(book->get_best_ask().Quantity == feature.qty(0.6));
                 CHECK(book->get_total_bid_levels() == 3);
             }
         }
         TEST_CASE("FIX Order Book - Update from Multiple Increment", "[fix_order_book]") {
-            FIXOrderBookTestFeature feature;
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            FIXOrderBookTestFeature feature(type);
             auto snapshot = feature.create_test_snapshot();
             feature.manager.process_snapshot(snapshot);
             pascal::common::MarketDataEntry e1, e2, e3;
             e2.side = pascal::common::Side::BID;
             e2.update_action = pascal::common::UpdateAction::NEW;
-            e2.priceLevel = {52000.1, 3.2};
+            e2.priceLevel = feature.level(52000.1, 3.2);
             e1.side = pascal::common::Side::OFFER;
             e1.update_action = pascal::common::UpdateAction::CHANGE;
-            e1.priceLevel = {48005.1, 3.2};
+            e1.priceLevel = feature.level(48005.1, 3.2);
             e3.side = pascal::common::Side::BID;
             e3.update_action = pascal::common::UpdateAction::DELETE;
-            e3.priceLevel = {51000.1, 2.0};
+            e3.priceLevel = feature.level(51000.1, 2.0);
             SECTION("Apply increments") {
                 auto increment = feature.create_test_increments("BTCUSDT", {e1, e2, e3});
                 
@@ -171,12 +208,441 @@ namespace pascal {
                 auto book = feature.manager.get_book_by_symbol("BTCUSDT");
 
                 CHECK(book->get_total_bid_levels() == 3);
-                CHECK(book->get_best_bid().Price == 52000.1);
-                CHECK(book->get_best_bid().Quantity == 3.2);
+                CHECK(book->get_best_bid().Price == feature.px(52000.1));
+                CHECK(book->get_best_bid().Quantity == feature.qty(3.2));
                 CHECK(book->get_total_ask_levels() == 3);
-                CHECK(book->get_best_ask().Price == 48005.1);
-                CHECK(book->get_best_ask().Quantity == 3.2);
+                CHECK(book->get_best_ask().Price == feature.px(48005.1));
+                CHECK(book->get_best_ask().Quantity == feature.qty(3.2));
+            }
+            SECTION("Unordered entries and repeated prices merge in message order") {
+                using pascal::common::Side;
+                using pascal::common::UpdateAction;
+                auto entry = [&feature](Side side, UpdateAction action, double price, double qty) {
+                    return pascal::common::MarketDataEntry{.side = side, .priceLevel = feature.level(price, qty), .update_action = action};
+                };
+                auto increment = feature.create_test_increments("BTCUSDT", {
+                    entry(Side::BID, UpdateAction::NEW, 46000.0, 1.0),
+                    entry(Side::OFFER, UpdateAction::DELETE, 50005.6, 1.4),
+                    entry(Side::BID, UpdateAction::NEW, 49000.0, 0.5),
+                    entry(Side::BID, UpdateAction::NEW, 46000.0, 0.25),
+                    entry(Side::BID, UpdateAction::CHANGE, 50000.5, 4.0),
+                    entry(Side::OFFER, UpdateAction::NEW, 49000.5, 0.7),
+                    entry(Side::BID, UpdateAction::DELETE, 49000.0, 0.5),
+                    entry(Side::BID, UpdateAction::NEW, 49000.0, 0.3),
+                    entry(Side::OFFER, UpdateAction::DELETE, 61000.0, 1.0)  //not in the book
+                });
+
+                auto book = feature.manager.get_book_by_symbol("BTCUSDT");
+                uint64_t version = book->get_version();
+                feature.manager.process_increment(increment);
+                CHECK(book->get_version() == version + 2); //one write for the whole message
+
+                auto bids = book->get_bids(10);
+                REQUIRE(bids.size() == 5);
+                CHECK(bids[0].Price == feature.px(51000.1));
+                CHECK(bids[1].Price == feature.px(50000.5));
+                CHECK(bids[1].Quantity == feature.qty(4.0));
+                CHECK(bids[2].Price == feature.px(49000.0));
+                CHECK(bids[2].Quantity == feature.qty(0.3));
+                CHECK(bids[3].Price == feature.px(47005.6));
+                CHECK(bids[4].Price == feature.px(46000.0));
+                CHECK(bids[4].Quantity == feature.qty(1.25));
+                auto asks = book->get_asks(10);
+                REQUIRE(asks.size() == 3);
+                CHECK(asks[0].Price == feature.px(48005.1));
+                CHECK(asks[1].Price == feature.px(49000.5));
+                CHECK(asks[1].Quantity == feature.qty(0.7));
+                CHECK(asks[2].Price == feature.px(51000.5));
+            }
+        }
+        TEST_CASE("FIX Order Book - Sequence gap resynchronization", "[fix_order_book]") {
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            FIXOrderBookTestFeature feature(type);
+            std::vector<pascal::common::SymbolId> resyncs;
+            feature.manager.set_resync_handler([&resyncs](pascal::common::SymbolId id) {
+                resyncs.push_back(id);
+            });
+            auto change = [&feature](uint64_t first, uint64_t last, double qty) {
+                auto increment = feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::CHANGE, feature.level(51000.1, qty));
+                increment.first_update_id = first;
+                increment.last_update_id = last;
+                return increment;
+            };
+            auto snapshot = feature.create_test_snapshot();
+            snapshot.last_update_id = 100;
+            feature.manager.process_snapshot(snapshot);
+            auto book = feature.manager.get_book_by_symbol("BTCUSDT");
+            REQUIRE(book->is_synchronized());
+
+            SECTION("Contiguous and stale increments keep the book synchronized") {
+                feature.manager.process_increment(change(99, 100, 9.0)); //covered by the snapshot
+                feature.manager.process_increment(change(101, 102, 3.0));
+                feature.manager.process_increment(change(103, 103, 4.0));
+
+                CHECK(book->is_synchronized());
+                CHECK(book->get_best_bid().Quantity == feature.qty(4.0));
+                CHECK(feature.manager.get_total_sequence_gaps() == 0);
+                CHECK(resyncs.empty());
+            }
+            SECTION("A gap buffers increments until the snapshot lands") {
+                feature.manager.process_increment(change(101, 101, 3.0));
+                feature.manager.process_increment(change(103, 103, 5.0)); //102 lost
+                feature.manager.process_increment(change(104, 104, 6.0));
+
+                CHECK_FALSE(book->is_synchronized());
+                CHECK(book->get_best_bid().Quantity == feature.qty(3.0));
+                CHECK(feature.manager.get_total_sequence_gaps() == 1);
+                REQUIRE(resyncs.size() == 1);
+                CHECK(resyncs[0] == book->get_symbol_id());
+
+                //The snapshot covers up to 103, only 104 is replayed on top of it
+                auto fresh = feature.create_test_snapshot();
+                fresh.last_update_id = 103;
+                feature.manager.process_snapshot(fresh);
+
+                CHECK(book->is_synchronized());
+                CHECK(book->get_best_bid().Quantity == feature.qty(6.0));
+                feature.manager.process_increment(change(105, 105, 7.0));
+                CHECK(book->get_best_bid().Quantity == feature.qty(7.0));
+                CHECK(resyncs.size() == 1);
+            }
+            SECTION("A snapshot older than the buffered increments asks again") {
+                feature.manager.process_increment(change(105, 105, 5.0));
+                REQUIRE(resyncs.size() == 1);
+
+                auto stale = feature.create_test_snapshot();
+                stale.last_update_id = 102;
+                feature.manager.process_snapshot(stale);
+
+                CHECK_FALSE(book->is_synchronized());
+                CHECK(resyncs.size() == 2);
+                CHECK(feature.manager.get_total_sequence_gaps() == 2);
+            }
+            SECTION("Increments without ids are applied as they come") {
+                feature.manager.process_increment(change(0, 0, 8.0));
+
+                CHECK(book->is_synchronized());
+                CHECK(book->get_best_bid().Quantity == feature.qty(8.0));
+                CHECK(resyncs.empty());
             }
         }
+
+        TEST_CASE("FIX Order Book - Conflated consumers see the newest state", "[fix_order_book]") {
+            FIXOrderBookTestFeature feature;
+            auto eth = feature.manager.add_symbol("ETHUSDT", feature.spec);
+            auto btc = pascal::common::SymbolRegistry::instance().find("BTCUSDT");
+            feature.manager.set_conflation(true);
+            auto snapshot = feature.create_test_snapshot();
+            feature.manager.process_snapshot(snapshot);
+            for (int i = 1; i <= 5; i++) {
+                feature.manager.process_increment(feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::CHANGE, feature.level(51000.1, i)));
+            }
+
+            std::vector<pascal::common::SymbolId> pulled;
+            size_t delivered = feature.manager.drain_conflated([&](pascal::common::SymbolId id, const pascal::market_data::OrderBook& book) {
+                pulled.push_back(id);
+                CHECK(book.get_best_bid().Quantity == feature.qty(5.0));
+            });
+            CHECK(delivered == 1);
+            REQUIRE(pulled.size() == 1);
+            CHECK(pulled[0] == btc);
+            CHECK(feature.manager.get_conflated_updates() == 5);
+            CHECK(feature.manager.get_conflated_updates(btc) == 5);
+            CHECK(feature.manager.get_conflated_updates(eth) == 0);
+
+            //Nothing new since the pull
+            CHECK(feature.manager.drain_conflated([](pascal::common::SymbolId, const pascal::market_data::OrderBook&) {}) == 0);
+            CHECK_FALSE(feature.manager.take_conflated(btc));
+
+            auto ethSnapshot = feature.create_test_snapshot("ETHUSDT");
+            feature.manager.process_snapshot(ethSnapshot);
+            CHECK_FALSE(feature.manager.take_conflated(btc));
+            CHECK(feature.manager.take_conflated(eth));
+            CHECK_FALSE(feature.manager.take_conflated(eth));
+            CHECK(feature.manager.get_conflation_deliveries() == 2);
+        }
+
+        TEST_CASE("FIX Ladder Order Book - Matches vector book", "[fix_order_book]") {
+            //Small window so the sequence crosses it and exercises far levels and recentring
+            pascal::common::InstrumentSpec spec = pascal::common::InstrumentSpec::from_increments(0.01, 0.00001);
+            pascal::market_data::FIXOrderBook vectorBook("BTCUSDT", spec);
+            pascal::market_data::FIXLadderOrderBook ladderBook("BTCUSDT", spec, 4096);
+
+            std::vector<pascal::common::PriceLevel> bids, asks;
+            for (int i = 0; i < 50; i++) {
+                bids.push_back({.Price = 5000000 - i*7, .Quantity = 1000 + i});
+                asks.push_back({.Price = 5000010 + i*7, .Quantity = 2000 + i});
+            }
+            pascal::common::MarketDataSnapshot s1{.symbol_id = vectorBook.get_symbol_id(), .bids = bids, .asks = asks, .recv_time = {}};
+            pascal::common::MarketDataSnapshot s2 = s1;
+            vectorBook.initialize_from_snapshot(s1);
+            ladderBook.initialize_from_snapshot(s2);
+
+            std::mt19937 rng(42);
+            pascal::common::Ticks mid = 5000005;
+            for (int n = 0; n < 5000; n++) {
+                //Drift the touch upwards so the ladder has to move its window
+                mid += static_cast<int>(rng() % 61) - 28;
+                for (int e = 0; e < 4; e++) {
+                    bool bid = rng() % 2;
+                    auto side = bid ? pascal::common::Side::BID : pascal::common::Side::OFFER;
+                    pascal::common::Ticks offset = 1 + rng() % 6000;
+                    pascal::common::Ticks price = bid ? mid - offset : mid + offset;
+                    pascal::common::Lots existing = bid ? vectorBook.get_bid_quantity_at_price(price) : vectorBook.get_ask_quantity_at_price(price);
+                    pascal::common::Lots qty = 1 + rng() % 500;
+
+                    //CHANGE and DELETE only target levels that exist, as a real feed does
+                    auto action = pascal::common::UpdateAction::NEW;
+                    if (existing > 0) {
+                        int r = rng() % 3;
+                        if (r == 1) action = pascal::common::UpdateAction::CHANGE;
+                        else if (r == 2) {
+                            action = pascal::common::UpdateAction::DELETE;
+                            qty = existing;
+                        }
+                    }
+                    //Applied entry by entry so the existence check above stays valid, depth > 1 selects full book semantics
+                    pascal::common::MarketDataIncrement update;
+                    update.symbol_id = vectorBook.get_symbol_id();
+                    update.md_entries.push_back({.side = side, .priceLevel = {.Price = price, .Quantity = qty}, .update_action = action});
+                    update.marketDepth = 2;
+                    vectorBook.update_from_increment(update);
+                    ladderBook.update_from_increment(update);
+                }
+
+                REQUIRE(ladderBook.get_total_bid_levels() == vectorBook.get_total_bid_levels());
+                REQUIRE(ladderBook.get_total_ask_levels() == vectorBook.get_total_ask_levels());
+                if (vectorBook.get_total_bid_levels()) {
+                    REQUIRE(ladderBook.get_best_bid().Price == vectorBook.get_best_bid().Price);
+                    REQUIRE(ladderBook.get_best_bid().Quantity == vectorBook.get_best_bid().Quantity);
+                }
+                if (vectorBook.get_total_ask_levels()) {
+                    REQUIRE(ladderBook.get_best_ask().Price == vectorBook.get_best_ask().Price);
+                    REQUIRE(ladderBook.get_best_ask().Quantity == vectorBook.get_best_ask().Quantity);
+                }
+            }
+
+            //Depth queries walk the window and then the far levels in price order
+            auto ladderBids = ladderBook.get_bids(40);
+            for (size_t i = 1; i < ladderBids.size(); i++) {
+                CHECK(ladderBids[i].Price < ladderBids[i-1].Price);
+                CHECK(vectorBook.get_bid_quantity_at_price(ladderBids[i].Price) == ladderBids[i].Quantity);
+            }
+            auto ladderAsks = ladderBook.get_asks(40);
+            for (size_t i = 1; i < ladderAsks.size(); i++) {
+                CHECK(ladderAsks[i].Price > ladderAsks[i-1].Price);
+                CHECK(vectorBook.get_ask_quantity_at_price(ladderAsks[i].Price) == ladderAsks[i].Quantity);
+            }
+            CHECK(ladderBook.get_total_recenters() > 0);
+        }
+        TEST_CASE("FIX Ladder Order Book - Far levels are capped", "[fix_order_book]") {
+            pascal::common::InstrumentSpec spec = pascal::common::InstrumentSpec::from_increments(0.01, 0.00001);
+            pascal::market_data::FIXLadderOrderBook ladderBook("BTCUSDT", spec, 4096);
+            pascal::common::MarketDataSnapshot snapshot{.symbol_id = ladderBook.get_symbol_id(), .bids = {{.Price = 5000000, .Quantity = 1}}, .asks = {{.Price = 5000010, .Quantity = 1}}, .recv_time = {}};
+            ladderBook.initialize_from_snapshot(snapshot);
+
+            //Deep bids far below the window, more than the far storage holds
+            const pascal::common::Ticks deepest = 4000000;
+            const size_t extra = 10;
+            for (size_t i = 0; i < pascal::market_data::FIXLadderOrderBook::MAX_FAR_LEVELS + extra; i++) {
+                pascal::common::MarketDataIncrement update;
+                update.symbol_id = ladderBook.get_symbol_id();
+                update.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = deepest + static_cast<pascal::common::Ticks>(i), .Quantity = 1}, .update_action = pascal::common::UpdateAction::NEW});
+                update.marketDepth = 2;
+                ladderBook.update_from_increment(update);
+            }
+            CHECK(ladderBook.get_total_bid_levels() == pascal::market_data::FIXLadderOrderBook::MAX_FAR_LEVELS + 1);
+            //The worst levels made room for better ones
+            CHECK(ladderBook.get_bid_quantity_at_price(deepest) == 0);
+            CHECK(ladderBook.get_bid_quantity_at_price(deepest + extra) == 1);
+            CHECK(ladderBook.get_best_bid().Price == 5000000);
+
+            //A level worse than every far one is refused
+            pascal::common::MarketDataIncrement worse;
+            worse.symbol_id = ladderBook.get_symbol_id();
+            worse.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = deepest - 1, .Quantity = 1}, .update_action = pascal::common::UpdateAction::NEW});
+            worse.marketDepth = 2;
+            ladderBook.update_from_increment(worse);
+            CHECK(ladderBook.get_bid_quantity_at_price(deepest - 1) == 0);
+            CHECK(ladderBook.get_total_bid_levels() == pascal::market_data::FIXLadderOrderBook::MAX_FAR_LEVELS + 1);
+        }
+        TEST_CASE("FIX Order Book - Top of book entries before a snapshot", "[fix_order_book]") {
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            FIXOrderBookTestFeature feature(type);
+            auto book = feature.manager.get_book_by_symbol("BTCUSDT");
+
+            //An empty side takes the entry as its first level, a delete has nothing to act on
+            feature.manager.process_increment(feature.create_test_increment("BTCUSDT", pascal::common::Side::OFFER, pascal::common::UpdateAction::DELETE, feature.level(50001.0, 1.0)));
+            CHECK(book->get_total_ask_levels() == 0);
+            feature.manager.process_increment(feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::NEW, feature.level(50000.0, 1.0)));
+            feature.manager.process_increment(feature.create_test_increment("BTCUSDT", pascal::common::Side::OFFER, pascal::common::UpdateAction::CHANGE, feature.level(50001.0, 2.0)));
+            CHECK(book->get_best_bid().Price == feature.px(50000.0));
+            CHECK(book->get_best_bid().Quantity == feature.qty(1.0));
+            CHECK(book->get_best_ask().Price == feature.px(50001.0));
+            CHECK(book->get_best_ask().Quantity == feature.qty(2.0));
+            CHECK(book->get_total_bid_levels() == 1);
+            CHECK(book->get_total_ask_levels() == 1);
+        }
+        TEST_CASE("FIX Order Book - Sides are capped at MAX_ORDERS", "[fix_order_book]") {
+            FIXOrderBookTestFeature feature;
+            auto book = feature.manager.get_book_by_symbol("BTCUSDT");
+            std::vector<pascal::common::PriceLevel> bids, asks;
+            for (int i = 0; i < MAX_ORDERS + 5; i++) {
+                bids.push_back({.Price = 5000000 - i, .Quantity = 1});
+                asks.push_back({.Price = 5000010 + i, .Quantity = 1});
+            }
+            auto snapshot = feature.create_test_snapshot("BTCUSDT", bids, asks);
+            feature.manager.process_snapshot(snapshot);
+
+            //The snapshot keeps its best MAX_ORDERS levels
+            CHECK(book->get_total_bid_levels() == MAX_ORDERS);
+            CHECK(book->get_total_ask_levels() == MAX_ORDERS);
+            CHECK(book->get_best_bid().Price == 5000000);
+            CHECK(book->get_best_ask().Price == 5000010);
+            CHECK(book->get_bid_quantity_at_price(5000000 - (MAX_ORDERS - 1)) == 1);
+            CHECK(book->get_bid_quantity_at_price(5000000 - MAX_ORDERS) == 0);
+
+            //New levels inside the book displace the worst ones
+            feature.manager.process_increment(feature.create_test_increments("BTCUSDT", {
+                {.side = pascal::common::Side::BID, .priceLevel = {.Price = 5000001, .Quantity = 2}, .update_action = pascal::common::UpdateAction::NEW},
+                {.side = pascal::common::Side::BID, .priceLevel = {.Price = 5000002, .Quantity = 3}, .update_action = pascal::common::UpdateAction::NEW},
+                {.side = pascal::common::Side::OFFER, .priceLevel = {.Price = 5000009, .Quantity = 4}, .update_action = pascal::common::UpdateAction::NEW}
+            }));
+            CHECK(book->get_total_bid_levels() == MAX_ORDERS);
+            CHECK(book->get_total_ask_levels() == MAX_ORDERS);
+            CHECK(book->get_best_bid().Price == 5000002);
+            CHECK(book->get_best_ask().Price == 5000009);
+            CHECK(book->get_bid_quantity_at_price(5000000 - (MAX_ORDERS - 3)) == 1);
+            CHECK(book->get_bid_quantity_at_price(5000000 - (MAX_ORDERS - 2)) == 0);
+            CHECK(book->get_ask_quantity_at_price(5000010 + (MAX_ORDERS - 2)) == 1);
+            CHECK(book->get_ask_quantity_at_price(5000010 + (MAX_ORDERS - 1)) == 0);
+
+            //So does a new touch on the top of book stream
+            feature.manager.process_increment(feature.create_test_increment("BTCUSDT", pascal::common::Side::BID, pascal::common::UpdateAction::NEW, {.Price = 5000003, .Quantity = 1}));
+            CHECK(book->get_total_bid_levels() == MAX_ORDERS);
+            CHECK(book->get_best_bid().Price == 5000003);
+        }
+        TEST_CASE("FIX Order Book - Follows a synthetic feed", "[fix_order_book]") {
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            auto profile = GENERATE(pascal::market_data::DepthProfile::GEOMETRIC, pascal::market_data::DepthProfile::UNIFORM);
+            FIXOrderBookTestFeature feature(type);
+            auto book = feature.manager.get_book_by_symbol("BTCUSDT");
+            pascal::market_data::SyntheticFeed feed(book->get_symbol_id(), 5000000, 50, profile, 7);
+
+            pascal::common::MarketDataSnapshot snapshot = feed.snapshot();
+            book->initialize_from_snapshot(snapshot);
+            pascal::common::MarketDataIncrement update;
+            for (int n = 1; n <= 20000; n++) {
+                feed.next_increment(update, 2);
+                book->update_from_increment(update);
+                if (n % 1000) continue;
+
+                //The book holds exactly what the feed generated, level for level
+                pascal::common::MarketDataSnapshot expected = feed.snapshot();
+                auto bids = book->get_bids(expected.bids.size() + 1);
+                auto asks = book->get_asks(expected.asks.size() + 1);
+                REQUIRE(bids.size() == expected.bids.size());
+                REQUIRE(asks.size() == expected.asks.size());
+                for (size_t i = 0; i < bids.size(); i++) {
+                    REQUIRE(bids[i].Price == expected.bids[i].Price);
+                    REQUIRE(bids[i].Quantity == expected.bids[i].Quantity);
+                }
+                for (size_t i = 0; i < asks.size(); i++) {
+                    REQUIRE(asks[i].Price == expected.asks[i].Price);
+                    REQUIRE(asks[i].Quantity == expected.asks[i].Quantity);
+                }
+            }
+        }
+        TEST_CASE("FIX Order Book - Concurrent readers see whole updates", "[fix_order_book]") {
+            auto type = GENERATE(pascal::market_data::BookType::VECTOR, pascal::market_data::BookType::LADDER);
+            FIXOrderBookTestFeature feature(type);
+            std::vector<pascal::common::PriceLevel> bids, asks;
+            for (int i = 0; i < 10; i++) {
+                bids.push_back({.Price = 5000000 - i, .Quantity = 1});
+                asks.push_back({.Price = 5000010 + i, .Quantity = 1});
+            }
+            auto snapshot = feature.create_test_snapshot("BTCUSDT", bids, asks);
+            feature.manager.process_snapshot(snapshot);
+            auto book = feature.manager.get_book_by_symbol("BTCUSDT");
+
+            //Every increment sets all ten bid levels to the same quantity, a torn read would mix two of them
+            std::atomic<bool> done{false};
+            std::thread writer([&]() {
+                for (pascal::common::Lots q = 2; q < 20000; q++) {
+                    std::vector<pascal::common::MarketDataEntry> entries;
+                    for (const auto& bid : bids) {
+                        entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = bid.Price, .Quantity = q}, .update_action = pascal::common::UpdateAction::CHANGE});
+                    }
+                    feature.manager.process_increment(feature.create_test_increments("BTCUSDT", entries));
+                }
+                done.store(true);
+            });
+
+            size_t torn = 0;
+            size_t reads = 0;
+            std::array<pascal::common::PriceLevel, 10> levels;
+            while (!done.load()) {
+                size_t n = book->get_bids(levels);
+                reads++;
+                if (n != levels.size()) {
+                    torn++;
+                    continue;
+                }
+                for (const auto& level : levels) {
+                    if (level.Quantity != levels[0].Quantity) {
+                        torn++;
+                        break;
+                    }
+                }
+            }
+            writer.join();
+
+            CHECK(reads > 0);
+            CHECK(torn == 0);
+            CHECK(book->get_bids(levels) == 10);
+            CHECK(levels[0].Quantity == 19999);
+            CHECK(book->get_bids(3).size() == 3);
+        }
+        TEST_CASE("FIX Order Book - Books are added and removed while messages flow", "[fix_order_book]") {
+            FIXOrderBookTestFeature feature;
+            std::vector<pascal::common::PriceLevel> bids = {{.Price = 5000000, .Quantity = 1}};
+            std::vector<pascal::common::PriceLevel> asks = {{.Price = 5000010, .Quantity = 1}};
+            auto snapshot = feature.create_test_snapshot("BTCUSDT", bids, asks);
+            feature.manager.process_snapshot(snapshot);
+
+            //The processing thread keeps updating BTCUSDT and the churned symbols while another thread swaps the table
+            std::atomic<bool> done{false};
+            std::thread churn([&]() {
+                for (int i = 0; i < 320; i++) {
+                    std::string symbol = "CHURN" + std::to_string(i % 4) + "USDT";
+                    if (i % 8 < 4) feature.manager.add_symbol(symbol, feature.spec);
+                    else feature.manager.remove_symbol(symbol);
+                }
+                done.store(true);
+            });
+            pascal::common::Lots q = 2;
+            while (!done.load()) {
+                feature.manager.process_increment(feature.create_test_increments("BTCUSDT", {
+                    {.side = pascal::common::Side::BID, .priceLevel = {.Price = 5000000, .Quantity = q++}, .update_action = pascal::common::UpdateAction::CHANGE}
+                }));
+                for (int i = 0; i < 4; i++) {
+                    feature.manager.process_increment(feature.create_test_increments("CHURN" + std::to_string(i) + "USDT", {
+                        {.side = pascal::common::Side::BID, .priceLevel = {.Price = 100, .Quantity = 1}, .update_action = pascal::common::UpdateAction::NEW}
+                    }));
+                }
+                CHECK(feature.manager.get_book_by_symbol("BTCUSDT") != nullptr);
+            }
+            churn.join();
+
+            CHECK(feature.manager.get_book_by_symbol("BTCUSDT")->get_best_bid().Quantity == q-1);
+            CHECK(feature.manager.get_total_books() == 1);
+            CHECK(feature.manager.get_symbols() == std::vector<std::string>{"BTCUSDT"});
+
+            //A caller holding a book keeps it past its removal
+            auto book = feature.manager.get_book_by_symbol("BTCUSDT");
+            feature.manager.remove_symbol("BTCUSDT");
+            CHECK(feature.manager.get_book_by_symbol("BTCUSDT") == nullptr);
+            CHECK(book->get_best_bid().Price == 5000000);
+        }
     }
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/catch_approx.hpp"
 #include "net/fix_parser.h"
+#include "net/fix_raw_decoder.h"
+#include "market_data/pipeline.h"
 #include <thread>
 #include <vector>
 #include "quickfix/fix44/MarketDataIncrementalRefresh.h"
@@ -8,6 +10,26 @@
 #include "common/types.h"
 #include <chrono>
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//Counts every heap allocation in the test binary, used to check the steady-state parse path
+namespace {
+    std::atomic<size_t> heapAllocations{0};
+}
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
 
 namespace pascal {
     namespace test {
@@ -17,8 +39,15 @@ namespace pascal {
             pascal::market_data::FIXMarketDataParser parser;
             std::vector<pascal::common::MarketDataSnapshot> snapshots;
             std::vector<pascal::common::MarketDataIncrement> increments;
+            std::vector<pascal::common::Trade> trades;
+
+            pascal::common::InstrumentSpec spec; //wire grid, used for symbols without their own spec
+            pascal::common::InstrumentSpec ethSpec = pascal::common::InstrumentSpec::from_increments(0.01, 0.0001);
 
             FIXParserTestFeature() {
+                //Registered at subscription time in the engine
+                pascal::common::SymbolRegistry::instance().register_symbol("BTCUSDT");
+                parser.set_instrument_spec("ETHUSDT", ethSpec);
                 parser.register_callback([this](const pascal::common::MarketDataSnapshot& snapshot) {
                     snapshots.push_back(snapshot);
                 });
@@ -26,6 +55,9 @@ namespace pascal {
                 parser.register_callback([this](const pascal::common::MarketDataIncrement& increment) {
                     increments.push_back(increment);
                 });
+                parser.register_callback([this](const pascal::common::Trade& trade) {
+                    trades.push_back(trade);
+                });
 
             }
 
@@ -83,6 +115,19 @@ namespace pascal {
                 
                 return message;
             }
+
+            pascal::common::Ticks px(double price) const {
+                return spec.to_ticks(price);
+            }
+            pascal::common::Lots qty(double quantity) const {
+                return spec.to_lots(quantity);
+            }
+
+            //Raw wire messages are written with '|' as the field delimiter for readability
+            static std::string to_wire(std::string message) {
+                std::replace(message.begin(), message.end(), '|', '\x01');
+                return message;
+            }
         };
 
         TEST_CASE("FIX Parser - Snapshot Parsing", "[fix_parser]") {
@@ -95,13 +140,13 @@ namespace pascal {
                 REQUIRE(feature.snapshots.size() == 1);
                 auto& snapshot = feature.snapshots[0];
                 
-                CHECK(snapshot.symbol == "BTCUSDT");
+                CHECK(pascal::common::SymbolRegistry::instance().name(snapshot.symbol_id) == "BTCUSDT");
                 CHECK(snapshot.bids.size() == 2);
                 CHECK(snapshot.asks.size() == 2);
-                CHECK(snapshot.bids[0].Price == 50000.0);
-                CHECK(snapshot.bids[0].Quantity == 1.5);
-                CHECK(snapshot.asks[0].Price == 50001.0);
-                CHECK(snapshot.asks[0].Quantity == 1.2);
+                CHECK(snapshot.bids[0].Price == feature.px(50000.0));
+                CHECK(snapshot.bids[0].Quantity == feature.qty(1.5));
+                CHECK(snapshot.asks[0].Price == feature.px(50001.0));
+                CHECK(snapshot.asks[0].Quantity == feature.qty(1.2));
             }
             SECTION("Parse empty snapshot message") {
                 auto testSnapshot = feature.create_test_snapshot("ETHUSDT", {}, {});
@@ -111,7 +156,7 @@ namespace pascal {
                 REQUIRE(feature.snapshots.size() == 1);
                 auto& snapshot = feature.snapshots[0];
 
-                CHECK(snapshot.symbol == "ETHUSDT");
+                CHECK(pascal::common::SymbolRegistry::instance().name(snapshot.symbol_id) == "ETHUSDT");
                 CHECK(snapshot.bids.empty());
                 CHECK(snapshot.asks.empty());
             }
@@ -128,12 +173,12 @@ namespace pascal {
                 REQUIRE(feature.increments.size() == 1);
                 auto& increment = feature.increments[0];
 
-                CHECK(increment.symbol == "BTCUSDT");
+                CHECK(pascal::common::SymbolRegistry::instance().name(increment.symbol_id) == "BTCUSDT");
                 CHECK(increment.marketDepth == 1);
                 CHECK(increment.md_entries[0].update_action == pascal::common::UpdateAction::NEW);
                 CHECK(increment.md_entries[0].side == pascal::common::Side::BID);
-                CHECK(increment.md_entries[0].priceLevel.Price == 50000.5);
-                CHECK(increment.md_entries[0].priceLevel.Quantity == 1.0);
+                CHECK(increment.md_entries[0].priceLevel.Price == feature.px(50000.5));
+                CHECK(increment.md_entries[0].priceLevel.Quantity == feature.qty(1.0));
             }
             SECTION("Parse ask update") {
                 auto testIncrement = feature.create_test_increment("ETHUSDT", '0', '1', 500001.0, 1.0);
@@ -147,5 +192,283 @@ namespace pascal {
                 CHECK(increment.md_entries[0].side == pascal::common::Side::OFFER);
             }
         }
+
+        TEST_CASE("FIX Parser - Raw Decoding", "[fix_parser]") {
+            FIXParserTestFeature feature;
+            SECTION("Decode raw snapshot") {
+                std::string wire = FIXParserTestFeature::to_wire("8=FIX.4.4|9=120|35=W|49=SPOT|56=PASCAL_MD|34=2|55=BTCUSDT|268=3|269=0|270=50000.00|271=1.5|269=1|270=50001.25|271=0.00120|269=0|270=49999|271=2|10=000|");
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                feature.parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+
+                REQUIRE(feature.snapshots.size() == 1);
+                auto& snapshot = feature.snapshots[0];
+
+                CHECK(pascal::common::SymbolRegistry::instance().name(snapshot.symbol_id) == "BTCUSDT");
+                REQUIRE(snapshot.bids.size() == 2);
+                REQUIRE(snapshot.asks.size() == 1);
+                CHECK(snapshot.bids[0].Price == feature.px(50000.0));
+                CHECK(snapshot.bids[0].Quantity == feature.qty(1.5));
+                CHECK(snapshot.bids[1].Price == feature.px(49999.0));
+                CHECK(snapshot.asks[0].Price == feature.px(50001.25));
+                CHECK(snapshot.asks[0].Quantity == feature.qty(0.0012));
+            }
+            SECTION("Decode raw increment with per entry update action") {
+                std::string wire = FIXParserTestFeature::to_wire("8=FIX.4.4|9=150|35=X|34=3|268=3|279=0|269=0|270=50000.5|271=1.0|55=BTCUSDT|279=2|269=1|270=50010.1|271=0.5|55=BTCUSDT|279=1|269=2|270=50005|271=0.1|55=BTCUSDT|10=000|");
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                feature.parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+
+                REQUIRE(feature.increments.size() == 1);
+                auto& increment = feature.increments[0];
+
+                CHECK(pascal::common::SymbolRegistry::instance().name(increment.symbol_id) == "BTCUSDT");
+                CHECK(increment.marketDepth == 2); //book entries only
+                REQUIRE(increment.md_entries.size() == 2); //trade entry skipped
+                CHECK(increment.md_entries[0].update_action == pascal::common::UpdateAction::NEW);
+                CHECK(increment.md_entries[0].side == pascal::common::Side::BID);
+                CHECK(increment.md_entries[0].priceLevel.Price == feature.px(50000.5));
+                CHECK(increment.md_entries[1].update_action == pascal::common::UpdateAction::DELETE);
+                CHECK(increment.md_entries[1].side == pascal::common::Side::OFFER);
+                CHECK(increment.md_entries[1].priceLevel.Price == feature.px(50010.1));
+                CHECK(increment.md_entries[1].priceLevel.Quantity == feature.qty(0.5));
+            }
+            SECTION("Decode book update ids") {
+                std::string increment = FIXParserTestFeature::to_wire("8=FIX.4.4|9=120|35=X|34=3|55=BTCUSDT|25043=1001|25044=1003|268=1|279=0|269=0|270=50000.5|271=1.0|10=000|");
+                std::string snapshot = FIXParserTestFeature::to_wire("8=FIX.4.4|9=100|35=W|34=4|55=BTCUSDT|25044=1000|268=1|269=0|270=50000.00|271=1.5|10=000|");
+                std::string plain = FIXParserTestFeature::to_wire("8=FIX.4.4|9=100|35=X|34=5|55=BTCUSDT|268=1|279=0|269=0|270=50000.5|271=1.0|10=000|");
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                feature.parser.parse_raw_message(increment.data(), increment.size(), recv_time);
+                feature.parser.parse_raw_message(snapshot.data(), snapshot.size(), recv_time);
+                feature.parser.parse_raw_message(plain.data(), plain.size(), recv_time);
+
+                REQUIRE(feature.increments.size() == 2);
+                REQUIRE(feature.snapshots.size() == 1);
+                CHECK(feature.increments[0].first_update_id == 1001);
+                CHECK(feature.increments[0].last_update_id == 1003);
+                CHECK(feature.snapshots[0].last_update_id == 1000);
+                CHECK(feature.increments[1].first_update_id == 0);
+                CHECK(feature.increments[1].last_update_id == 0);
+            }
+            SECTION("Decode raw trades") {
+                std::string wire = FIXParserTestFeature::to_wire("8=FIX.4.4|9=150|35=X|34=6|268=2|279=0|269=2|270=3001.25|271=0.5|55=ETHUSDT|1003=9001|2446=1|279=0|269=2|270=3001.00|271=1.25|55=ETHUSDT|1003=9002|2446=2|10=000|");
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                feature.parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+
+                //A trade only message never reaches the book
+                CHECK(feature.increments.empty());
+                REQUIRE(feature.trades.size() == 2);
+                CHECK(pascal::common::SymbolRegistry::instance().name(feature.trades[0].symbol_id) == "ETHUSDT");
+                CHECK(feature.trades[0].priceLevel.Price == feature.ethSpec.to_ticks(3001.25));
+                CHECK(feature.trades[0].priceLevel.Quantity == feature.ethSpec.to_lots(0.5));
+                CHECK(feature.trades[0].aggressor == pascal::common::AggressorSide::BUYER);
+                CHECK(feature.trades[0].trade_id == 9001);
+                CHECK(feature.trades[1].aggressor == pascal::common::AggressorSide::SELLER);
+                CHECK(feature.trades[1].trade_id == 9002);
+                CHECK(feature.trades[1].recv_time == recv_time);
+            }
+            SECTION("Trades and book entries of one message are split") {
+                std::string wire = FIXParserTestFeature::to_wire("8=FIX.4.4|9=150|35=X|34=7|55=BTCUSDT|268=2|279=0|269=0|270=50000.5|271=1.0|279=0|269=2|270=50001|271=0.1|2446=1|10=000|");
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                feature.parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+
+                REQUIRE(feature.increments.size() == 1);
+                CHECK(feature.increments[0].md_entries.size() == 1);
+                //The trade doesn't count toward the depth, this stays a top of book update
+                CHECK(feature.increments[0].marketDepth == 1);
+                REQUIRE(feature.trades.size() == 1);
+                CHECK(feature.trades[0].priceLevel.Price == feature.px(50001.0));
+                CHECK(feature.trades[0].trade_id == 0);
+            }
+            SECTION("Empty aggressor side") {
+                std::string wire = FIXParserTestFeature::to_wire("8=FIX.4.4|9=150|35=X|34=7|55=BTCUSDT|268=1|279=0|269=2|270=50001|271=0.1|2446=|10=000|");
+                feature.parser.parse_raw_message(wire.data(), wire.size(), std::chrono::high_resolution_clock::now());
+
+                REQUIRE(feature.trades.size() == 1);
+                CHECK(feature.trades[0].aggressor == pascal::common::AggressorSide::UNKNOWN_AGGRESSOR);
+            }
+            SECTION("Events carry the parser's venue") {
+                std::string wire = FIXParserTestFeature::to_wire("8=FIX.4.4|9=150|35=X|34=8|55=BTCUSDT|268=2|279=0|269=0|270=50000.5|271=1.0|279=0|269=2|270=50001|271=0.1|2446=1|10=000|");
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                feature.parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+                feature.parser.set_venue(1);
+                feature.parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+
+                REQUIRE(feature.increments.size() == 2);
+                CHECK(feature.increments[0].venue == pascal::common::DEFAULT_VENUE);
+                CHECK(feature.increments[1].venue == 1);
+                REQUIRE(feature.trades.size() == 2);
+                CHECK(feature.trades[1].venue == 1);
+            }
+            SECTION("Raw and QuickFIX paths agree") {
+                auto testIncrement = feature.create_test_increment("ETHUSDT", '1', '1', 3001.75, 12.5);
+                auto recv_time = std::chrono::high_resolution_clock::now();
+                feature.parser.parse_message(testIncrement, recv_time);
+                std::string wire = testIncrement.toString();
+                feature.parser.parse_raw_message(wire.data(), wire.size(), recv_time);
+
+                REQUIRE(feature.increments.size() == 2);
+                auto& fromMessage = feature.increments[0];
+                auto& fromWire = feature.increments[1];
+                CHECK(fromWire.symbol_id == fromMessage.symbol_id);
+                CHECK(fromWire.marketDepth == fromMessage.marketDepth);
+                REQUIRE(fromWire.md_entries.size() == 1);
+                CHECK(fromWire.md_entries[0].update_action == fromMessage.md_entries[0].update_action);
+                CHECK(fromWire.md_entries[0].side == fromMessage.md_entries[0].side);
+                CHECK(fromWire.md_entries[0].priceLevel.Price == fromMessage.md_entries[0].priceLevel.Price);
+                CHECK(fromWire.md_entries[0].priceLevel.Quantity == fromMessage.md_entries[0].priceLevel.Quantity);
+                CHECK(fromWire.md_entries[0].priceLevel.Price == feature.ethSpec.to_ticks(3001.75));
+                CHECK(fromWire.md_entries[0].priceLevel.Quantity == feature.ethSpec.to_lots(12.5));
+            }
+            SECTION("Decoder scans fields across SIMD block boundaries") {
+                std::string padding(150, 'A');
+                std::string wire = FIXParserTestFeature::to_wire("8=FIX.4.4|9=300|35=X|58=" + padding + "|55=ETHUSDT|268=1|279=1|269=1|270=3000.125|271=4|10=000|");
+                pascal::common::MarketDataIncrement update;
+                REQUIRE(pascal::market_data::FIXRawDecoder::decode_increment(wire.data(), wire.size(), std::chrono::high_resolution_clock::now(), update));
+
+                CHECK(pascal::common::SymbolRegistry::instance().name(update.symbol_id) == "ETHUSDT");
+                REQUIRE(update.md_entries.size() == 1);
+                CHECK(update.md_entries[0].update_action == pascal::common::UpdateAction::CHANGE);
+                CHECK(update.md_entries[0].priceLevel.Price == feature.px(3000.125));
+                CHECK(update.md_entries[0].priceLevel.Quantity == feature.qty(4.0));
+            }
+            SECTION("Messages of unregistered symbols are dropped") {
+                std::string snapshot = FIXParserTestFeature::to_wire("8=FIX.4.4|35=W|55=UNLISTEDUSDT|268=1|269=0|270=1|271=1|10=000|");
+                std::string increment = FIXParserTestFeature::to_wire("8=FIX.4.4|35=X|268=1|279=0|269=0|270=1|271=1|55=UNLISTEDUSDT|10=000|");
+                size_t registered = pascal::common::SymbolRegistry::instance().size();
+                feature.parser.parse_raw_message(snapshot.data(), snapshot.size(), std::chrono::high_resolution_clock::now());
+                feature.parser.parse_raw_message(increment.data(), increment.size(), std::chrono::high_resolution_clock::now());
+                feature.parser.parse_message(feature.create_test_increment("UNLISTEDUSDT"), std::chrono::high_resolution_clock::now());
+
+                CHECK(feature.snapshots.empty());
+                CHECK(feature.increments.empty());
+                CHECK(pascal::common::SymbolRegistry::instance().find("UNLISTEDUSDT") == pascal::common::INVALID_SYMBOL_ID);
+                CHECK(pascal::common::SymbolRegistry::instance().size() == registered);
+            }
+            SECTION("Decimals past the wire grid's range saturate") {
+                auto parse = [](const std::string& value) {
+                    return pascal::common::parse_wire_decimal(value.data(), value.data()+value.size());
+                };
+                CHECK(parse("92233720368.54775807") == pascal::common::InstrumentSpec::MAX_WIRE_VALUE);
+                CHECK(parse("92233720368.54775808") == pascal::common::InstrumentSpec::MAX_WIRE_VALUE);
+                CHECK(parse("150000000000") == pascal::common::InstrumentSpec::MAX_WIRE_VALUE);
+                CHECK(parse("-150000000000.5") == -pascal::common::InstrumentSpec::MAX_WIRE_VALUE);
+                CHECK(parse("99999999999999999999999") == pascal::common::InstrumentSpec::MAX_WIRE_VALUE);
+                CHECK(parse("12345678901.5") == 1234567890150000000);
+            }
+        }
+        TEST_CASE("FIX Parser - Steady state decoding does not allocate", "[fix_parser]") {
+            pascal::market_data::FIXMarketDataParser parser;
+            parser.set_instrument_spec("ETHUSDT", pascal::common::InstrumentSpec::from_increments(0.01, 0.0001));
+            pascal::common::Lots bidQty = 0;
+            size_t levels = 0;
+            parser.register_callback([&bidQty](const pascal::common::MarketDataIncrement& increment) {
+                for (const auto& md : increment.md_entries) bidQty += md.priceLevel.Quantity;
+            });
+            parser.register_callback([&levels](const pascal::common::MarketDataSnapshot& snapshot) {
+                levels += snapshot.bids.size() + snapshot.asks.size();
+            });
+
+            std::string increment = FIXParserTestFeature::to_wire("8=FIX.4.4|9=150|35=X|34=3|268=3|279=0|269=0|270=3000.5|271=1.0|55=ETHUSDT|279=2|269=1|270=3010.1|271=0.5|55=ETHUSDT|279=1|269=0|270=3000.25|271=2|55=ETHUSDT|10=000|");
+            std::string snapshot = "8=FIX.4.4\x01" "35=W\x01" "55=ETHUSDT\x01" "268=200\x01";
+            for (int i = 0; i < 200; i++) {
+                snapshot += "269=" + std::to_string(i % 2) + "\x01" "270=" + std::to_string(3000 + (i % 2 ? i : -i)) + ".5\x01" "271=1.25\x01";
+            }
+            snapshot += "10=000\x01";
+            //A group larger than the inline entry storage takes the overflow path once, then reuses it
+            std::string large = "8=FIX.4.4\x01" "35=X\x01" "268=100\x01";
+            for (int i = 0; i < 100; i++) {
+                large += "279=1\x01" "269=0\x01" "270=" + std::to_string(2900 + i) + "\x01" "271=3\x01" "55=ETHUSDT\x01";
+            }
+            large += "10=000\x01";
+
+            auto recv_time = std::chrono::high_resolution_clock::now();
+            parser.parse_raw_message(increment.data(), increment.size(), recv_time);
+            parser.parse_raw_message(snapshot.data(), snapshot.size(), recv_time);
+            parser.parse_raw_message(large.data(), large.size(), recv_time);
+
+            size_t before = heapAllocations.load();
+            for (int i = 0; i < 1000; i++) {
+                parser.parse_raw_message(increment.data(), increment.size(), recv_time);
+                parser.parse_raw_message(large.data(), large.size(), recv_time);
+                if (i % 100 == 0) parser.parse_raw_message(snapshot.data(), snapshot.size(), recv_time);
+            }
+            size_t after = heapAllocations.load();
+
+            CHECK(after - before == 0);
+            CHECK(parser.get_messages_processed() == 3 + 2000 + 10);
+            CHECK(levels == 11 * 200);
+            CHECK(bidQty > 0);
+        }
+        //Stage recording what reached it and the book state it saw
+        struct RecordingStage {
+            std::shared_ptr<pascal::market_data::OrderBook> book;
+            std::vector<char> events;
+            pascal::common::Ticks bestBidSeen = 0;
+
+            void on_snapshot(pascal::common::MarketDataSnapshot&) {
+                events.push_back('W');
+                bestBidSeen = book->get_best_bid().Price;
+            }
+            void on_increment(const pascal::common::MarketDataIncrement&) {
+                events.push_back('X');
+                bestBidSeen = book->get_best_bid().Price;
+            }
+        };
+        //Stage with no handlers for increments, the pipeline skips it for them
+        struct SnapshotCountStage {
+            int snapshots = 0;
+            void on_snapshot(pascal::common::MarketDataSnapshot&) {
+                snapshots++;
+            }
+        };
+        TEST_CASE("FIX Parser - Typed pipeline sink", "[fix_parser]") {
+            pascal::market_data::FIXOrderBookManager manager;
+            manager.add_symbol("BTCUSDT");
+            RecordingStage recording;
+            recording.book = manager.get_book_by_symbol("BTCUSDT");
+            using BookPipeline = pascal::market_data::Pipeline<pascal::market_data::BookUpdateStage, RecordingStage, SnapshotCountStage>;
+            pascal::market_data::BasicFIXMarketDataParser<BookPipeline> parser(
+                pascal::market_data::BookUpdateStage(manager),
+                recording,
+                SnapshotCountStage{});
+
+            std::string snapshot = FIXParserTestFeature::to_wire("8=FIX.4.4|35=W|55=BTCUSDT|268=2|269=0|270=50000|271=1.5|269=1|270=50001|271=2|10=000|");
+            std::string increment = FIXParserTestFeature::to_wire("8=FIX.4.4|35=X|268=1|279=0|269=0|270=50000.5|271=1|55=BTCUSDT|10=000|");
+            auto recv_time = std::chrono::high_resolution_clock::now();
+            parser.parse_raw_message(snapshot.data(), snapshot.size(), recv_time);
+            parser.parse_raw_message(increment.data(), increment.size(), recv_time);
+
+            //Stages run in declaration order, so later stages see the book already updated
+            auto& recorder = parser.get_sink().get<RecordingStage>();
+            CHECK(recorder.events == std::vector<char>{'W', 'X'});
+            CHECK(recorder.bestBidSeen == 5000050000000);
+            CHECK(parser.get_sink().get<2>().snapshots == 1);
+            CHECK(manager.get_book_by_symbol("BTCUSDT")->get_total_bid_levels() == 2);
+            CHECK(parser.get_messages_processed() == 2);
+
+            //Latency points of the last message, left for the engine's worker
+            const auto& marks = pascal::common::thread_stage_marks();
+            CHECK(marks.parsed > 0);
+            CHECK(marks.book_applied >= marks.parsed);
+        }
+        TEST_CASE("FIX Parser - Counts every decoding thread", "[fix_parser]") {
+            pascal::market_data::FIXMarketDataParser parser;
+            pascal::common::SymbolRegistry::instance().register_symbol("BTCUSDT");
+            std::string snapshot = FIXParserTestFeature::to_wire("8=FIX.4.4|35=W|55=BTCUSDT|268=1|269=0|270=50000|271=1.5|10=000|");
+
+            //All threads hold their index at once, so some of them are past the per thread shards
+            constexpr size_t threadCount = 100;
+            std::atomic<size_t> claimed{0};
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < threadCount; i++) {
+                threads.emplace_back([&]() {
+                    pascal::common::thread_index();
+                    claimed.fetch_add(1);
+                    while (claimed.load() < threadCount) std::this_thread::yield();
+                    parser.parse_raw_message(snapshot.data(), snapshot.size(), std::chrono::high_resolution_clock::now());
+                });
+            }
+            for (auto& thread : threads) thread.join();
+            CHECK(parser.get_messages_processed() == threadCount);
+        }
     }
-}
\ No newline at end of file
+}
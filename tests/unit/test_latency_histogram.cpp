@@ -0,0 +1,101 @@
+#include "catch2/catch_test_macros.hpp"
+#include "common/latency_histogram.h"
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <thread>
+
+namespace pascal {
+    namespace test {
+        TEST_CASE("Latency Histogram - Buckets", "[latency_histogram]") {
+            using pascal::common::LatencyHistogram;
+
+            SECTION("Small values are exact") {
+                for (uint64_t v = 0; v < LatencyHistogram::SUB_BUCKETS; v++) {
+                    size_t bucket = LatencyHistogram::bucket_of(v);
+                    CHECK(LatencyHistogram::lowest_in(bucket) == v);
+                    CHECK(LatencyHistogram::highest_in(bucket) == v);
+                }
+            }
+            SECTION("Every value lands in a bucket that covers it within 1/64") {
+                for (uint64_t v : std::initializer_list<uint64_t>{128, 129, 255, 256, 1000, 12345, 999999, 123456789, LatencyHistogram::MAX_VALUE}) {
+                    size_t bucket = LatencyHistogram::bucket_of(v);
+                    REQUIRE(bucket < LatencyHistogram::BUCKET_COUNT);
+                    CHECK(LatencyHistogram::lowest_in(bucket) <= v);
+                    CHECK(LatencyHistogram::highest_in(bucket) >= v);
+                    CHECK(LatencyHistogram::highest_in(bucket) - LatencyHistogram::lowest_in(bucket) <= v/64);
+                }
+                CHECK(LatencyHistogram::bucket_of(LatencyHistogram::MAX_VALUE) == LatencyHistogram::BUCKET_COUNT-1);
+                CHECK(LatencyHistogram::bucket_of(UINT64_MAX) == LatencyHistogram::BUCKET_COUNT-1);
+            }
+            SECTION("Buckets are contiguous") {
+                for (size_t bucket = 1; bucket < LatencyHistogram::BUCKET_COUNT; bucket++) {
+                    REQUIRE(LatencyHistogram::lowest_in(bucket) == LatencyHistogram::highest_in(bucket-1)+1);
+                }
+            }
+        }
+        TEST_CASE("Latency Histogram - Percentiles", "[latency_histogram]") {
+            pascal::common::LatencyHistogram histogram;
+            CHECK(histogram.snapshot().percentile(99.0) == 0);
+
+            //1..1000us, one sample each
+            for (int64_t us = 1; us <= 1000; us++) histogram.record(us*1000);
+            histogram.record(-5); //clock going backwards counts as zero
+            auto snapshot = histogram.snapshot();
+            CHECK(snapshot.count() == 1001);
+            CHECK(snapshot.min() == 0);
+
+            auto within = [](uint64_t value, uint64_t expected) {
+                return value >= expected && value <= expected + expected/64;
+            };
+            CHECK(within(snapshot.percentile(50.0), 500000));
+            CHECK(within(snapshot.percentile(99.0), 990000));
+            CHECK(within(snapshot.percentile(99.9), 999000));
+            CHECK(within(snapshot.max(), 1000000));
+            CHECK(snapshot.percentile(100.0) == snapshot.max());
+            CHECK(snapshot.mean() > 495000.0);
+            CHECK(snapshot.mean() < 510000.0);
+        }
+        TEST_CASE("Latency Histogram - Stage intervals", "[latency_histogram]") {
+            pascal::common::StageLatency latency;
+            latency.record(pascal::common::LatencyStage::PARSE, 100);
+            latency.record(pascal::common::LatencyStage::PARSE, 1000000);
+            CHECK(latency.interval(pascal::common::LatencyStage::PARSE).count() == 2);
+            CHECK(latency.interval(pascal::common::LatencyStage::QUEUE).count() == 0);
+
+            //A new interval forgets the slow sample but the running total keeps it
+            latency.reset_interval();
+            latency.record(pascal::common::LatencyStage::PARSE, 200);
+            auto interval = latency.interval(pascal::common::LatencyStage::PARSE);
+            CHECK(interval.count() == 1);
+            CHECK(interval.min() == 200);
+            CHECK(interval.max() <= 203);
+            auto total = latency.total(pascal::common::LatencyStage::PARSE);
+            CHECK(total.count() == 3);
+            CHECK(total.max() >= 1000000);
+
+            interval += latency.interval(pascal::common::LatencyStage::PARSE);
+            CHECK(interval.count() == 2);
+            CHECK(std::string(pascal::common::latency_stage_name(pascal::common::LatencyStage::END_TO_END)) == "end_to_end");
+        }
+        TEST_CASE("Latency Histogram - Snapshots while recording", "[latency_histogram]") {
+            constexpr int64_t SAMPLES = 200000;
+            pascal::common::StageLatency latency;
+            std::atomic<bool> done{false};
+            std::thread writer([&]() {
+                for (int64_t i = 0; i < SAMPLES; i++) latency.record(pascal::common::LatencyStage::END_TO_END, i % 5000);
+                done.store(true, std::memory_order_release);
+            });
+            uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                uint64_t seen = latency.total(pascal::common::LatencyStage::END_TO_END).count();
+                CHECK(seen >= last);
+                last = seen;
+                latency.reset_interval();
+            }
+            writer.join();
+            CHECK(latency.total(pascal::common::LatencyStage::END_TO_END).count() == SAMPLES);
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include "catch2/catch_test_macros.hpp"
+#include "net/message_journal.h"
+#include "net/journal_replay.h"
+#include "net/fix_parser.h"
+#include "market_data/pipeline.h"
+#include "market_data/fix_order_book.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+        namespace {
+            std::string journal_path(const std::string& name) {
+                return "/tmp/pascal_test_" + std::to_string(::getpid()) + "_" + name + ".jrnl";
+            }
+            std::string to_wire(std::string message) {
+                std::replace(message.begin(), message.end(), '|', '\x01');
+                return message;
+            }
+        }
+
+        TEST_CASE("Message Journal - Append and read back", "[message_journal]") {
+            std::string path = journal_path("records");
+            std::vector<std::string> messages;
+            for (int i = 0; i < 500; i++) messages.push_back("8=FIX.4.4\x01" "35=X\x01" "seq=" + std::to_string(i) + std::string(i % 37, 'x'));
+            {
+                //Small growth step so the writer remaps several times
+                pascal::net::MessageJournalWriter writer(path, 4096);
+                for (size_t i = 0; i < messages.size(); i++) {
+                    REQUIRE(writer.append(messages[i].data(), messages[i].size(), static_cast<int64_t>(1000 + i)));
+                }
+                CHECK(writer.get_record_count() == messages.size());
+            }
+
+            pascal::net::MessageJournalReader reader(path);
+            CHECK(reader.get_record_count() == messages.size());
+            CHECK(reader.get_created_nanos() > 0);
+            std::vector<std::string> seen;
+            std::vector<int64_t> times;
+            size_t visited = reader.for_each([&seen, &times](const pascal::net::MessageJournalReader::Record& record) {
+                seen.emplace_back(record.data, record.size);
+                times.push_back(record.recv_nanos);
+            });
+            CHECK(visited == messages.size());
+            CHECK(seen == messages);
+            CHECK(times.front() == 1000);
+            CHECK(times.back() == 1499);
+            std::remove(path.c_str());
+        }
+        TEST_CASE("Message Journal - Foreign files are refused", "[message_journal]") {
+            std::string path = journal_path("foreign");
+            {
+                std::ofstream out(path);
+                out << std::string(128, 'z');
+            }
+            CHECK_THROWS_AS(pascal::net::MessageJournalReader(path), std::runtime_error);
+            std::remove(path.c_str());
+            CHECK_THROWS_AS(pascal::net::MessageJournalReader(path), std::runtime_error);
+        }
+        TEST_CASE("Message Journal - Replay through parser and books", "[message_journal]") {
+            std::string path = journal_path("replay");
+            std::vector<std::string> messages = {
+                to_wire("8=FIX.4.4|35=W|55=JRNLBTC|268=2|269=0|270=50000|271=1.5|269=1|270=50001|271=2|10=000|"),
+                to_wire("8=FIX.4.4|35=X|268=1|279=0|269=0|270=50000.5|271=1|55=JRNLBTC|10=000|"),
+                to_wire("8=FIX.4.4|35=W|55=JRNLETH|268=1|269=1|270=3000|271=4|10=000|"),
+                to_wire("8=FIX.4.4|35=0|10=000|") //heartbeat, counted but not decoded
+            };
+            {
+                pascal::net::MessageJournalWriter writer(path);
+                for (size_t i = 0; i < messages.size(); i++) {
+                    //Captured 10ms apart
+                    REQUIRE(writer.append(messages[i].data(), messages[i].size(), static_cast<int64_t>(i)*10000000));
+                }
+            }
+            pascal::net::MessageJournalReader journal(path);
+            CHECK(pascal::net::journal_symbols(journal) == std::vector<std::string>{"JRNLBTC", "JRNLETH"});
+
+            using ReplayPipeline = pascal::market_data::Pipeline<pascal::market_data::BookUpdateStage>;
+            SECTION("As fast as possible") {
+                pascal::market_data::FIXOrderBookManager manager;
+                for (const auto& symbol : pascal::net::journal_symbols(journal)) manager.add_symbol(symbol);
+                pascal::market_data::BasicFIXMarketDataParser<ReplayPipeline> parser{pascal::market_data::BookUpdateStage(manager)};
+
+                auto report = pascal::net::replay_journal(journal, parser);
+                CHECK(report.messages == 4);
+                CHECK(report.latency.count() == 4);
+                CHECK(report.messages_per_second() > 0.0);
+                CHECK(report.elapsed < std::chrono::milliseconds(30));
+                CHECK(parser.get_messages_processed() == 3);
+                CHECK(manager.get_book_by_symbol("JRNLBTC")->get_total_bid_levels() == 2);
+                CHECK(manager.get_book_by_symbol("JRNLETH")->get_total_ask_levels() == 1);
+            }
+            SECTION("At captured pacing") {
+                pascal::market_data::FIXOrderBookManager manager;
+                for (const auto& symbol : pascal::net::journal_symbols(journal)) manager.add_symbol(symbol);
+                pascal::market_data::BasicFIXMarketDataParser<ReplayPipeline> parser{pascal::market_data::BookUpdateStage(manager)};
+
+                auto report = pascal::net::replay_journal(journal, parser, {.paced = true, .speed = 2.0});
+                CHECK(report.messages == 4);
+                CHECK(report.elapsed >= std::chrono::milliseconds(15));
+                CHECK(manager.get_book_by_symbol("JRNLBTC")->get_total_bid_levels() == 2);
+            }
+            std::remove(path.c_str());
+        }
+    }
+}
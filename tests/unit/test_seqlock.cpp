@@ -0,0 +1,54 @@
+#include "catch2/catch_test_macros.hpp"
+#include "common/seqlock.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+namespace pascal {
+    namespace test {
+        TEST_CASE("SeqLock - Writes bump the sequence and reset clears it", "[seqlock]") {
+            pascal::common::SeqLock lock;
+            CHECK_FALSE(lock.written());
+            CHECK(lock.sequence() == 0);
+            {
+                pascal::common::SeqLock::WriteGuard write(lock);
+                CHECK(lock.sequence() == 1);
+            }
+            CHECK(lock.written());
+            CHECK(lock.sequence() == 2);
+            lock.reset();
+            CHECK_FALSE(lock.written());
+        }
+        TEST_CASE("SeqLock - Readers never see a half written pair", "[seqlock]") {
+            pascal::common::SeqLock lock;
+            std::atomic<uint64_t> first{0};
+            std::atomic<uint64_t> second{0};
+            std::atomic<bool> done{false};
+            std::thread writer([&]() {
+                for (uint64_t i = 1; i <= 100000; i++) {
+                    pascal::common::SeqLock::WriteGuard write(lock);
+                    first.store(i, std::memory_order_relaxed);
+                    second.store(i, std::memory_order_relaxed);
+                }
+                done.store(true);
+            });
+            size_t torn = 0;
+            uint64_t last = 0;
+            while (!done.load()) {
+                auto pair = lock.read_consistent([&]() {
+                    return std::make_pair(first.load(std::memory_order_relaxed), second.load(std::memory_order_relaxed));
+                });
+                if (pair.first != pair.second || pair.first < last) torn++;
+                last = pair.first;
+            }
+            writer.join();
+            CHECK(torn == 0);
+            uint64_t total = 0;
+            lock.read_consistent([&]() {
+                total = first.load(std::memory_order_relaxed) + second.load(std::memory_order_relaxed);
+            });
+            CHECK(total == 200000);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#include "catch2/catch_test_macros.hpp"
+#include "market_data/fix_order_book.h"
+#include "market_data/shm_book.h"
+#include "common/types.h"
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace pascal {
+    namespace test {
+
+        class ShmBookTestFeature {
+        public:
+            std::string name = "/pascal_test_books_" + std::to_string(::getpid());
+            pascal::market_data::FIXOrderBookManager manager;
+            pascal::market_data::ShmBookPublisher publisher{name, 16};
+            pascal::common::SymbolId id;
+
+            ShmBookTestFeature() {
+                id = manager.add_symbol("SHMUSDT", pascal::common::InstrumentSpec::from_increments(0.01, 0.00001));
+                manager.set_publisher(&publisher);
+            }
+            ~ShmBookTestFeature() {
+                pascal::market_data::ShmBookPublisher::unlink(name);
+            }
+
+            //levels bid and ask levels one tick apart around 1000/1010, quantity 10 at every level
+            void seed(int levels) {
+                pascal::common::MarketDataSnapshot snapshot;
+                snapshot.symbol_id = id;
+                for (int i = 0; i < levels; i++) {
+                    snapshot.bids.push_back({.Price = 1000 - i, .Quantity = 10});
+                    snapshot.asks.push_back({.Price = 1010 + i, .Quantity = 10});
+                }
+                manager.process_snapshot(snapshot);
+            }
+        };
+
+        TEST_CASE("Shm Book - Readers see the published books", "[shm_book]") {
+            ShmBookTestFeature feature;
+            pascal::market_data::ShmBookReader reader(feature.name);
+            CHECK(reader.get_slot_count() == 16);
+            CHECK(reader.find("SHMUSDT") == pascal::market_data::ShmBookReader::NOT_FOUND);
+
+            feature.seed(static_cast<int>(pascal::market_data::SHM_BOOK_DEPTH) + 5);
+            size_t slot = reader.find("SHMUSDT");
+            REQUIRE(slot == feature.id);
+            CHECK(reader.find("OTHERUSDT") == pascal::market_data::ShmBookReader::NOT_FOUND);
+
+            pascal::market_data::ShmBookData data;
+            REQUIRE(reader.load(slot, data));
+            CHECK(std::strcmp(data.symbol, "SHMUSDT") == 0);
+            CHECK(data.synchronized);
+            CHECK(data.spec.tick_units == feature.manager.get_book(feature.id)->get_instrument_spec().tick_units);
+            CHECK(data.bid_count == pascal::market_data::SHM_BOOK_DEPTH);
+            CHECK(data.ask_count == pascal::market_data::SHM_BOOK_DEPTH);
+            CHECK(data.bids[0].Price == 1000);
+            CHECK(data.asks[pascal::market_data::SHM_BOOK_DEPTH-1].Price == 1010 + static_cast<int64_t>(pascal::market_data::SHM_BOOK_DEPTH) - 1);
+            CHECK(data.book_version == feature.manager.get_book(feature.id)->get_version());
+
+            pascal::common::MarketDataIncrement update;
+            update.symbol_id = feature.id;
+            update.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = 1001, .Quantity = 7}, .update_action = pascal::common::UpdateAction::NEW});
+            update.marketDepth = 1;
+            feature.manager.process_increment(update);
+
+            pascal::common::PriceLevel bid, ask;
+            REQUIRE(reader.load_bbo(slot, bid, ask));
+            CHECK(bid.Price == 1001);
+            CHECK(bid.Quantity == 7);
+            CHECK(ask.Price == 1010);
+            CHECK(feature.publisher.get_publications() == 2);
+            CHECK(reader.is_current());
+        }
+        TEST_CASE("Shm Book - Readers notice a restarted publisher", "[shm_book]") {
+            ShmBookTestFeature feature;
+            feature.seed(3);
+            pascal::market_data::ShmBookReader reader(feature.name);
+            size_t slot = reader.find("SHMUSDT");
+            REQUIRE(slot != pascal::market_data::ShmBookReader::NOT_FOUND);
+
+            pascal::market_data::ShmBookPublisher restarted(feature.name, 16);
+            CHECK_FALSE(reader.is_current());
+            pascal::market_data::ShmBookData data;
+            CHECK_FALSE(reader.load(slot, data));
+            CHECK(reader.find("SHMUSDT") == pascal::market_data::ShmBookReader::NOT_FOUND);
+
+            CHECK_THROWS_AS(pascal::market_data::ShmBookPublisher(feature.name, 32), std::runtime_error);
+            CHECK_THROWS_AS(pascal::market_data::ShmBookReader("/pascal_test_books_missing"), std::runtime_error);
+        }
+        TEST_CASE("Shm Book - Loads are never torn", "[shm_book]") {
+            ShmBookTestFeature feature;
+            feature.seed(5);
+            pascal::market_data::ShmBookReader reader(feature.name);
+            size_t slot = reader.find("SHMUSDT");
+            REQUIRE(slot != pascal::market_data::ShmBookReader::NOT_FOUND);
+
+            //Every publication moves both sides by the same amount, a consistent load keeps the spread
+            std::atomic<bool> done{false};
+            std::thread writer([&feature, &done]() {
+                for (int i = 1; i <= 20000; i++) {
+                    pascal::common::MarketDataSnapshot snapshot;
+                    snapshot.symbol_id = feature.id;
+                    snapshot.bids.push_back({.Price = 1000 + i, .Quantity = i});
+                    snapshot.asks.push_back({.Price = 1010 + i, .Quantity = i});
+                    feature.manager.process_snapshot(snapshot);
+                }
+                done.store(true, std::memory_order_release);
+            });
+            uint64_t torn = 0;
+            pascal::common::PriceLevel bid, ask;
+            while (!done.load(std::memory_order_acquire)) {
+                if (reader.load_bbo(slot, bid, ask) && (ask.Price - bid.Price != 10 || ask.Quantity != bid.Quantity)) torn++;
+            }
+            writer.join();
+            CHECK(torn == 0);
+        }
+    }
+}
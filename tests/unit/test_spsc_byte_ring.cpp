@@ -0,0 +1,83 @@
+#include "catch2/catch_test_macros.hpp"
+#include "common/spsc_byte_ring.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+        TEST_CASE("SPSC Byte Ring - Records", "[spsc_byte_ring]") {
+            auto ring = std::make_unique<pascal::common::SPSCByteRing<256>>();
+            std::vector<std::string> seen;
+            std::vector<int64_t> tags;
+            auto collect = [&seen, &tags](const char* data, size_t len, int64_t tag) {
+                seen.emplace_back(data, len);
+                tags.push_back(tag);
+            };
+
+            SECTION("Variable length records keep their bytes and tags") {
+                REQUIRE(ring->push("35=W", 4, 7));
+                REQUIRE(ring->push("", 0, 8));
+                REQUIRE(ring->push("8=FIX.4.4\x01" "35=X\x01", 15, 9));
+                CHECK(ring->consume_all(collect) == 3);
+                CHECK(seen == std::vector<std::string>{"35=W", "", "8=FIX.4.4\x01" "35=X\x01"});
+                CHECK(tags == std::vector<int64_t>{7, 8, 9});
+                CHECK(ring->empty());
+            }
+            SECTION("Consumers taking four arguments also get the aux tag") {
+                REQUIRE(ring->push("35=W", 4, 7, 42));
+                REQUIRE(ring->push("35=X", 4, 8));
+                std::vector<uint32_t> aux;
+                CHECK(ring->consume_all([&aux](const char*, size_t, int64_t, uint32_t a) { aux.push_back(a); }) == 2);
+                CHECK(aux == std::vector<uint32_t>{42, 0});
+            }
+            SECTION("Full ring and oversized records are refused") {
+                std::string record(40, 'x'); //64 bytes with header and padding
+                for (int i = 0; i < 4; i++) REQUIRE(ring->push(record.data(), record.size(), i));
+                CHECK(!ring->push("y", 1, 4));
+                CHECK(ring->consume_all(collect, 1) == 1);
+                CHECK(ring->push(record.data(), record.size(), 4));
+                std::string huge(pascal::common::SPSCByteRing<256>::MAX_RECORD_SIZE+1, 'z');
+                CHECK(!ring->push(huge.data(), huge.size(), 5));
+            }
+            SECTION("Records that reach the end of the buffer wrap to the start") {
+                std::string a(70, 'a'), b(100, 'b');
+                for (int round = 0; round < 10; round++) {
+                    seen.clear();
+                    REQUIRE(ring->push(a.data(), a.size(), round));
+                    REQUIRE(ring->push(b.data(), b.size(), round));
+                    REQUIRE(ring->consume_all(collect) == 2);
+                    CHECK(seen[0] == a);
+                    CHECK(seen[1] == b);
+                }
+            }
+        }
+        TEST_CASE("SPSC Byte Ring - Producer and consumer threads", "[spsc_byte_ring]") {
+            auto ring = std::make_unique<pascal::common::SPSCByteRing<4096>>();
+            constexpr int64_t COUNT = 200000;
+
+            std::thread producer([&ring]() {
+                std::string payload;
+                for (int64_t i = 0; i < COUNT;) {
+                    payload.assign(static_cast<size_t>(i % 300), static_cast<char>('a' + i % 26));
+                    if (ring->push(payload.data(), payload.size(), i)) i++;
+                }
+            });
+
+            int64_t expected = 0;
+            bool intact = true;
+            while (expected < COUNT) {
+                ring->consume_all([&](const char* data, size_t len, int64_t tag) {
+                    intact &= tag == expected && len == static_cast<size_t>(expected % 300);
+                    for (size_t i = 0; i < len; i++) intact &= data[i] == static_cast<char>('a' + expected % 26);
+                    expected++;
+                }, 32);
+            }
+            producer.join();
+
+            CHECK(intact);
+            CHECK(ring->empty());
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#include "catch2/catch_test_macros.hpp"
+#include "common/lockfree_spsc_queue.h"
+#include <array>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+        TEST_CASE("SPSC Queue - Single thread", "[spsc_queue]") {
+            pascal::common::SPSCQueue<int, 8> queue;
+
+            SECTION("Every slot is usable") {
+                for (int i = 0; i < 8; i++) REQUIRE(queue.push(i));
+                CHECK(!queue.push(8));
+                CHECK(queue.size() == 8);
+                int value = -1;
+                for (int i = 0; i < 8; i++) {
+                    REQUIRE(queue.pop(value));
+                    CHECK(value == i);
+                }
+                CHECK(!queue.pop(value));
+                CHECK(queue.empty());
+            }
+            SECTION("Indices wrap around the ring") {
+                int value = -1;
+                for (int i = 0; i < 100; i++) {
+                    REQUIRE(queue.push(i));
+                    REQUIRE(queue.push(i+1000));
+                    REQUIRE(queue.pop(value));
+                    CHECK(value == i);
+                    REQUIRE(queue.pop(value));
+                    CHECK(value == i+1000);
+                }
+            }
+            SECTION("Bulk push and pop") {
+                std::array<int, 12> in = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+                CHECK(queue.push_bulk(in.begin(), in.size()) == 8);
+                std::array<int, 5> out{};
+                CHECK(queue.pop_bulk(out.data(), out.size()) == 5);
+                CHECK(out == std::array<int, 5>{0, 1, 2, 3, 4});
+                CHECK(queue.push_bulk(in.begin()+8, 4) == 4);
+                CHECK(queue.pop_bulk(out.data(), out.size()) == 5);
+                CHECK(out == std::array<int, 5>{5, 6, 7, 8, 9});
+                CHECK(queue.pop_bulk(out.data(), out.size()) == 2);
+                CHECK(queue.empty());
+            }
+            SECTION("Consume all in place") {
+                for (int i = 0; i < 6; i++) queue.push(i);
+                std::vector<int> seen;
+                CHECK(queue.consume_all([&seen](int& v) { seen.push_back(v); }, 4) == 4);
+                CHECK(queue.consume_all([&seen](int& v) { seen.push_back(v); }) == 2);
+                CHECK(seen == std::vector<int>{0, 1, 2, 3, 4, 5});
+                CHECK(queue.consume_all([](int&) {}) == 0);
+            }
+        }
+        TEST_CASE("SPSC Queue - Item lifetime", "[spsc_queue]") {
+            auto tracker = std::make_shared<int>(0);
+            {
+                pascal::common::SPSCQueue<std::shared_ptr<int>, 4> queue;
+                std::vector<std::shared_ptr<int>> items(3, tracker);
+                CHECK(queue.push_bulk(std::make_move_iterator(items.begin()), items.size()) == 3);
+                CHECK(tracker.use_count() == 4);
+                std::shared_ptr<int> out;
+                REQUIRE(queue.pop(out));
+                CHECK(tracker.use_count() == 4);
+                out.reset();
+                CHECK(queue.consume_all([](std::shared_ptr<int>&) {}, 1) == 1);
+                CHECK(tracker.use_count() == 2);
+            }
+            //Items left in the queue are destroyed with it
+            CHECK(tracker.use_count() == 1);
+        }
+        TEST_CASE("SPSC Queue - Producer and consumer threads", "[spsc_queue]") {
+            auto queue = std::make_unique<pascal::common::SPSCQueue<uint64_t, 1024>>();
+            constexpr uint64_t COUNT = 1000000;
+
+            std::thread producer([&queue]() {
+                std::array<uint64_t, 16> batch;
+                uint64_t next = 0;
+                while (next < COUNT) {
+                    if (next % 3 == 0) {
+                        if (queue->push(next)) next++;
+                        continue;
+                    }
+                    size_t n = std::min<uint64_t>(batch.size(), COUNT-next);
+                    for (size_t i = 0; i < n; i++) batch[i] = next+i;
+                    next += queue->push_bulk(batch.begin(), n);
+                }
+            });
+
+            uint64_t expected = 0;
+            bool ordered = true;
+            std::array<uint64_t, 32> out;
+            while (expected < COUNT) {
+                if (expected % 2) {
+                    queue->consume_all([&](uint64_t& v) {
+                        ordered &= v == expected++;
+                    }, 64);
+                }
+                else {
+                    size_t n = queue->pop_bulk(out.data(), out.size());
+                    for (size_t i = 0; i < n; i++) ordered &= out[i] == expected++;
+                }
+            }
+            producer.join();
+
+            CHECK(ordered);
+            CHECK(queue->empty());
+        }
+    }
+}
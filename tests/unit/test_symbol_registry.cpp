@@ -0,0 +1,83 @@
+#include "catch2/catch_test_macros.hpp"
+#include "common/symbol_registry.h"
+#include "market_data/fix_order_book.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+        TEST_CASE("Symbol Registry - Dense ids", "[symbol_registry]") {
+            pascal::common::SymbolRegistry registry;
+
+            SECTION("Ids are assigned in registration order and are stable") {
+                CHECK(registry.register_symbol("BTCUSDT") == 0);
+                CHECK(registry.register_symbol("ETHUSDT") == 1);
+                CHECK(registry.register_symbol("BTCUSDT") == 0);
+                CHECK(registry.size() == 2);
+                CHECK(registry.find("ETHUSDT") == 1);
+                CHECK(registry.name(1) == "ETHUSDT");
+            }
+            SECTION("Unknown and empty symbols") {
+                registry.register_symbol("BTCUSDT");
+                CHECK(registry.find("BTCUSD") == pascal::common::INVALID_SYMBOL_ID);
+                CHECK(registry.find("") == pascal::common::INVALID_SYMBOL_ID);
+                CHECK(registry.register_symbol("") == pascal::common::INVALID_SYMBOL_ID);
+            }
+            SECTION("Registration fails once the table is full") {
+                for (size_t i = 0; i < pascal::common::SymbolRegistry::MAX_SYMBOLS; i++) {
+                    REQUIRE(registry.register_symbol("SYM" + std::to_string(i)) == i);
+                }
+                CHECK(registry.register_symbol("ONEMORE") == pascal::common::INVALID_SYMBOL_ID);
+                CHECK(registry.find("SYM1000") == 1000);
+            }
+        }
+        TEST_CASE("Symbol Registry - Lookups while registering", "[symbol_registry]") {
+            pascal::common::SymbolRegistry registry;
+            registry.register_symbol("BTCUSDT");
+
+            std::atomic<bool> done{false};
+            std::thread writer([&]() {
+                for (int i = 0; i < 500; i++) {
+                    registry.register_symbol("SYM" + std::to_string(i));
+                }
+                done.store(true);
+            });
+            size_t misses = 0;
+            while (!done.load()) {
+                if (registry.find("BTCUSDT") != 0) misses++;
+            }
+            writer.join();
+
+            CHECK(misses == 0);
+            CHECK(registry.find("SYM499") == 500);
+        }
+        TEST_CASE("Symbol Registry - Book manager indexes books by id", "[symbol_registry]") {
+            pascal::market_data::FIXOrderBookManager manager;
+            pascal::common::SymbolId id = manager.add_symbol("SOLUSDT");
+            REQUIRE(id != pascal::common::INVALID_SYMBOL_ID);
+            CHECK(manager.get_book(id) == manager.get_book_by_symbol("SOLUSDT"));
+            CHECK(manager.get_book(id)->get_symbol_id() == id);
+            CHECK(manager.get_total_books() == 1);
+
+            //Messages for symbols without a book are dropped
+            pascal::common::MarketDataIncrement update;
+            update.symbol_id = pascal::common::SymbolRegistry::instance().register_symbol("XRPUSDT");
+            update.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = 100, .Quantity = 1}, .update_action = pascal::common::UpdateAction::NEW});
+            update.marketDepth = 1;
+            manager.process_increment(update);
+            CHECK(manager.get_total_updates_processed() == 0);
+            CHECK(manager.get_book_by_symbol("XRPUSDT") == nullptr);
+
+            update.symbol_id = id;
+            manager.process_increment(update);
+            CHECK(manager.get_total_updates_processed() == 1);
+            CHECK(manager.get_book(id)->get_best_bid().Price == 100);
+
+            manager.remove_symbol("SOLUSDT");
+            CHECK(manager.get_book(id) == nullptr);
+            CHECK(manager.get_total_books() == 0);
+        }
+    }
+}
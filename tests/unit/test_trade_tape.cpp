@@ -0,0 +1,168 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_approx.hpp"
+#include "market_data/trade_tape.h"
+#include "common/types.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+
+        class TradeTapeTestFeature {
+        public:
+            pascal::market_data::TradeRecorder recorder;
+            pascal::common::SymbolId id;
+            std::chrono::high_resolution_clock::time_point start{std::chrono::seconds(1000)};
+
+            TradeTapeTestFeature() {
+                id = recorder.add_symbol("TAPEUSDT");
+            }
+
+            pascal::common::Trade trade(pascal::common::Ticks price, pascal::common::Lots qty, pascal::common::AggressorSide aggressor, std::chrono::milliseconds at, uint64_t trade_id = 0) const {
+                return pascal::common::Trade{.symbol_id = id, .priceLevel = {.Price = price, .Quantity = qty}, .aggressor = aggressor, .trade_id = trade_id, .recv_time = start + at};
+            }
+        };
+
+        TEST_CASE("Trade Tape - Readers follow the newest trades", "[trade_tape]") {
+            pascal::market_data::TradeTape tape;
+            std::array<pascal::common::Trade, 8> out;
+            uint64_t last = 0;
+            CHECK(tape.get_last_sequence() == 0);
+            CHECK(tape.read_since(0, out, last) == 0);
+
+            for (uint64_t i = 1; i <= 5; i++) tape.push(pascal::common::Trade{.trade_id = i});
+            CHECK(tape.get_last_sequence() == 5);
+            REQUIRE(tape.read_since(2, out, last) == 3);
+            CHECK(out[0].trade_id == 3);
+            CHECK(out[2].trade_id == 5);
+            CHECK(last == 5);
+
+            std::array<pascal::common::Trade, 2> latest;
+            REQUIRE(tape.read_latest(latest) == 2);
+            CHECK(latest[0].trade_id == 4);
+            CHECK(latest[1].trade_id == 5);
+
+            //A reader lapped by the writer resumes at the oldest trade still on the tape
+            for (uint64_t i = 6; i <= pascal::market_data::TradeTape::CAPACITY + 10; i++) tape.push(pascal::common::Trade{.trade_id = i});
+            REQUIRE(tape.read_since(last, out, last) == out.size());
+            CHECK(out[0].trade_id == 11);
+            CHECK(last == 18);
+        }
+        TEST_CASE("Trade Tape - Concurrent readers never see a torn trade", "[trade_tape]") {
+            pascal::market_data::TradeTape tape;
+            std::atomic<bool> done{false};
+            std::thread writer([&]() {
+                for (uint64_t i = 1; i <= 200000; i++) {
+                    tape.push(pascal::common::Trade{.priceLevel = {.Price = static_cast<pascal::common::Ticks>(i), .Quantity = static_cast<pascal::common::Lots>(i)}, .trade_id = i});
+                }
+                done.store(true);
+            });
+
+            size_t torn = 0;
+            size_t disordered = 0;
+            uint64_t last = 0;
+            uint64_t previous = 0;
+            std::array<pascal::common::Trade, 64> out;
+            while (!done.load() || last < tape.get_last_sequence()) {
+                size_t n = tape.read_since(last, out, last);
+                for (size_t i = 0; i < n; i++) {
+                    if (out[i].priceLevel.Price != out[i].priceLevel.Quantity || out[i].priceLevel.Price != static_cast<pascal::common::Ticks>(out[i].trade_id)) torn++;
+                    if (out[i].trade_id <= previous) disordered++;
+                    previous = out[i].trade_id;
+                }
+            }
+            writer.join();
+
+            CHECK(torn == 0);
+            CHECK(disordered == 0);
+            CHECK(previous == 200000);
+        }
+        TEST_CASE("Trade Tape - Rolling statistics", "[trade_tape]") {
+            TradeTapeTestFeature feature;
+            pascal::market_data::TradeStats stats;
+            CHECK_FALSE(feature.recorder.load_stats(feature.id, stats));
+
+            using namespace std::chrono_literals;
+            feature.recorder.on_trade(feature.trade(1000, 10, pascal::common::AggressorSide::BUYER, 0ms, 1));
+            feature.recorder.on_trade(feature.trade(1010, 30, pascal::common::AggressorSide::SELLER, 200ms, 2));
+            REQUIRE(feature.recorder.load_stats(feature.id, stats, feature.start + 200ms));
+            CHECK(stats.last_sequence == 2);
+            CHECK(stats.last_trade.trade_id == 2);
+            for (const auto& window : stats.windows) {
+                CHECK(window.trades == 2);
+                CHECK(window.volume == 40);
+                CHECK(window.vwap == Catch::Approx((1000.0*10 + 1010.0*30)/40));
+                CHECK(window.imbalance == Catch::Approx(-0.5));
+            }
+
+            //Two seconds on, the first window only holds the new trade
+            feature.recorder.on_trade(feature.trade(1020, 20, pascal::common::AggressorSide::BUYER, 2200ms, 3));
+            REQUIRE(feature.recorder.load_stats(feature.id, stats, feature.start + 2200ms));
+            CHECK(stats.windows[0].trades == 1);
+            CHECK(stats.windows[0].vwap == Catch::Approx(1020.0));
+            CHECK(stats.windows[0].imbalance == Catch::Approx(1.0));
+            CHECK(stats.windows[1].trades == 3);
+            CHECK(stats.windows[1].buy_volume == 30);
+            CHECK(stats.windows[1].sell_volume == 30);
+            CHECK(stats.windows[1].imbalance == Catch::Approx(0.0));
+
+            //Past every window
+            feature.recorder.on_trade(feature.trade(1030, 5, pascal::common::AggressorSide::UNKNOWN_AGGRESSOR, 120s, 4));
+            REQUIRE(feature.recorder.load_stats(feature.id, stats, feature.start + 120s));
+            for (const auto& window : stats.windows) {
+                CHECK(window.trades == 1);
+                CHECK(window.volume == 5);
+                CHECK(window.vwap == Catch::Approx(1030.0));
+                CHECK(window.imbalance == Catch::Approx(0.0));
+            }
+            CHECK(feature.recorder.get_tape(feature.id)->get_last_sequence() == 4);
+            CHECK(feature.recorder.get_total_trades() == 4);
+
+            feature.recorder.on_trade(pascal::common::Trade{.symbol_id = pascal::common::INVALID_SYMBOL_ID});
+            CHECK(feature.recorder.get_dropped_trades() == 1);
+        }
+        TEST_CASE("Trade Tape - Windows drain without new trades", "[trade_tape]") {
+            TradeTapeTestFeature feature;
+            pascal::market_data::TradeStats stats;
+            using namespace std::chrono_literals;
+            feature.recorder.on_trade(feature.trade(1000, 10, pascal::common::AggressorSide::BUYER, 0ms, 1));
+            feature.recorder.on_trade(feature.trade(1010, 30, pascal::common::AggressorSide::SELLER, 5s, 2));
+
+            //The 1s window only holds the second trade, then nothing once it has passed too
+            REQUIRE(feature.recorder.load_stats(feature.id, stats, feature.start + 5500ms));
+            CHECK(stats.windows[0].trades == 1);
+            CHECK(stats.windows[0].vwap == Catch::Approx(1010.0));
+            CHECK(stats.windows[1].trades == 2);
+            REQUIRE(feature.recorder.load_stats(feature.id, stats, feature.start + 7s));
+            CHECK(stats.windows[0].trades == 0);
+            CHECK(stats.windows[0].vwap == 0.0);
+            CHECK(stats.windows[0].imbalance == 0.0);
+            CHECK(stats.windows[1].trades == 2);
+            CHECK(stats.windows[2].trades == 2);
+
+            //The 10s window lets go of the first trade, then of both
+            REQUIRE(feature.recorder.load_stats(feature.id, stats, feature.start + 11s));
+            CHECK(stats.windows[1].trades == 1);
+            CHECK(stats.windows[1].imbalance == Catch::Approx(-1.0));
+            REQUIRE(feature.recorder.load_stats(feature.id, stats, feature.start + 16s));
+            CHECK(stats.windows[1].trades == 0);
+            CHECK(stats.windows[2].trades == 2);
+
+            //Long after the last trade every window is empty, but the last trade is still reported
+            REQUIRE(feature.recorder.load_stats(feature.id, stats));
+            for (const auto& window : stats.windows) CHECK(window.volume == 0);
+            CHECK(stats.last_sequence == 2);
+            CHECK(stats.last_trade.trade_id == 2);
+
+            //A later trade rolls the writer's windows past the drained buckets
+            feature.recorder.on_trade(feature.trade(1020, 20, pascal::common::AggressorSide::BUYER, 30s, 3));
+            REQUIRE(feature.recorder.load_stats(feature.id, stats, feature.start + 30s));
+            CHECK(stats.windows[0].trades == 1);
+            CHECK(stats.windows[1].trades == 1);
+            CHECK(stats.windows[2].trades == 3);
+        }
+    }
+}
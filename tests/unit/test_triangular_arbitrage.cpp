@@ -0,0 +1,232 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_approx.hpp"
+#include "market_data/triangular_arbitrage.h"
+#include "market_data/pipeline.h"
+#include "common/types.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+
+        class TriangularArbitrageTestFeature {
+        public:
+            using ArbitragePipeline = pascal::market_data::Pipeline<pascal::market_data::BookUpdateStage, pascal::market_data::TriangularArbitrageStage>;
+
+            pascal::market_data::FIXOrderBookManager manager;
+            pascal::market_data::TriangularArbitrageDetector detector{manager};
+            ArbitragePipeline pipeline{pascal::market_data::BookUpdateStage(manager), pascal::market_data::TriangularArbitrageStage(detector)};
+            pascal::common::InstrumentSpec usdtSpec = pascal::common::InstrumentSpec::from_increments(0.01, 0.00001);
+            pascal::common::InstrumentSpec btcSpec = pascal::common::InstrumentSpec::from_increments(0.00001, 0.0001);
+            pascal::market_data::CycleId cycle;
+
+            TriangularArbitrageTestFeature() {
+                manager.add_symbol("TRIBTCUSDT", usdtSpec);
+                manager.add_symbol("TRIETHBTC", btcSpec);
+                manager.add_symbol("TRIETHUSDT", usdtSpec);
+                cycle = detector.add_cycle({{
+                    {.symbol = "TRIBTCUSDT", .side = pascal::market_data::LegSide::BUY, .fee = 0.001},
+                    {.symbol = "TRIETHBTC", .side = pascal::market_data::LegSide::BUY, .fee = 0.001},
+                    {.symbol = "TRIETHUSDT", .side = pascal::market_data::LegSide::SELL, .fee = 0.001}
+                }});
+            }
+
+            void quote(const std::string& symbol, const pascal::common::InstrumentSpec& spec, double bid, double bid_size, double ask, double ask_size) {
+                pascal::common::MarketDataSnapshot snapshot;
+                snapshot.symbol_id = pascal::common::SymbolRegistry::instance().find(symbol);
+                snapshot.bids.push_back({.Price = spec.to_ticks(bid), .Quantity = spec.to_lots(bid_size)});
+                snapshot.bids.push_back({.Price = spec.to_ticks(bid) - 10, .Quantity = spec.to_lots(bid_size)});
+                snapshot.asks.push_back({.Price = spec.to_ticks(ask), .Quantity = spec.to_lots(ask_size)});
+                pipeline.on_snapshot(snapshot);
+            }
+            void seed() {
+                quote("TRIBTCUSDT", usdtSpec, 49999, 1.0, 50000, 0.5);
+                quote("TRIETHBTC", btcSpec, 0.04999, 10.0, 0.05, 10.0);
+                quote("TRIETHUSDT", usdtSpec, 2500, 4.0, 2501, 4.0);
+            }
+            std::vector<pascal::market_data::ArbitrageOpportunity> drain() {
+                std::vector<pascal::market_data::ArbitrageOpportunity> found;
+                detector.drain([&found](const pascal::market_data::ArbitrageOpportunity& opportunity) {
+                    found.push_back(opportunity);
+                });
+                return found;
+            }
+        };
+
+        TEST_CASE("Triangular Arbitrage - Cycles priced after fees", "[triangular_arbitrage]") {
+            TriangularArbitrageTestFeature feature;
+            REQUIRE(feature.cycle != pascal::market_data::INVALID_CYCLE_ID);
+            CHECK(feature.detector.get_cycle_count() == 1);
+            CHECK(feature.detector.get_cycle(feature.cycle)[1].symbol == "TRIETHBTC");
+
+            //Fair prices lose the fees
+            feature.seed();
+            CHECK(feature.drain().empty());
+            CHECK(feature.detector.get_evaluations() > 0);
+
+            //ETH bid 1.2% rich against BTCUSDT * ETHBTC
+            pascal::common::MarketDataIncrement update;
+            update.symbol_id = pascal::common::SymbolRegistry::instance().find("TRIETHUSDT");
+            update.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = feature.usdtSpec.to_ticks(2530), .Quantity = feature.usdtSpec.to_lots(4.0)}, .update_action = pascal::common::UpdateAction::NEW});
+            update.marketDepth = 1;
+            feature.pipeline.on_increment(update);
+
+            auto found = feature.drain();
+            REQUIRE(found.size() == 1);
+            const auto& opportunity = found[0];
+            double rate = 0.999 * 0.999 * 0.999 * 2530.0 / 2500.0;
+            CHECK(opportunity.cycle == feature.cycle);
+            CHECK(opportunity.trigger == update.symbol_id);
+            CHECK(opportunity.edge == Catch::Approx(rate - 1.0));
+            CHECK(opportunity.prices[0] == Catch::Approx(50000.0));
+            CHECK(opportunity.prices[1] == Catch::Approx(0.05));
+            CHECK(opportunity.prices[2] == Catch::Approx(2530.0));
+            //The 4 ETH bid is the smallest leg, bought with 4 * 2500 / 0.999^2 USDT
+            CHECK(opportunity.start_quantity == Catch::Approx(4.0 * 2500.0 / (0.999 * 0.999)));
+            CHECK(opportunity.expected_profit == Catch::Approx(opportunity.start_quantity * opportunity.edge));
+            CHECK(feature.detector.get_opportunities() == 1);
+
+            //Updates behind the touch don't reprice anything
+            uint64_t evaluations = feature.detector.get_evaluations();
+            update.md_entries.clear();
+            update.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = feature.usdtSpec.to_ticks(2400), .Quantity = 1}, .update_action = pascal::common::UpdateAction::NEW});
+            update.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = feature.usdtSpec.to_ticks(2300), .Quantity = 1}, .update_action = pascal::common::UpdateAction::NEW});
+            update.marketDepth = 2;
+            feature.pipeline.on_increment(update);
+            CHECK(feature.detector.get_evaluations() == evaluations);
+            CHECK(feature.drain().empty());
+
+            //A stale leg takes its cycles out
+            feature.manager.get_book(update.symbol_id)->mark_unsynchronized();
+            CHECK(feature.detector.on_book_changed(update.symbol_id) == 1);
+            CHECK(feature.drain().empty());
+        }
+        TEST_CASE("Triangular Arbitrage - Only the cycles of the moved symbol are priced", "[triangular_arbitrage]") {
+            TriangularArbitrageTestFeature feature;
+            feature.manager.add_symbol("TRISOLBTC", feature.btcSpec);
+            feature.manager.add_symbol("TRISOLUSDT", feature.usdtSpec);
+            std::vector<pascal::market_data::CycleId> solCycles;
+            for (int i = 0; i < 200; i++) {
+                solCycles.push_back(feature.detector.add_cycle({{
+                    {.symbol = "TRIBTCUSDT", .side = pascal::market_data::LegSide::BUY, .fee = 0.0001 * i},
+                    {.symbol = "TRISOLBTC", .side = pascal::market_data::LegSide::BUY},
+                    {.symbol = "TRISOLUSDT", .side = pascal::market_data::LegSide::SELL}
+                }}));
+            }
+            CHECK(feature.detector.add_cycle({{
+                {.symbol = "TRIBTCUSDT", .side = pascal::market_data::LegSide::BUY},
+                {.symbol = "NOBOOKBTC", .side = pascal::market_data::LegSide::BUY},
+                {.symbol = "TRIETHUSDT", .side = pascal::market_data::LegSide::SELL}
+            }}) == pascal::market_data::INVALID_CYCLE_ID);
+            CHECK(feature.detector.get_cycle_count() == 201);
+
+            feature.seed();
+            feature.quote("TRISOLBTC", feature.btcSpec, 0.00299, 100.0, 0.003, 100.0);
+            CHECK(feature.detector.on_book_changed(pascal::common::SymbolRegistry::instance().find("TRIETHUSDT")) == 0);
+
+            //SOL bid 1% rich, only the cycles whose fees leave an edge fire
+            pascal::common::SymbolId sol = pascal::common::SymbolRegistry::instance().find("TRISOLUSDT");
+            pascal::common::MarketDataSnapshot snapshot;
+            snapshot.symbol_id = sol;
+            snapshot.bids.push_back({.Price = feature.usdtSpec.to_ticks(151.5), .Quantity = feature.usdtSpec.to_lots(100.0)});
+            snapshot.asks.push_back({.Price = feature.usdtSpec.to_ticks(152.0), .Quantity = feature.usdtSpec.to_lots(100.0)});
+            uint64_t evaluations = feature.detector.get_evaluations();
+            feature.pipeline.on_snapshot(snapshot);
+            CHECK(feature.detector.get_evaluations() - evaluations == 200);
+
+            auto found = feature.drain();
+            CHECK(found.size() == 100); //fees below 1%
+            for (const auto& opportunity : found) {
+                CHECK(opportunity.trigger == sol);
+                CHECK(opportunity.cycle >= solCycles.front());
+                CHECK(opportunity.edge > 0.0);
+            }
+        }
+        TEST_CASE("Triangular Arbitrage - One consumer drains every producing thread", "[triangular_arbitrage]") {
+            TriangularArbitrageTestFeature feature;
+            feature.seed();
+
+            //Two processing threads move different legs, each cycle pricing goes to that thread's queue
+            pascal::common::SymbolId eth = pascal::common::SymbolRegistry::instance().find("TRIETHUSDT");
+            pascal::common::SymbolId btc = pascal::common::SymbolRegistry::instance().find("TRIBTCUSDT");
+            std::atomic<bool> done{false};
+            std::vector<std::thread> threads;
+            for (pascal::common::SymbolId id : {eth, btc}) {
+                threads.emplace_back([&feature, id, eth]() {
+                    pascal::common::InstrumentSpec spec = feature.usdtSpec;
+                    double base = id == eth ? 2530.0 : 49000.0;
+                    for (int i = 0; i < 500; i++) {
+                        pascal::common::MarketDataIncrement update;
+                        update.symbol_id = id;
+                        pascal::common::Side side = id == eth ? pascal::common::Side::BID : pascal::common::Side::OFFER;
+                        update.md_entries.push_back({.side = side, .priceLevel = {.Price = spec.to_ticks(base), .Quantity = spec.to_lots(1.0 + i % 2)}, .update_action = pascal::common::UpdateAction::CHANGE});
+                        update.marketDepth = 1;
+                        feature.pipeline.on_increment(update);
+                    }
+                });
+            }
+            size_t drained = 0;
+            std::thread consumer([&]() {
+                while (!done.load()) {
+                    drained += feature.drain().size();
+                }
+            });
+            for (auto& thread : threads) thread.join();
+            done.store(true);
+            consumer.join();
+            drained += feature.drain().size();
+
+            CHECK(feature.detector.get_opportunities() > 0);
+            CHECK(drained + feature.detector.get_dropped_opportunities() == feature.detector.get_opportunities());
+        }
+        TEST_CASE("Triangular Arbitrage - Producer slots go to later threads", "[triangular_arbitrage]") {
+            using pascal::market_data::TriangularArbitrageDetector;
+            TriangularArbitrageTestFeature feature;
+            feature.seed();
+            pascal::common::SymbolId eth = pascal::common::SymbolRegistry::instance().find("TRIETHUSDT");
+            auto move_eth = [&feature, eth](double quantity) {
+                pascal::common::MarketDataIncrement update;
+                update.symbol_id = eth;
+                update.md_entries.push_back({.side = pascal::common::Side::BID, .priceLevel = {.Price = feature.usdtSpec.to_ticks(2530.0), .Quantity = feature.usdtSpec.to_lots(quantity)}, .update_action = pascal::common::UpdateAction::CHANGE});
+                update.marketDepth = 1;
+                feature.pipeline.on_increment(update);
+            };
+
+            //One producing thread at a time, far more of them than slots
+            for (size_t i = 0; i < 4*TriangularArbitrageDetector::MAX_PRODUCERS; i++) {
+                std::thread producer([&, i]() {
+                    move_eth(1.0 + i % 2);
+                });
+                producer.join();
+            }
+            CHECK(feature.drain().size() == 4*TriangularArbitrageDetector::MAX_PRODUCERS);
+            CHECK(feature.detector.get_dropped_opportunities() == 0);
+
+            //With every slot held by a live thread the next producer's opportunity is counted as dropped
+            std::atomic<size_t> holding{0};
+            std::atomic<bool> release{false};
+            std::vector<std::thread> holders;
+            for (size_t i = 0; i < TriangularArbitrageDetector::MAX_PRODUCERS; i++) {
+                holders.emplace_back([&]() {
+                    pascal::common::thread_index();
+                    holding.fetch_add(1);
+                    while (!release.load()) std::this_thread::yield();
+                });
+            }
+            while (holding.load() != TriangularArbitrageDetector::MAX_PRODUCERS) std::this_thread::yield();
+            uint64_t opportunities = feature.detector.get_opportunities();
+            uint64_t evaluations = feature.detector.get_evaluations();
+            std::thread producer([&]() {
+                move_eth(3.0);
+            });
+            producer.join();
+            release.store(true);
+            for (auto& holder : holders) holder.join();
+            CHECK(feature.drain().empty());
+            CHECK(feature.detector.get_opportunities() == opportunities+1);
+            CHECK(feature.detector.get_dropped_opportunities() == 1);
+            CHECK(feature.detector.get_evaluations() > evaluations);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include "catch2/catch_test_macros.hpp"
+#include "common/tsc_clock.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace pascal {
+    namespace test {
+        namespace {
+            int64_t reference_nanos() {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+            }
+        }
+        //Runs in TSC mode on hosts with an invariant TSC and in fallback mode elsewhere, both must hold
+        TEST_CASE("TSC Clock - Tracks the reference clock", "[tsc_clock]") {
+            SECTION("Readings are in the high_resolution_clock domain") {
+                for (int i = 0; i < 10; i++) {
+                    int64_t before = reference_nanos();
+                    int64_t now = pascal::common::TscClock::now_nanos();
+                    int64_t after = reference_nanos();
+                    //Calibration error allowance on top of the bracketing reads
+                    CHECK(now >= before - 2000000);
+                    CHECK(now <= after + 2000000);
+                }
+                auto point = pascal::common::TscClock::now();
+                CHECK(std::chrono::abs(point - std::chrono::high_resolution_clock::now()) < std::chrono::milliseconds(2));
+            }
+            SECTION("Elapsed time matches a sleep") {
+                int64_t start = pascal::common::TscClock::now_nanos();
+                int64_t refStart = reference_nanos();
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                int64_t elapsed = pascal::common::TscClock::now_nanos() - start;
+                int64_t refElapsed = reference_nanos() - refStart;
+                CHECK(elapsed > refElapsed - refElapsed/100 - 100000);
+                CHECK(elapsed < refElapsed + refElapsed/100 + 100000);
+            }
+            SECTION("Recalibration keeps readings monotonic") {
+                std::this_thread::sleep_for(pascal::common::TscClock::CALIBRATION_WINDOW);
+                int64_t last = pascal::common::TscClock::now_nanos();
+                for (int i = 0; i < 100000; i++) {
+                    if (i % 20000 == 0) {
+                        std::this_thread::sleep_for(pascal::common::TscClock::CALIBRATION_WINDOW);
+                        pascal::common::TscClock::recalibrate();
+                    }
+                    int64_t now = pascal::common::TscClock::now_nanos();
+                    REQUIRE(now >= last);
+                    last = now;
+                }
+                if (pascal::common::TscClock::is_tsc()) {
+                    CHECK(pascal::common::TscClock::ticks_per_nano() > 0.1);
+                }
+            }
+            SECTION("Threads read concurrently with recalibration") {
+                std::vector<std::thread> readers;
+                std::atomic<bool> failed{false};
+                for (int t = 0; t < 4; t++) {
+                    readers.emplace_back([&failed]() {
+                        int64_t last = pascal::common::TscClock::now_nanos();
+                        for (int i = 0; i < 200000; i++) {
+                            int64_t now = pascal::common::TscClock::now_nanos();
+                            if (now < last) failed.store(true);
+                            last = now;
+                        }
+                    });
+                }
+                for (int i = 0; i < 5; i++) {
+                    std::this_thread::sleep_for(pascal::common::TscClock::CALIBRATION_WINDOW);
+                    pascal::common::TscClock::recalibrate();
+                }
+                for (auto& reader : readers) reader.join();
+                CHECK(!failed.load());
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#include "catch2/catch_test_macros.hpp"
+#include "common/wait_strategy.h"
+#include "common/lockfree_spsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace pascal {
+    namespace test {
+        TEST_CASE("Wait Strategy - Config names", "[wait_strategy]") {
+            pascal::common::WaitStrategyType type = pascal::common::WaitStrategyType::BUSY_SPIN;
+            CHECK(pascal::common::parse_wait_strategy("SPIN_PARK", type));
+            CHECK(type == pascal::common::WaitStrategyType::SPIN_PARK);
+            CHECK(pascal::common::parse_wait_strategy("PAUSE_SPIN", type));
+            CHECK(type == pascal::common::WaitStrategyType::PAUSE_SPIN);
+            CHECK(!pascal::common::parse_wait_strategy("SLEEP", type));
+            CHECK(type == pascal::common::WaitStrategyType::PAUSE_SPIN);
+        }
+        TEST_CASE("Wait Strategy - Idle accounting", "[wait_strategy]") {
+            auto never = []() { return false; };
+
+            SECTION("Spinning strategies only spin") {
+                pascal::common::WaitStrategy wait({.type = pascal::common::WaitStrategyType::PAUSE_SPIN, .spin_count = 2});
+                for (int i = 0; i < 5; i++) wait.idle(never);
+                wait.on_work();
+                wait.on_work();
+                auto stats = wait.get_stats();
+                CHECK(stats.spins == 5);
+                CHECK(stats.yields == 0);
+                CHECK(stats.wakeups == 1);
+            }
+            SECTION("Spin then yield") {
+                pascal::common::WaitStrategy wait({.type = pascal::common::WaitStrategyType::SPIN_YIELD, .spin_count = 3});
+                for (int i = 0; i < 5; i++) wait.idle(never);
+                wait.on_work();
+                wait.idle(never);
+                auto stats = wait.get_stats();
+                CHECK(stats.spins == 4);
+                CHECK(stats.yields == 2);
+                CHECK(stats.wakeups == 1);
+            }
+            SECTION("Park is skipped when work arrived") {
+                pascal::common::WaitStrategy wait({.type = pascal::common::WaitStrategyType::SPIN_PARK, .spin_count = 0});
+                wait.idle([]() { return true; });
+                CHECK(wait.get_stats().parks == 0);
+                wait.notify();
+                CHECK(wait.get_stats().notifies == 0);
+            }
+        }
+        TEST_CASE("Wait Strategy - Producer wakes a parked consumer", "[wait_strategy]") {
+            //Long park timeout so only the producer notify can deliver the items in time
+            pascal::common::WaitStrategy wait({.type = pascal::common::WaitStrategyType::SPIN_PARK, .spin_count = 100, .park_timeout = std::chrono::seconds(10)});
+            pascal::common::SPSCQueue<int, 64> queue;
+            constexpr int COUNT = 20;
+
+            std::atomic<int> received{0};
+            std::thread consumer([&]() {
+                auto ready = [&queue]() { return !queue.empty(); };
+                while (received.load() < COUNT) {
+                    if (queue.consume_all([&received](int&) { received.fetch_add(1); })) wait.on_work();
+                    else wait.idle(ready);
+                }
+            });
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < COUNT; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                REQUIRE(queue.push(i));
+                wait.notify();
+            }
+            consumer.join();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+
+            auto stats = wait.get_stats();
+            CHECK(received.load() == COUNT);
+            CHECK(elapsed < std::chrono::seconds(5));
+            CHECK(stats.parks > 0);
+            CHECK(stats.notifies > 0);
+            CHECK(stats.wakeups > 0);
+        }
+    }
+}
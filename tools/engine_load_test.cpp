@@ -0,0 +1,136 @@
+#include "net/fix_engine.h"
+#include "market_data/fix_order_book.h"
+#include "market_data/pipeline.h"
+#include "common/latency_histogram.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Drives the engine against pascal_feed_simulator and reports sustained throughput and per stage tail latency:
+//  pascal_load_test <engine config> <private key pem> [--symbols <n>] [--depth <levels>] [--seconds <n>] [--warmup <n>]
+//Subscribes SIM0000..SIM<n-1> into ladder books that resync through the engine on a sequence gap, lets the feed
+//run for the warmup, then measures over --seconds. Any Ed25519 key works against the simulator, e.g.
+//openssl genpkey -algorithm ed25519 -out sim_key.pem
+namespace {
+    //Counts what reached the books, runs after the BookUpdateStage on the engine's workers
+    struct CountingStage {
+        std::atomic<uint64_t>* snapshots;
+        std::atomic<uint64_t>* increments;
+
+        void on_snapshot(pascal::common::MarketDataSnapshot&) {
+            snapshots->fetch_add(1, std::memory_order_relaxed);
+        }
+        void on_increment(const pascal::common::MarketDataIncrement&) {
+            increments->fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+    using LoadTestPipeline = pascal::market_data::Pipeline<pascal::market_data::BookUpdateStage, CountingStage>;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <engine config> <private key pem> [--symbols <n>] [--depth <levels>] [--seconds <n>] [--warmup <n>]" << std::endl;
+        return 1;
+    }
+    int symbolCount = 1;
+    int depth = 100;
+    int seconds = 10;
+    int warmup = 2;
+    for (int i = 3; i < argc; i++) {
+        if (std::strcmp(argv[i], "--symbols") == 0 && i+1 < argc) symbolCount = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--depth") == 0 && i+1 < argc) depth = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i+1 < argc) seconds = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i+1 < argc) warmup = std::atoi(argv[++i]);
+        else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> symbols;
+    for (int i = 0; i < symbolCount; i++) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "SIM%04d", i);
+        symbols.push_back(name);
+    }
+
+    try {
+        //The parser scales to the same grid the books are built on
+        pascal::common::InstrumentSpec spec = pascal::common::InstrumentSpec::from_increments(0.01, 0.00001);
+        pascal::market_data::FIXOrderBookManager manager;
+        for (const auto& symbol : symbols) manager.add_symbol(symbol, spec, pascal::market_data::BookType::LADDER);
+        std::atomic<uint64_t> snapshots{0};
+        std::atomic<uint64_t> increments{0};
+
+        //The workers run decode -> book update -> count as direct calls
+        pascal::net::BasicFIXMarketDataEngine<LoadTestPipeline> engine(argv[1], argv[2], "SIMULATOR", symbols,
+            pascal::market_data::BookUpdateStage(manager), CountingStage{&snapshots, &increments});
+        for (const auto& symbol : symbols) engine.set_instrument_spec(symbol, spec);
+        manager.set_resync_handler([&engine](pascal::common::SymbolId id) {
+            engine.request_snapshot(id);
+        });
+
+        if (!engine.start()) return 1;
+        auto logonDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!engine.is_logged() && std::chrono::steady_clock::now() < logonDeadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (!engine.is_logged()) {
+            std::cerr << "No logon, is pascal_feed_simulator running?" << std::endl;
+            engine.stop();
+            return 1;
+        }
+        for (const auto& symbol : symbols) {
+            pascal::common::MarketDataRequest request;
+            request.Stream = pascal::common::MarketDataSubscriptionType::FULL_BOOK;
+            request.Symbol = symbol;
+            request.MarketDepth = depth;
+            request.MDEntryType = pascal::common::BID;
+            engine.sub_to_symbol(request);
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(warmup));
+        engine.reset_latency_interval();
+        uint64_t startIncrements = increments.load();
+        uint64_t startDropped = engine.get_dropped_messages();
+        auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t measured = increments.load() - startIncrements;
+
+        //Merged over symbols, taken before the unsubscribes so the interval only covers the measured window
+        std::vector<pascal::common::LatencySnapshot> stages(pascal::common::LATENCY_STAGE_COUNT);
+        for (const auto& symbol : symbols) {
+            for (size_t s = 0; s < pascal::common::LATENCY_STAGE_COUNT; s++) {
+                stages[s] += engine.get_latency(symbol, static_cast<pascal::common::LatencyStage>(s));
+            }
+        }
+        for (const auto& symbol : symbols) engine.unsub_to_symbol(symbol);
+        engine.stop();
+
+        std::cout << "symbols      " << symbolCount << " (" << snapshots.load() << " snapshots)" << std::endl;
+        std::cout << "increments   " << measured << " in " << elapsed << " s, " << static_cast<double>(measured)/elapsed << " msg/s" << std::endl;
+        size_t synchronized = 0;
+        for (const auto& symbol : symbols) synchronized += manager.get_book_by_symbol(symbol)->is_synchronized();
+        std::cout << "dropped      " << engine.get_dropped_messages() - startDropped << std::endl;
+        std::cout << "gaps         " << manager.get_total_sequence_gaps() << " (" << synchronized << "/" << symbolCount << " books synchronized)" << std::endl;
+        for (size_t s = 0; s < pascal::common::LATENCY_STAGE_COUNT; s++) {
+            const pascal::common::LatencySnapshot& latency = stages[s];
+            std::printf("%-12s p50 %8llu  p99 %8llu  p99.9 %8llu  max %8llu ns\n", pascal::common::latency_stage_name(static_cast<pascal::common::LatencyStage>(s)),
+                static_cast<unsigned long long>(latency.percentile(50.0)), static_cast<unsigned long long>(latency.percentile(99.0)),
+                static_cast<unsigned long long>(latency.percentile(99.9)), static_cast<unsigned long long>(latency.max()));
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
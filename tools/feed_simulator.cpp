@@ -0,0 +1,308 @@
+#include "market_data/synthetic_feed.h"
+#include "common/symbol_registry.h"
+#include "common/tsc_clock.h"
+#include "quickfix/Application.h"
+#include "quickfix/FileLog.h"
+#include "quickfix/FileStore.h"
+#include "quickfix/Mutex.h"
+#include "quickfix/Session.h"
+#include "quickfix/SessionSettings.h"
+#include "quickfix/SocketAcceptor.h"
+#include "quickfix/Values.h"
+#include "quickfix/fix44/MarketDataIncrementalRefresh.h"
+#include "quickfix/fix44/MarketDataRequest.h"
+#include "quickfix/fix44/MarketDataSnapshotFullRefresh.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Local stand-in for the exchange's FIX market data endpoint, for end to end runs of the engine and load tests:
+//  pascal_feed_simulator <acceptor config> [--rate <msg/s per symbol>] [--depth <levels>] [--entries <per message, at least 2>]
+//                        [--profile geometric|uniform] [--tick <price>] [--lot <qty>] [--seconds <n>] [--gap-every <n>]
+//Accepts any logon carrying a Username (553) and signature (96), answers a subscribing MarketDataRequest with a
+//snapshot of the configured depth and then streams increments for that symbol at the configured rate until it
+//is unsubscribed or the session drops. Messages carry book update ids like the venue's (25043/25044), --gap-every
+//skips sending one increment in every n to exercise gap recovery. Prints the sent message rate once a second.
+namespace {
+    struct SimulatorOptions {
+        double rate = 1000.0;
+        int depth = 100;
+        size_t entries = 2; //a single entry would read as a top of book update (marketDepth 1)
+        pascal::market_data::DepthProfile profile = pascal::market_data::DepthProfile::GEOMETRIC;
+        double tick = 0.01;
+        double lot = 0.00001;
+        int seconds = 0; //0 runs until interrupted
+        uint64_t gap_every = 0; //0 never skips an increment
+    };
+
+    std::atomic<bool> interrupted{false};
+
+    constexpr int FIRST_BOOK_UPDATE_ID = 25043;
+    constexpr int LAST_BOOK_UPDATE_ID = 25044;
+
+    class FeedSimulator : public FIX::Application {
+    public:
+        explicit FeedSimulator(const SimulatorOptions& options) : options(options) {}
+
+        void onCreate(const FIX::SessionID& ) override {}
+        void onLogon(const FIX::SessionID& sessionID) override {
+            std::cout << "Logon " << sessionID.toString() << std::endl;
+        }
+        void onLogout(const FIX::SessionID& sessionID) override {
+            std::cout << "Logout " << sessionID.toString() << std::endl;
+            FIX::Locker lock(command_mtx);
+            commands.push_back({Command::DROP_SESSION, sessionID, "", ""});
+        }
+        void toAdmin(FIX::Message& , const FIX::SessionID& ) override {}
+        void toApp(FIX::Message& , const FIX::SessionID& ) override {}
+        void fromAdmin(const FIX::Message& message, const FIX::SessionID& ) override {
+            FIX::MsgType msgType;
+            message.getHeader().getField(msgType);
+            //The signature can't be checked without the client's public key, only its presence is
+            if (msgType == FIX::MsgType_Logon && (!message.isSetField(FIX::FIELD::Username) || !message.isSetField(FIX::FIELD::RawData))) {
+                throw FIX::RejectLogon("Logon must carry Username and a signature in RawData");
+            }
+        }
+        void fromApp(const FIX::Message& message, const FIX::SessionID& sessionID) override {
+            FIX::MsgType msgType;
+            message.getHeader().getField(msgType);
+            if (msgType != FIX::MsgType_MarketDataRequest) return;
+
+            FIX::MDReqID reqID;
+            FIX::SubscriptionRequestType type;
+            message.getField(reqID);
+            message.getField(type);
+            FIX::Locker lock(command_mtx);
+            if (type.getValue() == FIX::SubscriptionRequestType_DISABLE_PREVIOUS_SNAPSHOT_PLUS_UPDATE_REQUEST) {
+                commands.push_back({Command::UNSUBSCRIBE, sessionID, reqID.getValue(), ""});
+                return;
+            }
+            //The engine sets Symbol on the message itself, a standard client lists it in NoRelatedSym
+            if (message.isSetField(FIX::FIELD::Symbol)) {
+                commands.push_back({Command::SUBSCRIBE, sessionID, reqID.getValue(), message.getField(FIX::FIELD::Symbol)});
+                return;
+            }
+            FIX44::MarketDataRequest::NoRelatedSym group;
+            FIX::Symbol symbol;
+            for (int i = 1; message.hasGroup(i, group); i++) {
+                message.getGroup(i, group);
+                group.get(symbol);
+                commands.push_back({Command::SUBSCRIBE, sessionID, reqID.getValue(), symbol.getValue()});
+            }
+        }
+
+        //Generator loop, owns every stream so the synthetic books never need a lock
+        void run(const std::atomic<bool>& running) {
+            const int64_t start = pascal::common::TscClock::now_nanos();
+            int64_t reportAt = start + 1000000000;
+            uint64_t reported = 0;
+            while (running.load(std::memory_order_acquire)) {
+                apply_commands();
+                int64_t now = pascal::common::TscClock::now_nanos();
+                bool busy = false;
+                for (auto& stream : streams) {
+                    uint64_t due = static_cast<uint64_t>(static_cast<double>(now - stream->started)*options.rate/1e9);
+                    //Bounded burst so one lagging stream can't hold back the rest
+                    for (int burst = 0; stream->sent < due && burst < 64; burst++) {
+                        send_increment(*stream);
+                        busy = true;
+                    }
+                }
+                if (now >= reportAt) {
+                    std::cout << "sent " << sent - reported << " msg/s over " << streams.size() << " streams" << std::endl;
+                    reported = sent;
+                    reportAt += 1000000000;
+                }
+                if (!busy) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        uint64_t get_sent() const {
+            return sent;
+        }
+
+    private:
+        struct Command {
+            enum Type { SUBSCRIBE, UNSUBSCRIBE, DROP_SESSION } type;
+            FIX::SessionID sessionID;
+            std::string reqID;
+            std::string symbol;
+        };
+        //Outlives subscriptions so a resubscribe continues the book and its update ids, as the venue does
+        struct SymbolBook {
+            pascal::market_data::SyntheticFeed feed;
+            uint64_t update_id = 1000;
+        };
+        struct Stream {
+            FIX::SessionID sessionID;
+            std::string reqID;
+            std::string symbol;
+            SymbolBook* book;
+            int64_t started;
+            uint64_t sent = 0;
+        };
+
+        SimulatorOptions options;
+        FIX::Mutex command_mtx;
+        std::vector<Command> commands; //from the session threads, drained by the generator
+        std::vector<std::unique_ptr<Stream>> streams;
+        std::map<std::string, std::unique_ptr<SymbolBook>> books; //by session and symbol
+        pascal::common::MarketDataIncrement update;
+        uint64_t sent = 0;
+
+        void apply_commands() {
+            std::vector<Command> pending;
+            {
+                FIX::Locker lock(command_mtx);
+                pending.swap(commands);
+            }
+            for (const Command& command : pending) {
+                if (command.type == Command::SUBSCRIBE) {
+                    std::unique_ptr<SymbolBook>& book = books[command.sessionID.toString() + "|" + command.symbol];
+                    if (!book) {
+                        //Seed and mid from the symbol so every run sees the same market
+                        uint32_t seed = static_cast<uint32_t>(std::hash<std::string>{}(command.symbol));
+                        int64_t mid = 1000000 + static_cast<int64_t>(seed % 1000000);
+                        book = std::make_unique<SymbolBook>(SymbolBook{pascal::market_data::SyntheticFeed(pascal::common::INVALID_SYMBOL_ID, mid, options.depth, options.profile, seed)});
+                    }
+                    auto stream = std::make_unique<Stream>(Stream{command.sessionID, command.reqID, command.symbol, book.get(), pascal::common::TscClock::now_nanos()});
+                    if (send_snapshot(*stream)) streams.push_back(std::move(stream));
+                }
+                else {
+                    std::erase_if(streams, [&command](const std::unique_ptr<Stream>& stream) {
+                        return stream->sessionID == command.sessionID && (command.type == Command::DROP_SESSION || stream->reqID == command.reqID);
+                    });
+                    //A new logon starts from a fresh book
+                    if (command.type == Command::DROP_SESSION) {
+                        std::string prefix = command.sessionID.toString() + "|";
+                        std::erase_if(books, [&prefix](const auto& entry) {
+                            return entry.first.compare(0, prefix.size(), prefix) == 0;
+                        });
+                    }
+                }
+            }
+        }
+        bool send_snapshot(Stream& stream) {
+            pascal::common::MarketDataSnapshot snapshot = stream.book->feed.snapshot();
+            FIX44::MarketDataSnapshotFullRefresh message;
+            message.setField(FIX::MDReqID(stream.reqID));
+            message.setField(FIX::Symbol(stream.symbol));
+            message.setField(FIX::StringField(LAST_BOOK_UPDATE_ID, std::to_string(stream.book->update_id)));
+            FIX44::MarketDataSnapshotFullRefresh::NoMDEntries group;
+            auto add = [this, &message, &group](char type, const pascal::common::PriceLevel& level) {
+                group.set(FIX::MDEntryType(type));
+                group.set(FIX::MDEntryPx(static_cast<double>(level.Price)*options.tick));
+                group.set(FIX::MDEntrySize(static_cast<double>(level.Quantity)*options.lot));
+                message.addGroup(group);
+            };
+            for (const auto& level : snapshot.bids) add(FIX::MDEntryType_BID, level);
+            for (const auto& level : snapshot.asks) add(FIX::MDEntryType_OFFER, level);
+            return send(message, stream.sessionID);
+        }
+        void send_increment(Stream& stream) {
+            stream.book->feed.next_increment(update, options.entries);
+            stream.book->update_id++;
+            stream.sent++;
+            sent++;
+            if (options.gap_every && stream.sent % options.gap_every == 0) return;
+
+            FIX44::MarketDataIncrementalRefresh message;
+            message.setField(FIX::MDReqID(stream.reqID));
+            //Top level as well as per entry, the engine routes on the message's Symbol
+            message.setField(FIX::Symbol(stream.symbol));
+            message.setField(FIX::StringField(FIRST_BOOK_UPDATE_ID, std::to_string(stream.book->update_id)));
+            message.setField(FIX::StringField(LAST_BOOK_UPDATE_ID, std::to_string(stream.book->update_id)));
+            FIX44::MarketDataIncrementalRefresh::NoMDEntries group;
+            for (const auto& md : update.md_entries) {
+                group.set(FIX::MDUpdateAction(static_cast<char>(md.update_action)));
+                group.set(FIX::MDEntryType(md.side == pascal::common::Side::BID ? FIX::MDEntryType_BID : FIX::MDEntryType_OFFER));
+                group.set(FIX::Symbol(stream.symbol));
+                group.set(FIX::MDEntryPx(static_cast<double>(md.priceLevel.Price)*options.tick));
+                group.set(FIX::MDEntrySize(static_cast<double>(md.priceLevel.Quantity)*options.lot));
+                message.addGroup(group);
+            }
+            //Counted even when the session is gone, the stream is dropped with the logout
+            send(message, stream.sessionID);
+        }
+        bool send(FIX::Message& message, const FIX::SessionID& sessionID) {
+            try {
+                return FIX::Session::sendToTarget(message, sessionID);
+            }
+            catch (FIX::SessionNotFound&) {
+                return false;
+            }
+        }
+    };
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <acceptor config> [--rate <msg/s per symbol>] [--depth <levels>] [--entries <per message, at least 2>]"
+                  << " [--profile geometric|uniform] [--tick <price>] [--lot <qty>] [--seconds <n>] [--gap-every <n>]" << std::endl;
+        return 1;
+    }
+    SimulatorOptions options;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--rate") == 0 && i+1 < argc) options.rate = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--depth") == 0 && i+1 < argc) options.depth = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--entries") == 0 && i+1 < argc) options.entries = static_cast<size_t>(std::max(2, std::atoi(argv[++i])));
+        else if (std::strcmp(argv[i], "--tick") == 0 && i+1 < argc) options.tick = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--lot") == 0 && i+1 < argc) options.lot = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i+1 < argc) options.seconds = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--gap-every") == 0 && i+1 < argc) options.gap_every = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--profile") == 0 && i+1 < argc) {
+            std::string profile = argv[++i];
+            if (profile == "geometric") options.profile = pascal::market_data::DepthProfile::GEOMETRIC;
+            else if (profile == "uniform") options.profile = pascal::market_data::DepthProfile::UNIFORM;
+            else {
+                std::cerr << "Unknown profile " << profile << std::endl;
+                return 1;
+            }
+        }
+        else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        FIX::SessionSettings settings(argv[1]);
+        FIX::FileStoreFactory storeFactory(settings);
+        FIX::FileLogFactory logFactory(settings);
+        FeedSimulator simulator(options);
+        FIX::SocketAcceptor acceptor(simulator, storeFactory, settings, logFactory);
+
+        std::signal(SIGINT, [](int) { interrupted.store(true); });
+        std::signal(SIGTERM, [](int) { interrupted.store(true); });
+        std::atomic<bool> running{true};
+        acceptor.start();
+        std::thread generator([&simulator, &running]() {
+            simulator.run(running);
+        });
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(options.seconds);
+        while (!interrupted.load() && (options.seconds == 0 || std::chrono::steady_clock::now() < deadline)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        running.store(false, std::memory_order_release);
+        generator.join();
+        acceptor.stop();
+        std::cout << "sent " << simulator.get_sent() << " increments" << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
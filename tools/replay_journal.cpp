@@ -0,0 +1,50 @@
+#include "net/journal_replay.h"
+#include "net/fix_parser.h"
+#include "market_data/pipeline.h"
+#include "market_data/fix_order_book.h"
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+
+//Replays a capture journal through the parser and a book manager and prints throughput and latency:
+//  pascal_replay <journal> [--paced] [--speed <x>] [--ladder]
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <journal> [--paced] [--speed <x>] [--ladder]" << std::endl;
+        return 1;
+    }
+    pascal::net::ReplayOptions options;
+    pascal::market_data::BookType bookType = pascal::market_data::BookType::VECTOR;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--paced") == 0) options.paced = true;
+        else if (std::strcmp(argv[i], "--speed") == 0 && i+1 < argc) options.speed = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--ladder") == 0) bookType = pascal::market_data::BookType::LADDER;
+        else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        pascal::net::MessageJournalReader journal(argv[1]);
+        pascal::market_data::FIXOrderBookManager manager;
+        for (const auto& symbol : pascal::net::journal_symbols(journal)) manager.add_symbol(symbol, {}, bookType);
+
+        using ReplayPipeline = pascal::market_data::Pipeline<pascal::market_data::BookUpdateStage>;
+        pascal::market_data::BasicFIXMarketDataParser<ReplayPipeline> parser{pascal::market_data::BookUpdateStage(manager)};
+        pascal::net::ReplayReport report = pascal::net::replay_journal(journal, parser, options);
+
+        std::cout << "messages     " << report.messages << " (" << parser.get_messages_processed() << " market data)" << std::endl;
+        std::cout << "elapsed      " << static_cast<double>(report.elapsed.count())/1e9 << " s" << std::endl;
+        std::cout << "throughput   " << report.messages_per_second() << " msg/s, " << report.megabytes_per_second() << " MB/s" << std::endl;
+        std::cout << "latency ns   p50 " << report.latency.percentile(50.0) << "  p99 " << report.latency.percentile(99.0)
+                  << "  p99.9 " << report.latency.percentile(99.9) << "  max " << report.latency.max() << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}